@@ -15,6 +15,7 @@
 #include "core/core_timing.h"
 #include "core/hle/kernel/vm_manager.h"
 #include "core/hle/service/dsp_dsp.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
@@ -49,7 +50,22 @@ void AddAddressSpace(Kernel::VMManager& address_space) {
     address_space.Reprotect(r1_vma, Kernel::VMAPermission::ReadWrite);
 }
 
+/// Capture in progress, kept across calls to SelectSink which don't change the engine or the file
+static std::string capture_sink_id;
+static std::string capture_file;
+
 void SelectSink(std::string sink_id) {
+    // Settings::Apply selects the sink again on any settings change. Recreating a capture sink
+    // would start the file over, so it is only replaced when the engine or the file changes.
+    if (!capture_sink_id.empty()) {
+        if (sink_id == capture_sink_id && Settings::values.audio_output_file == capture_file)
+            return;
+
+        // Closes the capture before a new sink may open the same file
+        DSP::HLE::SetSink(std::make_unique<NullSink>());
+        capture_sink_id.clear();
+    }
+
     if (sink_id == "auto") {
         // Auto-select.
         // g_sink_details is ordered in terms of desirability, with the best choice at the front.
@@ -69,12 +85,21 @@ void SelectSink(std::string sink_id) {
     }
 
     DSP::HLE::SetSink(iter->factory());
+
+    if (iter->writes_file) {
+        capture_sink_id = sink_id;
+        capture_file = Settings::values.audio_output_file;
+    }
 }
 
 void EnableStretching(bool enable) {
     DSP::HLE::EnableStretching(enable);
 }
 
+void EnableMultithreading(bool enable) {
+    DSP::HLE::EnableMultithreading(enable);
+}
+
 void Shutdown() {
     CoreTiming::UnscheduleEvent(tick_event, 0);
     DSP::HLE::Shutdown();
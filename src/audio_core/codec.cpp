@@ -2,12 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <vector>
 
 #include "audio_core/codec.h"
+#include "audio_core/sample_kernels.h"
 
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -16,6 +18,16 @@
 namespace Codec {
 
 StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count, const std::array<s16, 16>& adpcm_coeff, ADPCMState& state) {
+    // Samples are decoded in pairs, so an odd sample count decodes the following nibble too.
+    const size_t ret_size = sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
+    StereoBuffer16 ret(ret_size);
+
+    DecodeADPCM(data, 0, ret_size, adpcm_coeff, state, ret.data());
+
+    return ret;
+}
+
+void DecodeADPCM(const u8* const data, const size_t first_sample, const size_t sample_count, const std::array<s16, 16>& adpcm_coeff, ADPCMState& state, std::array<s16, 2>* dest) {
     // GC-ADPCM with scale factor and variable coefficients.
     // Frames are 8 bytes long containing 14 samples each.
     // Samples are 4 bits (one nibble) long.
@@ -24,15 +36,16 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count, cons
     constexpr size_t SAMPLES_PER_FRAME = 14;
     constexpr std::array<int, 16> SIGNED_NIBBLES {{ 0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1 }};
 
-    const size_t ret_size = sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
-    StereoBuffer16 ret(ret_size);
-
     int yn1 = state.yn1,
         yn2 = state.yn2;
 
-    const size_t NUM_FRAMES = (sample_count + (SAMPLES_PER_FRAME - 1)) / SAMPLES_PER_FRAME; // Round up.
-    for (size_t framei = 0; framei < NUM_FRAMES; framei++) {
-        const int frame_header = data[framei * FRAME_LEN];
+    size_t samplei = first_sample;
+    const size_t end = first_sample + sample_count;
+    while (samplei < end) {
+        const size_t framei = samplei / SAMPLES_PER_FRAME;
+        const u8* const frame = data + framei * FRAME_LEN;
+
+        const int frame_header = frame[0];
         const int scale = 1 << (frame_header & 0xF);
         const int idx = (frame_header >> 4) & 0x7;
 
@@ -40,8 +53,13 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count, cons
         const int coef1 = adpcm_coeff[idx * 2 + 0];
         const int coef2 = adpcm_coeff[idx * 2 + 1];
 
-        // Decodes an audio sample. One nibble produces one sample.
-        const auto decode_sample = [&](const int nibble) -> s16 {
+        const size_t frame_end = std::min(end, (framei + 1) * SAMPLES_PER_FRAME);
+        for (; samplei < frame_end; samplei++) {
+            // Each byte after the header holds two samples, the first one in the upper nibble.
+            const size_t framepos = samplei - framei * SAMPLES_PER_FRAME;
+            const u8 byte = frame[1 + framepos / 2];
+            const int nibble = SIGNED_NIBBLES[framepos % 2 == 0 ? byte >> 4 : byte & 0xF];
+
             const int xn = nibble * scale;
             // We first transform everything into 11 bit fixed point, perform the second order digital filter, then transform back.
             // 0x400 == 0.5 in 11 bit fixed point.
@@ -52,71 +70,54 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count, cons
             // Advance output feedback.
             yn2 = yn1;
             yn1 = val;
-            return (s16)val;
-        };
-
-        size_t outputi = framei * SAMPLES_PER_FRAME;
-        size_t datai = framei * FRAME_LEN + 1;
-        for (size_t i = 0; i < SAMPLES_PER_FRAME && outputi < sample_count; i += 2) {
-            const s16 sample1 = decode_sample(SIGNED_NIBBLES[data[datai] >> 4]);
-            ret[outputi].fill(sample1);
-            outputi++;
-
-            const s16 sample2 = decode_sample(SIGNED_NIBBLES[data[datai] & 0xF]);
-            ret[outputi].fill(sample2);
-            outputi++;
 
-            datai++;
+            (dest++)->fill(static_cast<s16>(val));
         }
     }
 
     state.yn1 = yn1;
     state.yn2 = yn2;
-
-    return ret;
 }
 
-static s16 SignExtendS8(u8 x) {
-    // The data is actually signed PCM8.
-    // We sign extend this to signed PCM16.
-    return static_cast<s16>(static_cast<s8>(x));
+StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data, const size_t sample_count) {
+    StereoBuffer16 ret(sample_count);
+
+    DecodePCM8(num_channels, data, 0, sample_count, ret.data());
+
+    return ret;
 }
 
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data, const size_t sample_count) {
+void DecodePCM8(const unsigned num_channels, const u8* const data, const size_t first_sample, const size_t sample_count, std::array<s16, 2>* dest) {
     ASSERT(num_channels == 1 || num_channels == 2);
 
-    StereoBuffer16 ret(sample_count);
+    const u8* const src = data + first_sample * num_channels;
 
+    // The data is actually signed PCM8. We sign extend this to signed PCM16.
     if (num_channels == 1) {
-        for (size_t i = 0; i < sample_count; i++) {
-            ret[i].fill(SignExtendS8(data[i]));
-        }
+        AudioCore::GetSampleKernels().pcm8_mono(&dest[0][0], src, sample_count);
     } else {
-        for (size_t i = 0; i < sample_count; i++) {
-            ret[i][0] = SignExtendS8(data[i * 2 + 0]);
-            ret[i][1] = SignExtendS8(data[i * 2 + 1]);
-        }
+        AudioCore::GetSampleKernels().pcm8_stereo(&dest[0][0], src, sample_count);
     }
+}
+
+StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data, const size_t sample_count) {
+    StereoBuffer16 ret(sample_count);
+
+    DecodePCM16(num_channels, data, 0, sample_count, ret.data());
 
     return ret;
 }
 
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data, const size_t sample_count) {
+void DecodePCM16(const unsigned num_channels, const u8* const data, const size_t first_sample, const size_t sample_count, std::array<s16, 2>* dest) {
     ASSERT(num_channels == 1 || num_channels == 2);
 
-    StereoBuffer16 ret(sample_count);
+    const u8* const src = data + first_sample * num_channels * sizeof(s16);
 
     if (num_channels == 1) {
-        for (size_t i = 0; i < sample_count; i++) {
-            s16 sample;
-            std::memcpy(&sample, data + i * sizeof(s16), sizeof(s16));
-            ret[i].fill(sample);
-        }
+        AudioCore::GetSampleKernels().pcm16_mono(&dest[0][0], src, sample_count);
     } else {
-        std::memcpy(ret.data(), data, sample_count * 2 * sizeof(u16));
+        std::memcpy(dest, src, sample_count * 2 * sizeof(u16));
     }
-
-    return ret;
 }
 
 };
@@ -31,6 +31,18 @@ struct ADPCMState {
  */
 StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count, const std::array<s16, 16>& adpcm_coeff, ADPCMState& state);
 
+/**
+ * Decodes part of an ADPCM buffer, for decoding it incrementally.
+ * @param data Pointer to buffer that contains ADPCM data to decode
+ * @param first_sample Index of the first sample to decode. As state carries the decoding history,
+ *                     this must be where the previous call stopped (or 0 for a new buffer).
+ * @param sample_count Number of samples to decode
+ * @param adpcm_coeff ADPCM coefficients
+ * @param state ADPCM state, this is updated with new state
+ * @param dest Destination of the decoded stereo signed PCM16 data, sample_count in length
+ */
+void DecodeADPCM(const u8* const data, const size_t first_sample, const size_t sample_count, const std::array<s16, 16>& adpcm_coeff, ADPCMState& state, std::array<s16, 2>* dest);
+
 /**
  * @param num_channels Number of channels
  * @param data Pointer to buffer that contains PCM8 data to decode
@@ -39,6 +51,16 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count, cons
  */
 StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data, const size_t sample_count);
 
+/**
+ * Decodes part of a PCM8 buffer.
+ * @param num_channels Number of channels
+ * @param data Pointer to buffer that contains PCM8 data to decode
+ * @param first_sample Index of the first sample to decode
+ * @param sample_count Number of samples to decode
+ * @param dest Destination of the decoded stereo signed PCM16 data, sample_count in length
+ */
+void DecodePCM8(const unsigned num_channels, const u8* const data, const size_t first_sample, const size_t sample_count, std::array<s16, 2>* dest);
+
 /**
  * @param num_channels Number of channels
  * @param data Pointer to buffer that contains PCM16 data to decode
@@ -47,4 +69,14 @@ StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data, con
  */
 StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data, const size_t sample_count);
 
+/**
+ * Decodes part of a PCM16 buffer.
+ * @param num_channels Number of channels
+ * @param data Pointer to buffer that contains PCM16 data to decode
+ * @param first_sample Index of the first sample to decode
+ * @param sample_count Number of samples to decode
+ * @param dest Destination of the decoded stereo signed PCM16 data, sample_count in length
+ */
+void DecodePCM16(const unsigned num_channels, const u8* const data, const size_t first_sample, const size_t sample_count, std::array<s16, 2>* dest);
+
 };
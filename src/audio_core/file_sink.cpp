@@ -0,0 +1,135 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "audio_core/audio_core.h"
+#include "audio_core/file_sink.h"
+
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+
+namespace AudioCore {
+
+namespace {
+
+struct WavHeader {
+    char riff_id[4];
+    u32_le riff_size;
+    char wave_id[4];
+
+    char fmt_id[4];
+    u32_le fmt_size;
+    u16_le format_tag;
+    u16_le channels;
+    u32_le sample_rate;
+    u32_le byte_rate;
+    u16_le block_align;
+    u16_le bits_per_sample;
+
+    char data_id[4];
+    u32_le data_size;
+};
+static_assert(sizeof(WavHeader) == 44, "WavHeader has incorrect size");
+
+constexpr u16 num_channels = 2;
+constexpr u16 bytes_per_sample = num_channels * sizeof(s16);
+
+} // anonymous namespace
+
+FileSink::FileSink(Format format_, const std::string& path)
+    : format(format_), filename(path.empty() ? DefaultPath(format_) : path) {}
+
+FileSink::~FileSink() {
+    if (!file.IsOpen())
+        return;
+
+    if (format == Format::Wav && file.Seek(0, SEEK_SET))
+        WriteWavHeader();
+
+    if (!file.IsGood())
+        LOG_ERROR(Audio_Sink, "Failed to write the audio capture, it is incomplete");
+}
+
+std::string FileSink::DefaultPath(Format format) {
+    return FileUtil::GetUserPath(D_DUMPAUDIO_IDX) + (format == Format::Wav ? "audio.wav" : "audio.raw");
+}
+
+unsigned int FileSink::GetNativeSampleRate() const {
+    return native_sample_rate;
+}
+
+void FileSink::EnqueueSamples(const s16* samples, size_t sample_count) {
+    if (!file.IsOpen() && !Open())
+        return;
+
+    // Samples are stored in host order, which WAV files expect to be little-endian
+    file.WriteArray(samples, sample_count * num_channels);
+    samples_written += sample_count;
+}
+
+size_t FileSink::SamplesInQueue() const {
+    return 0;
+}
+
+bool FileSink::IsOffline() const {
+    return true;
+}
+
+void FileSink::SetDevice(int device_id) {}
+
+std::vector<std::string>* FileSink::GetDeviceMap() {
+    return nullptr;
+}
+
+bool FileSink::Open() {
+    if (open_failed)
+        return false;
+
+    FileUtil::CreateFullPath(filename);
+    if (!file.Open(filename, "wb")) {
+        LOG_CRITICAL(Audio_Sink, "Could not open \"%s\" for writing", filename.c_str());
+        open_failed = true;
+        return false;
+    }
+    LOG_INFO(Audio_Sink, "Capturing audio to \"%s\"", filename.c_str());
+
+    // Reserve room for the header, which is completed once the length of the capture is known
+    if (format == Format::Wav)
+        WriteWavHeader();
+    return true;
+}
+
+void FileSink::WriteWavHeader() {
+    // Sizes saturate for captures over 4 GiB, which most readers then treat as unknown
+    const u64 max_data_size = 0xFFFFFFFFull - (sizeof(WavHeader) - 8);
+    const u32 data_size = static_cast<u32>(std::min(samples_written * bytes_per_sample, max_data_size));
+
+    WavHeader header;
+    std::memcpy(header.riff_id, "RIFF", 4);
+    header.riff_size = static_cast<u32>(sizeof(WavHeader) - 8 + data_size);
+    std::memcpy(header.wave_id, "WAVE", 4);
+
+    std::memcpy(header.fmt_id, "fmt ", 4);
+    header.fmt_size = 16;
+    header.format_tag = 1; // PCM
+    header.channels = num_channels;
+    header.sample_rate = native_sample_rate;
+    header.byte_rate = native_sample_rate * bytes_per_sample;
+    header.block_align = bytes_per_sample;
+    header.bits_per_sample = 16;
+
+    std::memcpy(header.data_id, "data", 4);
+    header.data_size = data_size;
+
+    file.WriteObject(header);
+}
+
+} // namespace AudioCore
@@ -0,0 +1,61 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "audio_core/sink.h"
+
+#include "common/file_util.h"
+
+namespace AudioCore {
+
+/**
+ * Sink writing the samples it is fed to a file instead of playing them. The DSP feeds it at emulated
+ * speed, so the file holds exactly the generated audio, which makes it suitable for headless
+ * benchmarks and regression tests. The file is only created, or truncated, once the first samples
+ * arrive, so sinks which are merely constructed, e.g. to list devices, leave it alone.
+ */
+class FileSink final : public Sink {
+public:
+    enum class Format {
+        Wav, ///< 16-bit stereo RIFF WAVE at the native sample rate
+        Raw, ///< Headerless interleaved stereo PCM16
+    };
+
+    FileSink(Format format_, const std::string& path);
+    ~FileSink() override;
+
+    /// Default path of captures when none is configured, in the audio dump directory
+    static std::string DefaultPath(Format format);
+
+    unsigned int GetNativeSampleRate() const override;
+
+    void EnqueueSamples(const s16* samples, size_t sample_count) override;
+
+    size_t SamplesInQueue() const override;
+
+    bool IsOffline() const override;
+
+    void SetDevice(int device_id) override;
+    std::vector<std::string>* GetDeviceMap() override;
+
+private:
+    /// Creates the file on first use, returning whether it is open
+    bool Open();
+
+    /// Writes the WAV header for the samples written so far at the start of the file
+    void WriteWavHeader();
+
+    Format format;
+    std::string filename;
+    FileUtil::IOFile file;
+    bool open_failed = false;
+    u64 samples_written = 0;
+};
+
+} // namespace AudioCore
@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <memory>
 
 #include "audio_core/hle/dsp.h"
@@ -12,6 +14,8 @@
 #include "audio_core/sink.h"
 #include "audio_core/time_stretch.h"
 
+#include "common/thread_pool.h"
+
 namespace DSP {
 namespace HLE {
 
@@ -54,15 +58,51 @@ static std::array<Source, num_sources> sources = {
 };
 static Mixers mixers;
 
+/// Workers generating source frames, or nullptr when sources are generated on the calling thread
+static std::unique_ptr<Common::ThreadPool> source_thread_pool;
+static std::atomic<bool> multithreading_requested{false};
+
+/// Source frames are short, so a few threads are enough and more would only add wakeup latency
+static constexpr size_t max_source_workers = 3;
+
+/// Creates or destroys the worker pool on the emulation thread, as requested by EnableMultithreading
+static void UpdateSourceThreadPool() {
+    const bool enable = multithreading_requested.load(std::memory_order_relaxed);
+    if (enable == static_cast<bool>(source_thread_pool))
+        return;
+
+    if (enable) {
+        const size_t num_workers = std::min(Common::ThreadPool::DefaultNumWorkers(), max_source_workers);
+        source_thread_pool = std::make_unique<Common::ThreadPool>(num_workers, "DSP");
+    } else {
+        source_thread_pool.reset();
+    }
+}
+
 static StereoFrame16 GenerateCurrentFrame() {
     SharedMemory& read = ReadRegion();
     SharedMemory& write = WriteRegion();
 
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
-    // Generate intermediate mixes
-    for (size_t i = 0; i < num_sources; i++) {
+    // Sources only touch their own state, configuration and status, so they can be generated
+    // concurrently. Guest memory doesn't change meanwhile as the emulation thread takes part.
+    const auto tick_source = [&](size_t i) {
         write.source_statuses.status[i] = sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
+    };
+
+    UpdateSourceThreadPool();
+    if (source_thread_pool) {
+        source_thread_pool->ParallelFor(num_sources, tick_source);
+    } else {
+        for (size_t i = 0; i < num_sources; i++) {
+            tick_source(i);
+        }
+    }
+
+    // Generate intermediate mixes. The sums are always made in source order, so that the output
+    // doesn't depend on whether or how sources were generated in parallel.
+    for (size_t i = 0; i < num_sources; i++) {
         for (size_t mix = 0; mix < 3; mix++) {
             sources[i].MixInto(intermediate_mixes[mix], mix);
         }
@@ -89,6 +129,11 @@ static bool perform_time_stretching = true;
 static std::unique_ptr<AudioCore::Sink> sink;
 static AudioCore::TimeStretcher time_stretcher;
 
+/// Offline sinks consume frames as fast as they are generated, so there is nothing to stretch
+static bool IsStretching() {
+    return perform_time_stretching && !sink->IsOffline();
+}
+
 static void FlushResidualStretcherAudio() {
     time_stretcher.Flush();
     while (true) {
@@ -100,7 +145,9 @@ static void FlushResidualStretcherAudio() {
 }
 
 static void OutputCurrentFrame(const StereoFrame16& frame) {
-    if (perform_time_stretching) {
+    if (sink->IsOffline()) {
+        sink->EnqueueSamples(&frame[0][0], frame.size());
+    } else if (perform_time_stretching) {
         time_stretcher.AddSamples(&frame[0][0], frame.size());
         std::vector<s16> stretched_samples = time_stretcher.Process(sink->SamplesInQueue());
         sink->EnqueueSamples(stretched_samples.data(), stretched_samples.size() / 2);
@@ -120,12 +167,16 @@ void EnableStretching(bool enable) {
     if (perform_time_stretching == enable)
         return;
 
-    if (!enable) {
+    if (!enable && IsStretching()) {
         FlushResidualStretcherAudio();
     }
     perform_time_stretching = enable;
 }
 
+void EnableMultithreading(bool enable) {
+    multithreading_requested.store(enable, std::memory_order_relaxed);
+}
+
 // Public Interface
 
 void Init() {
@@ -144,9 +195,11 @@ void Init() {
 }
 
 void Shutdown() {
-    if (perform_time_stretching) {
+    if (IsStretching()) {
         FlushResidualStretcherAudio();
     }
+
+    source_thread_pool.reset();
 }
 
 bool Tick() {
@@ -552,5 +552,13 @@ void SetSink(std::unique_ptr<AudioCore::Sink> sink);
  */
 void EnableStretching(bool enable);
 
+/**
+ * Enables/Disables generating the frames of the sources on a small pool of worker threads.
+ * Sources are still mixed in order, so the output is identical either way. The change takes
+ * effect on the next audio frame, so this may be called from any thread.
+ * @param enable true to enable, false to disable.
+ */
+void EnableMultithreading(bool enable);
+
 } // namespace HLE
 } // namespace DSP
@@ -2,12 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/dsp.h"
 #include "audio_core/hle/filter.h"
+#include "audio_core/sample_kernels.h"
 
 #include "common/common_types.h"
 #include "common/math_util.h"
@@ -42,14 +44,34 @@ void SourceFilters::ProcessFrame(StereoFrame16& frame) {
         return;
 
     if (simple_filter_enabled) {
-        FilterFrame(frame, simple_filter);
+        simple_filter.ProcessFrame(frame);
     }
 
     if (biquad_filter_enabled) {
-        FilterFrame(frame, biquad_filter);
+        biquad_filter.ProcessFrame(frame);
     }
 }
 
+using FeedForwardFrame = std::array<std::array<s32, 2>, samples_per_frame>;
+
+/**
+ * Computes the non-recursive part of a filter for a whole frame with the vector kernels, so that
+ * only the feedback part remains sequential.
+ * @param x2 Input sample preceding x1
+ * @param x1 Input sample preceding the frame
+ */
+static FeedForwardFrame FeedForward(const StereoFrame16& frame, const std::array<s16, 2>& x2,
+                                    const std::array<s16, 2>& x1, s32 b0, s32 b1, s32 b2) {
+    std::array<std::array<s16, 2>, samples_per_frame + 2> input;
+    input[0] = x2;
+    input[1] = x1;
+    std::copy(frame.begin(), frame.end(), input.begin() + 2);
+
+    FeedForwardFrame output;
+    AudioCore::GetSampleKernels().feedforward(&output[0][0], &input[2][0], samples_per_frame, b0, b1, b2);
+    return output;
+}
+
 // SimpleFilter
 
 void SourceFilters::SimpleFilter::Reset() {
@@ -64,16 +86,15 @@ void SourceFilters::SimpleFilter::Configure(SourceConfiguration::Configuration::
     b0 = config.b0;
 }
 
-std::array<s16, 2> SourceFilters::SimpleFilter::ProcessSample(const std::array<s16, 2>& x0) {
-    std::array<s16, 2> y0;
-    for (size_t i = 0; i < 2; i++) {
-        const s32 tmp = (b0 * x0[i] + a1 * y1[i]) >> 15;
-        y0[i] = MathUtil::Clamp(tmp, -32768, 32767);
-    }
-
-    y1 = y0;
+void SourceFilters::SimpleFilter::ProcessFrame(StereoFrame16& frame) {
+    const FeedForwardFrame feedforward = FeedForward(frame, {}, {}, b0, 0, 0);
 
-    return y0;
+    for (size_t n = 0; n < frame.size(); n++) {
+        for (size_t i = 0; i < 2; i++) {
+            const s32 tmp = (feedforward[n][i] + a1 * y1[i]) >> 15;
+            frame[n][i] = y1[i] = MathUtil::Clamp(tmp, -32768, 32767);
+        }
+    }
 }
 
 // BiquadFilter
@@ -96,19 +117,19 @@ void SourceFilters::BiquadFilter::Configure(SourceConfiguration::Configuration::
     b2 = config.b2;
 }
 
-std::array<s16, 2> SourceFilters::BiquadFilter::ProcessSample(const std::array<s16, 2>& x0) {
-    std::array<s16, 2> y0;
-    for (size_t i = 0; i < 2; i++) {
-        const s32 tmp = (b0 * x0[i] + b1 * x1[i] + b2 * x2[i] + a1 * y1[i] + a2 * y2[i]) >> 14;
-        y0[i] = MathUtil::Clamp(tmp, -32768, 32767);
-    }
+void SourceFilters::BiquadFilter::ProcessFrame(StereoFrame16& frame) {
+    const FeedForwardFrame feedforward = FeedForward(frame, x2, x1, b0, b1, b2);
 
-    x2 = x1;
-    x1 = x0;
-    y2 = y1;
-    y1 = y0;
+    x2 = frame[frame.size() - 2];
+    x1 = frame[frame.size() - 1];
 
-    return y0;
+    for (size_t n = 0; n < frame.size(); n++) {
+        for (size_t i = 0; i < 2; i++) {
+            const s32 tmp = (feedforward[n][i] + a1 * y1[i] + a2 * y2[i]) >> 14;
+            y2[i] = y1[i];
+            frame[n][i] = y1[i] = MathUtil::Clamp(tmp, -32768, 32767);
+        }
+    }
 }
 
 } // namespace HLE
@@ -66,11 +66,10 @@ private:
         void Configure(SourceConfiguration::Configuration::SimpleFilter config);
 
         /**
-         * Processes a single stereo PCM16 sample.
-         * @param x0 Input sample
-         * @return Output sample
+         * Processes a frame of stereo PCM16 samples in-place.
+         * @param frame Audio samples to process. Modified in-place.
          */
-        std::array<s16, 2> ProcessSample(const std::array<s16, 2>& x0);
+        void ProcessFrame(StereoFrame16& frame);
 
     private:
         // Configuration
@@ -92,11 +91,10 @@ private:
         void Configure(SourceConfiguration::Configuration::BiquadFilter config);
 
         /**
-         * Processes a single stereo PCM16 sample.
-         * @param x0 Input sample
-         * @return Output sample
+         * Processes a frame of stereo PCM16 samples in-place.
+         * @param frame Audio samples to process. Modified in-place.
          */
-        std::array<s16, 2> ProcessSample(const std::array<s16, 2>& x0);
+        void ProcessFrame(StereoFrame16& frame);
 
     private:
         // Configuration
@@ -7,6 +7,7 @@
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/dsp.h"
 #include "audio_core/hle/mixers.h"
+#include "audio_core/sample_kernels.h"
 
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -90,29 +91,12 @@ void Mixers::ParseConfig(DspConfiguration& config) {
     config.dirty_raw = 0;
 }
 
-static s16 ClampToS16(s32 value) {
-    return static_cast<s16>(MathUtil::Clamp(value, -32768, 32767));
-}
-
-static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a, const std::array<s16, 2>& b) {
-    return {
-        ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
-        ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))
-    };
-}
-
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
     switch (state.output_format) {
     case OutputFormat::Mono:
-        std::transform(current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator, const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to mono
-                s16 mono = ClampToS16(static_cast<s32>((gain * sample[0] + gain * sample[1] + gain * sample[2] + gain * sample[3]) / 2));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, { mono, mono });
-            });
+        AudioCore::GetSampleKernels().downmix_mono(&current_frame[0][0], &samples[0][0], samples_per_frame, gain);
         return;
 
     case OutputFormat::Surround:
@@ -120,61 +104,52 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
         // fallthrough
 
     case OutputFormat::Stereo:
-        std::transform(current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
-            [gain](const std::array<s16, 2>& accumulator, const std::array<s32, 4>& sample) -> std::array<s16, 2> {
-                // Downmix to stereo
-                s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
-                s16 right = ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
-                // Mix into current frame
-                return AddAndClampToS16(accumulator, { left, right });
-            });
+        AudioCore::GetSampleKernels().downmix_stereo(&current_frame[0][0], &samples[0][0], samples_per_frame, gain);
         return;
     }
 
     UNREACHABLE_MSG("Invalid output_format %zu", static_cast<size_t>(state.output_format));
 }
 
+// IntermediateMixSamples are little-endian. Like Codec::DecodePCM16, this assumes a little-endian
+// host, on which they can be transposed as plain s32.
+static_assert(sizeof(s32_le) == sizeof(s32), "s32_le must have the layout of s32");
+
+static const s32* Planes(const IntermediateMixSamples::Samples& samples) {
+    return reinterpret_cast<const s32*>(&samples.pcm32[0][0]);
+}
+
+static s32* Planes(IntermediateMixSamples::Samples& samples) {
+    return reinterpret_cast<s32*>(&samples.pcm32[0][0]);
+}
+
 void Mixers::AuxReturn(const IntermediateMixSamples& read_samples) {
     // NOTE: read_samples.mix{1,2}.pcm32 annoyingly have their dimensions in reverse order to QuadFrame32.
+    const auto& kernels = AudioCore::GetSampleKernels();
 
     if (state.mixer1_enabled) {
-        for (size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (size_t channel = 0; channel < 4; channel++) {
-                state.intermediate_mix_buffer[1][sample][channel] = read_samples.mix1.pcm32[channel][sample];
-            }
-        }
+        kernels.planar_to_quad(&state.intermediate_mix_buffer[1][0][0], Planes(read_samples.mix1), samples_per_frame);
     }
 
     if (state.mixer2_enabled) {
-        for (size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (size_t channel = 0; channel < 4; channel++) {
-                state.intermediate_mix_buffer[2][sample][channel] = read_samples.mix2.pcm32[channel][sample];
-            }
-        }
+        kernels.planar_to_quad(&state.intermediate_mix_buffer[2][0][0], Planes(read_samples.mix2), samples_per_frame);
     }
 }
 
 void Mixers::AuxSend(IntermediateMixSamples& write_samples, const std::array<QuadFrame32, 3>& input) {
     // NOTE: read_samples.mix{1,2}.pcm32 annoyingly have their dimensions in reverse order to QuadFrame32.
+    const auto& kernels = AudioCore::GetSampleKernels();
 
     state.intermediate_mix_buffer[0] = input[0];
 
     if (state.mixer1_enabled) {
-        for (size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (size_t channel = 0; channel < 4; channel++) {
-                write_samples.mix1.pcm32[channel][sample] = input[1][sample][channel];
-            }
-        }
+        kernels.quad_to_planar(Planes(write_samples.mix1), &input[1][0][0], samples_per_frame);
     } else {
         state.intermediate_mix_buffer[1] = input[1];
     }
 
     if (state.mixer2_enabled) {
-        for (size_t sample = 0; sample < samples_per_frame; sample++) {
-            for (size_t channel = 0; channel < 4; channel++) {
-                write_samples.mix2.pcm32[channel][sample] = input[2][sample][channel];
-            }
-        }
+        kernels.quad_to_planar(Planes(write_samples.mix2), &input[2][0][0], samples_per_frame);
     } else {
         state.intermediate_mix_buffer[2] = input[2];
     }
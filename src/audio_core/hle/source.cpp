@@ -9,6 +9,7 @@
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/source.h"
 #include "audio_core/interpolate.h"
+#include "audio_core/sample_kernels.h"
 
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -32,14 +33,9 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
     if (!state.enabled)
         return;
 
+    // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
     const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
-    for (size_t samplei = 0; samplei < samples_per_frame; samplei++) {
-        // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
-        dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
-        dest[samplei][1] += static_cast<s32>(gains[1] * current_frame[samplei][1]);
-        dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
-        dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
-    }
+    AudioCore::GetSampleKernels().apply_gain(&dest[0][0], &current_frame[0][0], samples_per_frame, gains.data());
 }
 
 void Source::Reset() {
@@ -203,7 +199,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config, const s16_l
 void Source::GenerateFrame() {
     current_frame.fill({});
 
-    if (state.current_buffer.empty() && !DequeueBuffer()) {
+    if (!state.current_buffer.HasOutput() && !DequeueBuffer()) {
         state.enabled = false;
         state.buffer_update = true;
         state.current_buffer_id = 0;
@@ -214,25 +210,65 @@ void Source::GenerateFrame() {
 
     state.current_sample_number = state.next_sample_number;
     while (frame_position < current_frame.size()) {
-        if (state.current_buffer.empty() && !DequeueBuffer()) {
+        if (!state.current_buffer.HasOutput() && !DequeueBuffer()) {
             break;
         }
 
-        const size_t size_to_copy = std::min(state.current_buffer.size(), current_frame.size() - frame_position);
-
-        std::copy(state.current_buffer.begin(), state.current_buffer.begin() + size_to_copy, current_frame.begin() + frame_position);
-        state.current_buffer.erase(state.current_buffer.begin(), state.current_buffer.begin() + size_to_copy);
+        // Only the input needed for this frame is decoded and resampled.
+        const size_t size_generated = GenerateSamples(&current_frame[frame_position], current_frame.size() - frame_position);
 
-        frame_position += size_to_copy;
-        state.next_sample_number += static_cast<u32>(size_to_copy);
+        frame_position += size_generated;
+        state.next_sample_number += static_cast<u32>(size_generated);
     }
 
     state.filters.ProcessFrame(current_frame);
 }
 
+size_t Source::GenerateSamples(std::array<s16, 2>* output, size_t count) {
+    const auto decode = [this](size_t first, size_t count, std::array<s16, 2>* dest) {
+        DecodeSamples(first, count, dest);
+    };
+
+    switch (state.current_interpolation_mode) {
+    case InterpolationMode::None:
+        return state.current_buffer.None(state.interp_state, output, count, decode);
+    case InterpolationMode::Linear:
+        return state.current_buffer.Linear(state.interp_state, output, count, decode);
+    case InterpolationMode::Polyphase:
+        // TODO(merry): Implement polyphase interpolation
+        return state.current_buffer.Linear(state.interp_state, output, count, decode);
+    default:
+        UNIMPLEMENTED();
+        return 0;
+    }
+}
+
+void Source::DecodeSamples(size_t first, size_t count, std::array<s16, 2>* dest) {
+    const u8* const memory = Memory::GetPhysicalPointer(state.current_physical_address);
+    if (!memory) {
+        std::fill(dest, dest + count, std::array<s16, 2>{});
+        return;
+    }
+
+    switch (state.current_format) {
+    case Format::PCM8:
+        Codec::DecodePCM8(state.current_num_channels, memory, first, count, dest);
+        break;
+    case Format::PCM16:
+        Codec::DecodePCM16(state.current_num_channels, memory, first, count, dest);
+        break;
+    case Format::ADPCM:
+        Codec::DecodeADPCM(memory, first, count, state.current_adpcm_coeffs, state.adpcm_state, dest);
+        break;
+    default:
+        std::fill(dest, dest + count, std::array<s16, 2>{});
+        break;
+    }
+}
+
 
 bool Source::DequeueBuffer() {
-    ASSERT_MSG(state.current_buffer.empty(), "Shouldn't dequeue; we still have data in current_buffer");
+    ASSERT_MSG(!state.current_buffer.HasOutput(), "Shouldn't dequeue; we still have data in current_buffer");
 
     if (state.input_queue.empty())
         return false;
@@ -250,53 +286,44 @@ bool Source::DequeueBuffer() {
     }
 
     const u8* const memory = Memory::GetPhysicalPointer(buf.physical_address);
-    if (memory) {
-        const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
-        switch (buf.format) {
-        case Format::PCM8:
-            state.current_buffer = Codec::DecodePCM8(num_channels, memory, buf.length);
-            break;
-        case Format::PCM16:
-            state.current_buffer = Codec::DecodePCM16(num_channels, memory, buf.length);
-            break;
-        case Format::ADPCM:
-            DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer = Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
-            break;
-        default:
-            UNIMPLEMENTED();
-            break;
-        }
-    } else {
+    if (!memory) {
         LOG_WARNING(Audio_DSP, "source_id=%zu buffer_id=%hu length=%u: Invalid physical address 0x%08X",
                                source_id, buf.buffer_id, buf.length, buf.physical_address);
-        state.current_buffer.clear();
+        state.current_buffer.Begin(state.interp_state, 0, state.rate_multiplier);
         return true;
     }
 
-    switch (state.interpolation_mode) {
-    case InterpolationMode::None:
-        state.current_buffer = AudioInterp::None(state.interp_state, state.current_buffer, state.rate_multiplier);
-        break;
-    case InterpolationMode::Linear:
-        state.current_buffer = AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier);
+    const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
+    size_t num_samples = buf.length;
+    switch (buf.format) {
+    case Format::PCM8:
+    case Format::PCM16:
         break;
-    case InterpolationMode::Polyphase:
-        // TODO(merry): Implement polyphase interpolation
-        state.current_buffer = AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier);
+    case Format::ADPCM:
+        DEBUG_ASSERT(num_channels == 1);
+        // ADPCM samples are decoded in pairs, see Codec::DecodeADPCM.
+        num_samples += num_samples % 2;
         break;
     default:
         UNIMPLEMENTED();
+        num_samples = 0;
         break;
     }
 
+    state.current_physical_address = buf.physical_address;
+    state.current_format = buf.format;
+    state.current_num_channels = num_channels;
+    state.current_adpcm_coeffs = state.adpcm_coeffs;
+    state.current_interpolation_mode = state.interpolation_mode;
+    state.current_buffer.Begin(state.interp_state, num_samples, state.rate_multiplier);
+
     state.current_sample_number = 0;
     state.next_sample_number = 0;
     state.current_buffer_id = buf.buffer_id;
     state.buffer_update = buf.from_queue;
 
-    LOG_TRACE(Audio_DSP, "source_id=%zu buffer_id=%hu from_queue=%s current_buffer.size()=%zu",
-                         source_id, buf.buffer_id, buf.from_queue ? "true" : "false", state.current_buffer.size());
+    LOG_TRACE(Audio_DSP, "source_id=%zu buffer_id=%hu from_queue=%s length=%zu",
+                         source_id, buf.buffer_id, buf.from_queue ? "true" : "false", num_samples);
     return true;
 }
 
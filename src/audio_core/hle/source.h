@@ -104,7 +104,16 @@ private:
 
         u32 current_sample_number = 0;
         u32 next_sample_number = 0;
-        std::vector<std::array<s16, 2>> current_buffer;
+        AudioInterp::Stream current_buffer;
+
+        // Decoding parameters of the current buffer, captured when it was dequeued.
+        // Its samples are only decoded as they are needed to generate the output.
+
+        PAddr current_physical_address = 0;
+        Format current_format = Format::ADPCM;
+        unsigned current_num_channels = 1;
+        std::array<s16, 16> current_adpcm_coeffs = {};
+        InterpolationMode current_interpolation_mode = InterpolationMode::Polyphase;
 
         // buffer_id state
 
@@ -134,8 +143,12 @@ private:
     void ParseConfig(SourceConfiguration::Configuration& config, const s16_le (&adpcm_coeffs)[16]);
     /// INTERNAL: Generate the current audio output for this frame based on our internal state.
     void GenerateFrame();
-    /// INTERNAL: Dequeues a buffer and does preprocessing on it (decoding, resampling). Puts it into current_buffer.
+    /// INTERNAL: Dequeues a buffer and prepares current_buffer for decoding and resampling it.
     bool DequeueBuffer();
+    /// INTERNAL: Generates up to count output samples from current_buffer, returns the number generated.
+    size_t GenerateSamples(std::array<s16, 2>* output, size_t count);
+    /// INTERNAL: Decodes input samples of the current buffer. Called by current_buffer as needed.
+    void DecodeSamples(size_t first, size_t count, std::array<s16, 2>* dest);
     /// INTERNAL: Generates a SourceStatus::Status based on our internal state.
     SourceStatus::Status GetCurrentStatus();
 };
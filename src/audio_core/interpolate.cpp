@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "audio_core/interpolate.h"
 
 #include "common/assert.h"
@@ -62,24 +64,92 @@ static StereoBuffer16 StepOverSamples(State& state, const StereoBuffer16& input,
     return output;
 }
 
+static std::array<s16, 2> NoneKernel(u64 fraction, const std::array<s16, 2>& x0, const std::array<s16, 2>& x1, const std::array<s16, 2>& x2) {
+    return x0;
+}
+
+static std::array<s16, 2> LinearKernel(u64 fraction, const std::array<s16, 2>& x0, const std::array<s16, 2>& x1, const std::array<s16, 2>& x2) {
+    // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
+    // This is a saturated subtraction. (Verified by black-box fuzzing.)
+    s64 delta0 = MathUtil::Clamp<s64>(x1[0] - x0[0], -32768, 32767);
+    s64 delta1 = MathUtil::Clamp<s64>(x1[1] - x0[1], -32768, 32767);
+
+    return std::array<s16, 2> {
+        static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
+        static_cast<s16>(x0[1] + fraction * delta1 / scale_factor)
+    };
+}
+
 StereoBuffer16 None(State& state, const StereoBuffer16& input, float rate_multiplier) {
-    return StepOverSamples(state, input, rate_multiplier, [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
-        return x0;
-    });
+    return StepOverSamples(state, input, rate_multiplier, NoneKernel);
 }
 
 StereoBuffer16 Linear(State& state, const StereoBuffer16& input, float rate_multiplier) {
-    // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
-    return StepOverSamples(state, input, rate_multiplier, [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
-        // This is a saturated subtraction. (Verified by black-box fuzzing.)
-        s64 delta0 = MathUtil::Clamp<s64>(x1[0] - x0[0], -32768, 32767);
-        s64 delta1 = MathUtil::Clamp<s64>(x1[1] - x0[1], -32768, 32767);
-
-        return std::array<s16, 2> {
-            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
-            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor)
-        };
-    });
+    return StepOverSamples(state, input, rate_multiplier, LinearKernel);
+}
+
+void Stream::Begin(const State& state, size_t input_size_, float rate_multiplier) {
+    ASSERT(rate_multiplier > 0);
+
+    input_size = input_size_;
+    decoded = 0;
+    history = { state.xn2, state.xn1 };
+
+    // Like StepOverSamples, buffers below two samples produce nothing and leave the state alone.
+    fposition = 0;
+    max_fposition = input_size < 2 ? 0 : input_size * scale_factor;
+    step_size = static_cast<u64>(rate_multiplier * scale_factor);
+}
+
+void Stream::DecodeUntil(size_t end, const DecodeFunction& decode) {
+    while (decoded < end) {
+        // Decode into the contiguous part of the ring, wrapping around afterwards.
+        const size_t ring_position = decoded & (ring_size - 1);
+        const size_t count = std::min(end - decoded, ring_size - ring_position);
+        decode(decoded, count, &ring[ring_position]);
+        decoded += count;
+    }
+}
+
+template <typename Function>
+size_t Stream::Generate(State& state, std::array<s16, 2>* output, size_t count, const DecodeFunction& decode, Function fn) {
+    size_t generated = 0;
+
+    while (generated < count && fposition < max_fposition) {
+        const size_t index = static_cast<size_t>(fposition / scale_factor);
+
+        if (index >= decoded) {
+            // Decode the input of the rest of this call's output at once, as far as the ring can
+            // hold it along with the two samples preceding the current one.
+            const u64 last_fposition = fposition + (count - generated - 1) * step_size;
+            const size_t last = std::min(input_size - 1, static_cast<size_t>(last_fposition / scale_factor));
+            const size_t oldest = index < 2 ? 0 : index - 2;
+            DecodeUntil(std::min(last + 1, oldest + ring_size), decode);
+        }
+
+        const ptrdiff_t i = static_cast<ptrdiff_t>(index);
+        output[generated++] = fn(fposition & scale_mask, GetInput(i - 2), GetInput(i - 1), GetInput(i));
+
+        fposition += step_size;
+    }
+
+    if (generated > 0 && fposition >= max_fposition) {
+        // The whole buffer has to be decoded for stateful codecs, even samples stepped over.
+        DecodeUntil(input_size, decode);
+
+        state.xn2 = GetInput(static_cast<ptrdiff_t>(input_size) - 2);
+        state.xn1 = GetInput(static_cast<ptrdiff_t>(input_size) - 1);
+    }
+
+    return generated;
+}
+
+size_t Stream::None(State& state, std::array<s16, 2>* output, size_t count, const DecodeFunction& decode) {
+    return Generate(state, output, count, decode, NoneKernel);
+}
+
+size_t Stream::Linear(State& state, std::array<s16, 2>* output, size_t count, const DecodeFunction& decode) {
+    return Generate(state, output, count, decode, LinearKernel);
 }
 
 } // namespace AudioInterp
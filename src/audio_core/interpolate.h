@@ -5,6 +5,8 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <functional>
 #include <vector>
 
 #include "common/common_types.h"
@@ -38,4 +40,65 @@ StereoBuffer16 None(State& state, const StereoBuffer16& input, float rate_multip
  */
 StereoBuffer16 Linear(State& state, const StereoBuffer16& input, float rate_multiplier);
 
+/**
+ * Resamples an input buffer whose samples are decoded on demand into a fixed-capacity ring, so that
+ * the output can be generated a few samples at a time without decoding the whole buffer up front.
+ * The output and the final state are identical to those of None or Linear over the whole buffer.
+ */
+class Stream {
+public:
+    /// Decodes `count` input samples, starting at input sample `first`, into `dest`
+    using DecodeFunction = std::function<void(size_t first, size_t count, std::array<s16, 2>* dest)>;
+
+    /**
+     * Starts resampling a new input buffer. Input samples are decoded in order, exactly once.
+     * @param state Interpolation state, providing the samples preceding the buffer.
+     * @param input_size Number of samples in the input buffer. Buffers below two samples produce no output.
+     * @param rate_multiplier Stretch factor. Must be a positive non-zero value.
+     */
+    void Begin(const State& state, size_t input_size, float rate_multiplier);
+
+    /// Whether the current input buffer has output left.
+    bool HasOutput() const {
+        return fposition < max_fposition;
+    }
+
+    /**
+     * Generates output with no interpolation. See None.
+     * @param state Interpolation state, updated once the last output sample of the buffer is generated.
+     * @param output Destination of at most `count` output samples.
+     * @param decode Function decoding input samples.
+     * @return The number of output samples generated.
+     */
+    size_t None(State& state, std::array<s16, 2>* output, size_t count, const DecodeFunction& decode);
+
+    /// Generates output with linear interpolation. See Linear and Stream::None.
+    size_t Linear(State& state, std::array<s16, 2>* output, size_t count, const DecodeFunction& decode);
+
+private:
+    /// Number of decoded input samples kept. Must be a power of two.
+    static constexpr size_t ring_size = 512;
+
+    template <typename Function>
+    size_t Generate(State& state, std::array<s16, 2>* output, size_t count, const DecodeFunction& decode, Function fn);
+
+    /// Decodes input samples up to `end` (exclusive), keeping the newest ring_size ones.
+    void DecodeUntil(size_t end, const DecodeFunction& decode);
+
+    /// Returns input sample `index`, indices -2 and -1 being the samples preceding the buffer.
+    const std::array<s16, 2>& GetInput(ptrdiff_t index) const {
+        return index < 0 ? history[index + 2] : ring[index & (ring_size - 1)];
+    }
+
+    u64 fposition = 0;     ///< Input position of the next output sample, in fixed point
+    u64 max_fposition = 0; ///< End of the input buffer, in fixed point
+    u64 step_size = 0;     ///< Distance between output samples, in fixed point
+
+    size_t input_size = 0;
+    size_t decoded = 0; ///< Number of input samples decoded so far
+
+    std::array<std::array<s16, 2>, 2> history = {}; ///< x[-2] and x[-1]
+    std::array<std::array<s16, 2>, ring_size> ring = {};
+};
+
 } // namespace AudioInterp
@@ -0,0 +1,138 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+
+#include "audio_core/sample_kernels.h"
+
+#include "common/common_types.h"
+#include "common/math_util.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace AudioCore {
+
+static s16 ClampToS16(s32 value) {
+    return static_cast<s16>(MathUtil::Clamp(value, -32768, 32767));
+}
+
+static void ApplyGain_Generic(s32* dest, const s16* src, size_t count, const float* gains) {
+    for (size_t i = 0; i < count; i++, dest += 4, src += 2) {
+        dest[0] += static_cast<s32>(gains[0] * src[0]);
+        dest[1] += static_cast<s32>(gains[1] * src[1]);
+        dest[2] += static_cast<s32>(gains[2] * src[0]);
+        dest[3] += static_cast<s32>(gains[3] * src[1]);
+    }
+}
+
+static void DownmixStereo_Generic(s16* frame, const s32* quad, size_t count, float gain) {
+    for (size_t i = 0; i < count; i++, frame += 2, quad += 4) {
+        const s16 left = ClampToS16(static_cast<s32>(gain * quad[0] + gain * quad[2]));
+        const s16 right = ClampToS16(static_cast<s32>(gain * quad[1] + gain * quad[3]));
+        frame[0] = ClampToS16(static_cast<s32>(frame[0]) + static_cast<s32>(left));
+        frame[1] = ClampToS16(static_cast<s32>(frame[1]) + static_cast<s32>(right));
+    }
+}
+
+static void DownmixMono_Generic(s16* frame, const s32* quad, size_t count, float gain) {
+    for (size_t i = 0; i < count; i++, frame += 2, quad += 4) {
+        const s16 mono = ClampToS16(static_cast<s32>((gain * quad[0] + gain * quad[1] + gain * quad[2] + gain * quad[3]) / 2));
+        frame[0] = ClampToS16(static_cast<s32>(frame[0]) + static_cast<s32>(mono));
+        frame[1] = ClampToS16(static_cast<s32>(frame[1]) + static_cast<s32>(mono));
+    }
+}
+
+static void QuadToPlanar_Generic(s32* planar, const s32* quad, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        for (size_t channel = 0; channel < 4; channel++) {
+            planar[channel * count + i] = quad[i * 4 + channel];
+        }
+    }
+}
+
+static void PlanarToQuad_Generic(s32* quad, const s32* planar, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        for (size_t channel = 0; channel < 4; channel++) {
+            quad[i * 4 + channel] = planar[channel * count + i];
+        }
+    }
+}
+
+static void FeedForward_Generic(s32* output, const s16* x, size_t count, s32 b0, s32 b1, s32 b2) {
+    const s16* const x1 = x - 2;
+    const s16* const x2 = x - 4;
+
+    // Products are summed as unsigned so that overflow wraps around like in the vector kernels
+    for (size_t i = 0; i < count * 2; i++) {
+        output[i] = static_cast<s32>(static_cast<u32>(b0 * x[i]) + static_cast<u32>(b1 * x1[i]) +
+                                     static_cast<u32>(b2 * x2[i]));
+    }
+}
+
+static void PCM8Mono_Generic(s16* dest, const u8* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        // The data is actually signed PCM8.
+        dest[i * 2 + 0] = dest[i * 2 + 1] = static_cast<s8>(src[i]);
+    }
+}
+
+static void PCM8Stereo_Generic(s16* dest, const u8* src, size_t count) {
+    for (size_t i = 0; i < count * 2; i++) {
+        dest[i] = static_cast<s8>(src[i]);
+    }
+}
+
+static void PCM16Mono_Generic(s16* dest, const u8* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        s16 sample;
+        std::memcpy(&sample, src + i * sizeof(s16), sizeof(s16));
+        dest[i * 2 + 0] = dest[i * 2 + 1] = sample;
+    }
+}
+
+const SampleKernels sample_kernels_generic = {
+    "Generic",
+    ApplyGain_Generic,
+    DownmixStereo_Generic,
+    DownmixMono_Generic,
+    QuadToPlanar_Generic,
+    PlanarToQuad_Generic,
+    FeedForward_Generic,
+    PCM8Mono_Generic,
+    PCM8Stereo_Generic,
+    PCM16Mono_Generic,
+};
+
+std::vector<const SampleKernels*> GetSupportedSampleKernels() {
+    std::vector<const SampleKernels*> kernels = { &sample_kernels_generic };
+
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.sse2)
+        kernels.push_back(&sample_kernels_sse2);
+    if (caps.avx2)
+        kernels.push_back(&sample_kernels_avx2);
+#endif // ARCHITECTURE_x86_64
+
+    return kernels;
+}
+
+static const SampleKernels*& ActiveSampleKernels() {
+    // Selected once, on first use from any thread
+    static const SampleKernels* kernels = GetSupportedSampleKernels().back();
+    return kernels;
+}
+
+const SampleKernels& GetSampleKernels() {
+    return *ActiveSampleKernels();
+}
+
+void SetSampleKernels(const SampleKernels& kernels) {
+    ActiveSampleKernels() = &kernels;
+}
+
+} // namespace AudioCore
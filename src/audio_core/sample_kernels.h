@@ -0,0 +1,73 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/**
+ * Sample processing routines of the DSP frame pipeline. Every implementation produces results
+ * bit-identical to the generic one, including saturation and float to integer truncation.
+ * Stereo samples are interleaved pairs of s16 and quadraphonic samples interleaved quads of s32.
+ */
+struct SampleKernels {
+    const char* name;
+
+    /**
+     * Scales stereo samples into quadraphonic ones and adds them to dest, as in Source::MixInto:
+     * dest[i][c] += (s32)(gains[c] * src[i][c % 2]).
+     */
+    void (*apply_gain)(s32* dest, const s16* src, size_t count, const float* gains);
+
+    /// Downmixes quadraphonic samples to stereo, scales them by gain and adds them to frame with saturation
+    void (*downmix_stereo)(s16* frame, const s32* quad, size_t count, float gain);
+
+    /// Downmixes quadraphonic samples to mono, scales them by gain and adds them to both channels of frame with saturation
+    void (*downmix_mono)(s16* frame, const s32* quad, size_t count, float gain);
+
+    /// Converts interleaved quadraphonic samples to four planes of count samples each
+    void (*quad_to_planar)(s32* planar, const s32* quad, size_t count);
+
+    /// Converts four planes of count samples each to interleaved quadraphonic samples
+    void (*planar_to_quad)(s32* quad, const s32* planar, size_t count);
+
+    /**
+     * Computes the non-recursive part of the source filters with wrapping 32-bit arithmetic:
+     * output[i][c] = b0 * x[i][c] + b1 * x[i-1][c] + b2 * x[i-2][c].
+     * x must be preceded by two stereo samples of history. Coefficients must be in [-32768, 32768].
+     */
+    void (*feedforward)(s32* output, const s16* x, size_t count, s32 b0, s32 b1, s32 b2);
+
+    /// Sign extends mono PCM8 samples into both channels of stereo PCM16 ones
+    void (*pcm8_mono)(s16* dest, const u8* src, size_t count);
+
+    /// Sign extends stereo PCM8 samples into stereo PCM16 ones
+    void (*pcm8_stereo)(s16* dest, const u8* src, size_t count);
+
+    /// Copies mono PCM16 samples, which may be unaligned, into both channels of stereo ones
+    void (*pcm16_mono)(s16* dest, const u8* src, size_t count);
+};
+
+extern const SampleKernels sample_kernels_generic;
+
+#ifdef ARCHITECTURE_x86_64
+extern const SampleKernels sample_kernels_sse2;
+extern const SampleKernels sample_kernels_avx2;
+#endif // ARCHITECTURE_x86_64
+
+/// Returns the kernel sets which can run on the host CPU, the generic one first and the fastest one last
+std::vector<const SampleKernels*> GetSupportedSampleKernels();
+
+/// Returns the kernels used by the DSP, by default the fastest ones supported by the host CPU
+const SampleKernels& GetSampleKernels();
+
+/// Overrides the kernels used by the DSP, e.g. to compare implementations against each other
+void SetSampleKernels(const SampleKernels& kernels);
+
+} // namespace AudioCore
@@ -0,0 +1,409 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <immintrin.h>
+
+#include "common/x64/target_attributes.h"
+
+#include "audio_core/sample_kernels.h"
+
+namespace AudioCore {
+
+// Every kernel handles the samples which don't fill a whole vector with the generic kernel. The
+// float conversions used below (cvtepi32_ps rounding to nearest, cvttps_epi32 truncating and
+// returning INT_MIN when out of range) match what the compiler emits for the scalar casts.
+
+/// Splits a coefficient into two halves which fit s16, for use with madd on duplicated samples
+static __m128i SplitCoefficient(s32 coefficient) {
+    const s16 high = static_cast<s16>(coefficient >> 1);
+    const s16 low = static_cast<s16>(coefficient - high);
+    return _mm_set1_epi32(static_cast<s32>(static_cast<u16>(high)) << 16 | static_cast<u16>(low));
+}
+
+// SSE2
+
+static void ApplyGain_SSE2(s32* dest, const s16* src, size_t count, const float* gains) {
+    const __m128 gain = _mm_loadu_ps(gains);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        // Two stereo samples, sign extended to [L0, R0, L1, R1]
+        const __m128i in = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 2));
+        const __m128 lr = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16));
+
+        __m128i* out = reinterpret_cast<__m128i*>(dest + i * 4);
+        const __m128 first = _mm_mul_ps(gain, _mm_shuffle_ps(lr, lr, _MM_SHUFFLE(1, 0, 1, 0)));
+        const __m128 second = _mm_mul_ps(gain, _mm_shuffle_ps(lr, lr, _MM_SHUFFLE(3, 2, 3, 2)));
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_cvttps_epi32(first)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_cvttps_epi32(second)));
+    }
+
+    sample_kernels_generic.apply_gain(dest + i * 4, src + i * 2, count - i, gains);
+}
+
+static void DownmixStereo_SSE2(s16* frame, const s32* quad, size_t count, float gain) {
+    const __m128 gain_vec = _mm_set1_ps(gain);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(quad + i * 4);
+        const __m128 q0 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 0)));
+        const __m128 q1 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 1)));
+        const __m128 q2 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 2)));
+        const __m128 q3 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 3)));
+
+        // [L0, R0, L1, R1] = [q0[0], q0[1], q1[0], q1[1]] + [q0[2], q0[3], q1[2], q1[3]]
+        const __m128 lr01 = _mm_add_ps(_mm_shuffle_ps(q0, q1, _MM_SHUFFLE(1, 0, 1, 0)),
+                                       _mm_shuffle_ps(q0, q1, _MM_SHUFFLE(3, 2, 3, 2)));
+        const __m128 lr23 = _mm_add_ps(_mm_shuffle_ps(q2, q3, _MM_SHUFFLE(1, 0, 1, 0)),
+                                       _mm_shuffle_ps(q2, q3, _MM_SHUFFLE(3, 2, 3, 2)));
+
+        // Both the conversion to s16 and the accumulation saturate
+        const __m128i mix = _mm_packs_epi32(_mm_cvttps_epi32(lr01), _mm_cvttps_epi32(lr23));
+        __m128i* out = reinterpret_cast<__m128i*>(frame + i * 2);
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), mix));
+    }
+
+    sample_kernels_generic.downmix_stereo(frame + i * 2, quad + i * 4, count - i, gain);
+}
+
+static void DownmixMono_SSE2(s16* frame, const s32* quad, size_t count, float gain) {
+    const __m128 gain_vec = _mm_set1_ps(gain);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(quad + i * 4);
+        __m128 c0 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 0)));
+        __m128 c1 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 1)));
+        __m128 c2 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 2)));
+        __m128 c3 = _mm_mul_ps(gain_vec, _mm_cvtepi32_ps(_mm_loadu_si128(in + 3)));
+
+        // Transpose from samples to channels, so that the channels are summed in the same order as
+        // in the generic kernel. Halving is exact, like the division by 2 it replaces.
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        const __m128 mono = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(c0, c1), c2), c3), half);
+
+        const __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(mono), _mm_setzero_si128());
+        __m128i* out = reinterpret_cast<__m128i*>(frame + i * 2);
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), _mm_unpacklo_epi16(packed, packed)));
+    }
+
+    sample_kernels_generic.downmix_mono(frame + i * 2, quad + i * 4, count - i, gain);
+}
+
+static inline void Transpose4x4(__m128i& r0, __m128i& r1, __m128i& r2, __m128i& r3) {
+    const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    r0 = _mm_unpacklo_epi64(t0, t1);
+    r1 = _mm_unpackhi_epi64(t0, t1);
+    r2 = _mm_unpacklo_epi64(t2, t3);
+    r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+static void QuadToPlanar_SSE2(s32* planar, const s32* quad, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(quad + i * 4);
+        __m128i r0 = _mm_loadu_si128(in + 0);
+        __m128i r1 = _mm_loadu_si128(in + 1);
+        __m128i r2 = _mm_loadu_si128(in + 2);
+        __m128i r3 = _mm_loadu_si128(in + 3);
+        Transpose4x4(r0, r1, r2, r3);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(planar + 0 * count + i), r0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(planar + 1 * count + i), r1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(planar + 2 * count + i), r2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(planar + 3 * count + i), r3);
+    }
+
+    for (; i < count; i++) {
+        for (size_t channel = 0; channel < 4; channel++) {
+            planar[channel * count + i] = quad[i * 4 + channel];
+        }
+    }
+}
+
+static void PlanarToQuad_SSE2(s32* quad, const s32* planar, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar + 0 * count + i));
+        __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar + 1 * count + i));
+        __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar + 2 * count + i));
+        __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar + 3 * count + i));
+        Transpose4x4(r0, r1, r2, r3);
+        __m128i* out = reinterpret_cast<__m128i*>(quad + i * 4);
+        _mm_storeu_si128(out + 0, r0);
+        _mm_storeu_si128(out + 1, r1);
+        _mm_storeu_si128(out + 2, r2);
+        _mm_storeu_si128(out + 3, r3);
+    }
+
+    for (; i < count; i++) {
+        for (size_t channel = 0; channel < 4; channel++) {
+            quad[i * 4 + channel] = planar[channel * count + i];
+        }
+    }
+}
+
+static void FeedForward_SSE2(s32* output, const s16* x, size_t count, s32 b0, s32 b1, s32 b2) {
+    const __m128i c0 = SplitCoefficient(b0);
+    const __m128i c1 = SplitCoefficient(b1);
+    const __m128i c2 = SplitCoefficient(b2);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i * 2));
+        const __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i * 2 - 2));
+        const __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i * 2 - 4));
+
+        // madd of a duplicated sample with both halves of a coefficient is the full 32-bit product
+        const __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x0, x0), c0),
+                                                       _mm_madd_epi16(_mm_unpacklo_epi16(x1, x1), c1)),
+                                         _mm_madd_epi16(_mm_unpacklo_epi16(x2, x2), c2));
+        const __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x0, x0), c0),
+                                                       _mm_madd_epi16(_mm_unpackhi_epi16(x1, x1), c1)),
+                                         _mm_madd_epi16(_mm_unpackhi_epi16(x2, x2), c2));
+
+        __m128i* out = reinterpret_cast<__m128i*>(output + i * 2);
+        _mm_storeu_si128(out, lo);
+        _mm_storeu_si128(out + 1, hi);
+    }
+
+    sample_kernels_generic.feedforward(output + i * 2, x + i * 2, count - i, b0, b1, b2);
+}
+
+static void PCM8Mono_SSE2(s16* dest, const u8* src, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(in, in), 8);
+        const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(in, in), 8);
+
+        __m128i* out = reinterpret_cast<__m128i*>(dest + i * 2);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo, lo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, lo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, hi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, hi));
+    }
+
+    sample_kernels_generic.pcm8_mono(dest + i * 2, src + i, count - i);
+}
+
+static void PCM8Stereo_SSE2(s16* dest, const u8* src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+
+        __m128i* out = reinterpret_cast<__m128i*>(dest + i * 2);
+        _mm_storeu_si128(out + 0, _mm_srai_epi16(_mm_unpacklo_epi8(in, in), 8));
+        _mm_storeu_si128(out + 1, _mm_srai_epi16(_mm_unpackhi_epi8(in, in), 8));
+    }
+
+    sample_kernels_generic.pcm8_stereo(dest + i * 2, src + i * 2, count - i);
+}
+
+static void PCM16Mono_SSE2(s16* dest, const u8* src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+
+        __m128i* out = reinterpret_cast<__m128i*>(dest + i * 2);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(in, in));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(in, in));
+    }
+
+    sample_kernels_generic.pcm16_mono(dest + i * 2, src + i * 2, count - i);
+}
+
+const SampleKernels sample_kernels_sse2 = {
+    "SSE2",
+    ApplyGain_SSE2,
+    DownmixStereo_SSE2,
+    DownmixMono_SSE2,
+    QuadToPlanar_SSE2,
+    PlanarToQuad_SSE2,
+    FeedForward_SSE2,
+    PCM8Mono_SSE2,
+    PCM8Stereo_SSE2,
+    PCM16Mono_SSE2,
+};
+
+// AVX2
+
+/// Restores sample order after an in-lane operation left [0, 2, 4, 6 | 1, 3, 5, 7] in 32-bit units
+TARGET_AVX2
+static inline __m256i InterleaveLanes(__m256i value) {
+    return _mm256_permutevar8x32_epi32(value, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+TARGET_AVX2
+static void ApplyGain_AVX2(s32* dest, const s16* src, size_t count, const float* gains) {
+    const __m256 gain = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(gains));
+    const __m256i first_index = _mm256_setr_epi32(0, 1, 0, 1, 2, 3, 2, 3);
+    const __m256i second_index = _mm256_setr_epi32(4, 5, 4, 5, 6, 7, 6, 7);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Four stereo samples, sign extended to [L0, R0, L1, R1, L2, R2, L3, R3]
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        const __m256 lr = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(in));
+
+        __m256i* out = reinterpret_cast<__m256i*>(dest + i * 4);
+        const __m256 first = _mm256_mul_ps(gain, _mm256_permutevar8x32_ps(lr, first_index));
+        const __m256 second = _mm256_mul_ps(gain, _mm256_permutevar8x32_ps(lr, second_index));
+        _mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), _mm256_cvttps_epi32(first)));
+        _mm256_storeu_si256(out + 1, _mm256_add_epi32(_mm256_loadu_si256(out + 1), _mm256_cvttps_epi32(second)));
+    }
+
+    sample_kernels_generic.apply_gain(dest + i * 4, src + i * 2, count - i, gains);
+}
+
+TARGET_AVX2
+static void DownmixStereo_AVX2(s16* frame, const s32* quad, size_t count, float gain) {
+    const __m256 gain_vec = _mm256_set1_ps(gain);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i* in = reinterpret_cast<const __m256i*>(quad + i * 4);
+        const __m256 q01 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 0)));
+        const __m256 q23 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 1)));
+        const __m256 q45 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 2)));
+        const __m256 q67 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 3)));
+
+        // Per lane, like the SSE2 kernel: [L0, R0, L2, R2 | L1, R1, L3, R3]
+        const __m256 lr0123 = _mm256_add_ps(_mm256_shuffle_ps(q01, q23, _MM_SHUFFLE(1, 0, 1, 0)),
+                                            _mm256_shuffle_ps(q01, q23, _MM_SHUFFLE(3, 2, 3, 2)));
+        const __m256 lr4567 = _mm256_add_ps(_mm256_shuffle_ps(q45, q67, _MM_SHUFFLE(1, 0, 1, 0)),
+                                            _mm256_shuffle_ps(q45, q67, _MM_SHUFFLE(3, 2, 3, 2)));
+
+        const __m256i mix = InterleaveLanes(
+            _mm256_packs_epi32(_mm256_cvttps_epi32(lr0123), _mm256_cvttps_epi32(lr4567)));
+        __m256i* out = reinterpret_cast<__m256i*>(frame + i * 2);
+        _mm256_storeu_si256(out, _mm256_adds_epi16(_mm256_loadu_si256(out), mix));
+    }
+
+    DownmixStereo_SSE2(frame + i * 2, quad + i * 4, count - i, gain);
+}
+
+TARGET_AVX2
+static void DownmixMono_AVX2(s16* frame, const s32* quad, size_t count, float gain) {
+    const __m256 gain_vec = _mm256_set1_ps(gain);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i* in = reinterpret_cast<const __m256i*>(quad + i * 4);
+        const __m256 r0 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 0)));
+        const __m256 r1 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 1)));
+        const __m256 r2 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 2)));
+        const __m256 r3 = _mm256_mul_ps(gain_vec, _mm256_cvtepi32_ps(_mm256_loadu_si256(in + 3)));
+
+        // In-lane transpose, each channel vector holds [s0, s2, s4, s6 | s1, s3, s5, s7]
+        const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        const __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+        const __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+        const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        const __m256 c0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 c1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 c2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 c3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 mono = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(c0, c1), c2), c3), half);
+
+        const __m256i ordered = InterleaveLanes(_mm256_cvttps_epi32(mono));
+        const __m256i packed = _mm256_packs_epi32(ordered, ordered);
+        __m256i* out = reinterpret_cast<__m256i*>(frame + i * 2);
+        _mm256_storeu_si256(out, _mm256_adds_epi16(_mm256_loadu_si256(out), _mm256_unpacklo_epi16(packed, packed)));
+    }
+
+    DownmixMono_SSE2(frame + i * 2, quad + i * 4, count - i, gain);
+}
+
+TARGET_AVX2
+static void FeedForward_AVX2(s32* output, const s16* x, size_t count, s32 b0, s32 b1, s32 b2) {
+    const __m256i c0 = _mm256_broadcastsi128_si256(SplitCoefficient(b0));
+    const __m256i c1 = _mm256_broadcastsi128_si256(SplitCoefficient(b1));
+    const __m256i c2 = _mm256_broadcastsi128_si256(SplitCoefficient(b2));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i * 2));
+        const __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i * 2 - 2));
+        const __m256i x2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i * 2 - 4));
+
+        // Unpacking is in-lane: lo holds samples 0-1 and 4-5, hi holds samples 2-3 and 6-7
+        const __m256i lo = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(x0, x0), c0),
+                                                             _mm256_madd_epi16(_mm256_unpacklo_epi16(x1, x1), c1)),
+                                            _mm256_madd_epi16(_mm256_unpacklo_epi16(x2, x2), c2));
+        const __m256i hi = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(x0, x0), c0),
+                                                             _mm256_madd_epi16(_mm256_unpackhi_epi16(x1, x1), c1)),
+                                            _mm256_madd_epi16(_mm256_unpackhi_epi16(x2, x2), c2));
+
+        __m256i* out = reinterpret_cast<__m256i*>(output + i * 2);
+        _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    FeedForward_SSE2(output + i * 2, x + i * 2, count - i, b0, b1, b2);
+}
+
+TARGET_AVX2
+static void PCM8Mono_AVX2(s16* dest, const u8* src, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i in = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        const __m256i lo = _mm256_unpacklo_epi16(in, in);
+        const __m256i hi = _mm256_unpackhi_epi16(in, in);
+
+        __m256i* out = reinterpret_cast<__m256i*>(dest + i * 2);
+        _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    PCM8Mono_SSE2(dest + i * 2, src + i, count - i);
+}
+
+TARGET_AVX2
+static void PCM8Stereo_AVX2(s16* dest, const u8* src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 2), _mm256_cvtepi8_epi16(in));
+    }
+
+    sample_kernels_generic.pcm8_stereo(dest + i * 2, src + i * 2, count - i);
+}
+
+TARGET_AVX2
+static void PCM16Mono_AVX2(s16* dest, const u8* src, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+        const __m256i lo = _mm256_unpacklo_epi16(in, in);
+        const __m256i hi = _mm256_unpackhi_epi16(in, in);
+
+        __m256i* out = reinterpret_cast<__m256i*>(dest + i * 2);
+        _mm256_storeu_si256(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    PCM16Mono_SSE2(dest + i * 2, src + i * 2, count - i);
+}
+
+// The transposes are bound by loads and stores, so 256-bit vectors don't help them
+const SampleKernels sample_kernels_avx2 = {
+    "AVX2",
+    ApplyGain_AVX2,
+    DownmixStereo_AVX2,
+    DownmixMono_AVX2,
+    QuadToPlanar_SSE2,
+    PlanarToQuad_SSE2,
+    FeedForward_AVX2,
+    PCM8Mono_AVX2,
+    PCM8Stereo_AVX2,
+    PCM16Mono_AVX2,
+};
+
+} // namespace AudioCore
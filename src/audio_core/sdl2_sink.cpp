@@ -2,7 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <list>
+#include <cstring>
 #include <vector>
 
 #include <SDL.h>
@@ -13,7 +13,7 @@
 
 #include "common/assert.h"
 #include "common/logging/log.h"
-#include <numeric>
+#include "common/ring_buffer.h"
 
 namespace AudioCore {
 
@@ -22,7 +22,8 @@ struct SDL2Sink::Impl {
 
     SDL_AudioDeviceID audio_device_id = 0;
 
-    std::list<std::vector<s16>> queue;
+    /// Stereo samples written by the emulation thread and read by the audio callback
+    Common::RingBuffer<s16, 0x4000, 2> fifo;
 
     static void Callback(void* impl_, u8* buffer, int buffer_size_in_bytes);
 };
@@ -98,26 +99,16 @@ void SDL2Sink::EnqueueSamples(const s16* samples, size_t sample_count) {
     if (impl->audio_device_id <= 0)
         return;
 
-    SDL_LockAudioDevice(impl->audio_device_id);
-    impl->queue.emplace_back(samples, samples + sample_count * 2);
-    SDL_UnlockAudioDevice(impl->audio_device_id);
+    const size_t pushed = impl->fifo.Push(samples, sample_count);
+    if (pushed < sample_count)
+        LOG_TRACE(Audio_Sink, "Audio queue full, dropped %zu samples", sample_count - pushed);
 }
 
 size_t SDL2Sink::SamplesInQueue() const {
     if (impl->audio_device_id <= 0)
         return 0;
 
-    SDL_LockAudioDevice(impl->audio_device_id);
-
-    size_t total_size = std::accumulate(impl->queue.begin(), impl->queue.end(), static_cast<size_t>(0),
-        [](size_t sum, const auto& buffer) {
-            // Division by two because each stereo sample is made of two s16.
-            return sum + buffer.size() / 2;
-        });
-
-    SDL_UnlockAudioDevice(impl->audio_device_id);
-
-    return total_size;
+    return impl->fifo.Size();
 }
 
 void SDL2Sink::SetDevice(int _device_id) {
@@ -127,24 +118,13 @@ void SDL2Sink::SetDevice(int _device_id) {
 void SDL2Sink::Impl::Callback(void* impl_, u8* buffer, int buffer_size_in_bytes) {
     Impl* impl = reinterpret_cast<Impl*>(impl_);
 
-    size_t remaining_size = static_cast<size_t>(buffer_size_in_bytes) / sizeof(s16); // Keep track of size in 16-bit increments.
-
-    while (remaining_size > 0 && !impl->queue.empty()) {
-        if (impl->queue.front().size() <= remaining_size) {
-            memcpy(buffer, impl->queue.front().data(), impl->queue.front().size() * sizeof(s16));
-            buffer += impl->queue.front().size() * sizeof(s16);
-            remaining_size -= impl->queue.front().size();
-            impl->queue.pop_front();
-        } else {
-            memcpy(buffer, impl->queue.front().data(), remaining_size * sizeof(s16));
-            buffer += remaining_size * sizeof(s16);
-            impl->queue.front().erase(impl->queue.front().begin(), impl->queue.front().begin() + remaining_size);
-            remaining_size = 0;
-        }
-    }
+    // Each stereo sample is made of two s16
+    const size_t sample_count = static_cast<size_t>(buffer_size_in_bytes) / (2 * sizeof(s16));
+    const size_t popped = impl->fifo.Pop(buffer, sample_count);
 
-    if (remaining_size > 0) {
-        memset(buffer, 0, remaining_size * sizeof(s16));
+    // Play silence on underrun
+    if (popped < sample_count) {
+        std::memset(buffer + popped * 2 * sizeof(s16), 0, (sample_count - popped) * 2 * sizeof(s16));
     }
 }
 
@@ -28,8 +28,21 @@ public:
      */
     virtual void EnqueueSamples(const s16* samples, size_t sample_count) = 0;
 
-    /// Samples enqueued that have not been played yet.
+    /**
+     * Samples enqueued that have not been played yet. This is polled by the time stretcher every
+     * audio frame, so it must be cheap and must not wait on the audio thread; sinks which buffer
+     * samples should use a Common::RingBuffer.
+     */
     virtual std::size_t SamplesInQueue() const = 0;
+
+    /**
+     * Whether samples are consumed as soon as they are enqueued instead of being played in real
+     * time, e.g. when they are written to a file. Such sinks get every frame at emulated speed,
+     * without time stretching or dropped samples.
+     */
+    virtual bool IsOffline() const {
+        return false;
+    }
 	
     virtual void SetDevice(int device_id) = 0;
     virtual std::vector<std::string>* GetDeviceMap() = 0;
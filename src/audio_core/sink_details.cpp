@@ -5,9 +5,12 @@
 #include <memory>
 #include <vector>
 
+#include "audio_core/file_sink.h"
 #include "audio_core/null_sink.h"
 #include "audio_core/sink_details.h"
 
+#include "core/settings.h"
+
 #ifdef HAVE_SDL2
 #include "audio_core/sdl2_sink.h"
 #endif
@@ -20,6 +23,9 @@ const std::vector<SinkDetails> g_sink_details = {
     { "sdl2", []() { return std::make_unique<SDL2Sink>(); } },
 #endif
     { "null", []() { return std::make_unique<NullSink>(); } },
+    // Captures are never auto-selected
+    { "wav", []() { return std::make_unique<FileSink>(FileSink::Format::Wav, Settings::values.audio_output_file); }, true },
+    { "raw", []() { return std::make_unique<FileSink>(FileSink::Format::Raw, Settings::values.audio_output_file); }, true },
 };
 
 } // namespace AudioCore
@@ -13,13 +13,15 @@ namespace AudioCore {
 class Sink;
 
 struct SinkDetails {
-    SinkDetails(const char* id_, std::function<std::unique_ptr<Sink>()> factory_)
-        : id(id_), factory(factory_) {}
+    SinkDetails(const char* id_, std::function<std::unique_ptr<Sink>()> factory_, bool writes_file_ = false)
+        : id(id_), factory(factory_), writes_file(writes_file_) {}
 
     /// Name for this sink.
     const char* id;
     /// A method to call to construct an instance of this type of sink.
     std::function<std::unique_ptr<Sink>()> factory;
+    /// Whether this sink captures to Settings::values.audio_output_file instead of playing audio.
+    bool writes_file;
 };
 
 extern const std::vector<SinkDetails> g_sink_details;
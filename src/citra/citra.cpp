@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <string>
 #include <thread>
 #include <iostream>
@@ -35,6 +36,7 @@
 #include "core/loader/loader.h"
 
 #include "citra/config.h"
+#include "citra/emu_window/emu_window_headless.h"
 #include "citra/emu_window/emu_window_sdl2.h"
 
 #include "video_core/video_core.h"
@@ -44,6 +46,9 @@ static void PrintHelp(const char *argv0)
 {
     std::cout << "Usage: " << argv0 << " [options] <filename>\n"
                  "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
+                 "    --headless        Run without a window, OpenGL or audio output, and report the\n"
+                 "                      frame rate on exit\n"
+                 "-f, --frames=NUMBER   With --headless, exit after NUMBER frames\n"
                  "-h, --help            Display this help and exit\n"
                  "-v, --version         Output version information and exit\n";
 }
@@ -58,6 +63,8 @@ int main(int argc, char **argv) {
     Config config;
     int option_index = 0;
     bool use_gdbstub = Settings::values.use_gdbstub;
+    bool headless = false;
+    u64 max_frames = 0;
     u32 gdb_port = static_cast<u32>(Settings::values.gdbstub_port);
     char *endarg;
 #ifdef _WIN64
@@ -73,13 +80,15 @@ int main(int argc, char **argv) {
 
     static struct option long_options[] = {
         { "gdbport", required_argument, 0, 'g' },
+        { "headless", no_argument, 0, 'H' },
+        { "frames", required_argument, 0, 'f' },
         { "help", no_argument, 0, 'h' },
         { "version", no_argument, 0, 'v' },
         { 0, 0, 0, 0 }
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:hv", long_options, &option_index);
+        char arg = getopt_long(argc, argv, "g:f:hv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -92,6 +101,18 @@ int main(int argc, char **argv) {
                     exit(1);
                 }
                 break;
+            case 'H':
+                headless = true;
+                break;
+            case 'f':
+                errno = 0;
+                max_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg) errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -129,11 +150,25 @@ int main(int argc, char **argv) {
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    if (headless) {
+        // Headless hosts have neither a GPU nor an audio device
+        Settings::values.use_software_renderer = true;
+        Settings::values.sink_id = "null";
+    }
     Settings::Apply();
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window = std::make_unique<EmuWindow_SDL2>();
+    std::unique_ptr<EmuWindow_Headless> headless_window;
+    std::unique_ptr<EmuWindow_SDL2> sdl_window;
+    EmuWindow* emu_window;
+    if (headless) {
+        headless_window = std::make_unique<EmuWindow_Headless>(max_frames);
+        emu_window = headless_window.get();
+    } else {
+        sdl_window = std::make_unique<EmuWindow_SDL2>();
+        emu_window = sdl_window.get();
+    }
 
-    System::Init(emu_window.get());
+    System::Init(emu_window);
     SCOPE_EXIT({ System::Shutdown(); });
 
     std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(boot_filename);
@@ -148,7 +183,20 @@ int main(int argc, char **argv) {
         return -1;
     }
 
-    while (emu_window->IsOpen()) {
+    if (headless) {
+        auto start = std::chrono::steady_clock::now();
+        while (headless_window->IsOpen()) {
+            Core::RunLoop();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        u64 num_frames = headless_window->GetNumFrames();
+        std::cout << "Presented " << num_frames << " frames in " << seconds << " s ("
+                  << (seconds > 0.0 ? num_frames / seconds : 0.0) << " fps)" << std::endl;
+        return 0;
+    }
+
+    while (sdl_window->IsOpen()) {
         Core::RunLoop();
     }
 
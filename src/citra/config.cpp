@@ -69,10 +69,14 @@ void Config::ReadValues() {
     Settings::values.frame_skip = sdl2_config->GetInteger("Core", "frame_skip", 0);
 
     // Renderer
+    Settings::values.use_software_renderer = sdl2_config->GetBoolean("Renderer", "use_software_renderer", false);
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.shader_cache_size = sdl2_config->GetInteger("Renderer", "shader_cache_size", 64);
+    Settings::values.use_shader_disk_cache = sdl2_config->GetBoolean("Renderer", "use_shader_disk_cache", false);
     Settings::values.use_scaled_resolution = sdl2_config->GetBoolean("Renderer", "use_scaled_resolution", false);
     Settings::values.use_vsync = sdl2_config->GetBoolean("Renderer", "use_vsync", false);
+    Settings::values.use_gpu_thread = sdl2_config->GetBoolean("Renderer", "use_gpu_thread", false);
 
     Settings::values.bg_red   = (float)sdl2_config->GetReal("Renderer", "bg_red",   1.0);
     Settings::values.bg_green = (float)sdl2_config->GetReal("Renderer", "bg_green", 1.0);
@@ -81,6 +85,10 @@ void Config::ReadValues() {
 	Settings::values.tex_filter = sdl2_config->GetInteger("Renderer", "tex_filter", 0);
 	Settings::values.tex_filter_scaling =
 	sdl2_config->GetInteger("Renderer", "tex_filter_scaling", 1);
+    Settings::values.tex_filter_cache_size =
+        sdl2_config->GetInteger("Renderer", "tex_filter_cache_size", 128);
+    Settings::values.use_tex_filter_disk_cache =
+        sdl2_config->GetBoolean("Renderer", "use_tex_filter_disk_cache", false);
 
     // Layout
     Settings::values.layout_option = static_cast<Settings::LayoutOption>(sdl2_config->GetInteger("Layout", "layout_option", 0));
@@ -89,7 +97,9 @@ void Config::ReadValues() {
     // Audio
     Settings::values.sink_id = sdl2_config->Get("Audio", "output_engine", "auto");
 	Settings::values.audio_device_id = sdl2_config->Get("Audio", "output_device", "auto");
+    Settings::values.audio_output_file = sdl2_config->Get("Audio", "output_file", "");
     Settings::values.enable_audio_stretching = sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.enable_audio_multithreading = sdl2_config->GetBoolean("Audio", "enable_audio_multithreading", false);
 
     // Data Storage
     Settings::values.use_virtual_sd = sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
@@ -47,6 +47,11 @@ use_cpu_jit =
 frame_skip =
 
 [Renderer]
+# Whether to present frames without OpenGL, drawing the screens on the CPU into the window.
+# This implies software rendering, and is always used with --headless.
+# 0 (default): OpenGL, 1: Software
+use_software_renderer =
+
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
 use_hw_renderer =
@@ -55,6 +60,14 @@ use_hw_renderer =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Amount of memory in MB the shader JIT may use for compiled shaders before discarding the least recently used ones.
+# Default: 64
+shader_cache_size =
+
+# Whether to remember the shaders used by each game on disk, so that they can be compiled when the game boots.
+# 0 (default): Off, 1: On
+use_shader_disk_cache =
+
 # Whether to use native 3DS screen resolution or to scale rendering resolution to the displayed screen size.
 # 0 (default): Native, 1: Scaled
 use_scaled_resolution =
@@ -63,6 +76,10 @@ use_scaled_resolution =
 # 0 (default): Off, 1: On
 use_vsync =
 
+# Whether to process PICA command lists on a separate thread. Only used with software rendering.
+# 0 (default): Off, 1: On
+use_gpu_thread =
+
 [Layout]
 # Layout for the screen inside the render window.
 # 0 (default): Default Top Bottom Screen, 1: Single Screen Only, 2: Large Screen Small Screen
@@ -87,10 +104,24 @@ tex_filter =
 # 1 (default): Disabled, 2-6: Enabled at x times scaling
 tex_filter_scaling =
 
+# Amount of memory in MB used to keep filtered textures, so that textures uploaded again aren't filtered again.
+# Default: 128
+tex_filter_cache_size =
+
+# Whether to also keep the filtered textures of each game on disk, so that they aren't filtered in later sessions.
+# 0 (default): Off, 1: On
+use_tex_filter_disk_cache =
+
 [Audio]
 # Which audio output engine to use.
-# auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available)
+# auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available),
+# wav: Capture to a WAV file, raw: Capture to a headerless stereo PCM16 file
 output_engine =
+
+# File the wav and raw output engines write to, which is overwritten.
+# Captures hold exactly the emulated audio, as they are never time stretched.
+# Defaults to audio.wav or audio.raw in the audio dump directory
+output_file =
   
 # Whether or not to enable the audio-stretching post-processing effect.
 # This effect adjusts audio speed to match emulation speed and helps prevent audio stutter,
@@ -104,6 +135,11 @@ enable_audio_stretching =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether to generate the audio of the emulated voices on several threads.
+# The output is identical, this only helps games playing many sounds at once on multi-core CPUs.
+# 0 (default): No, 1: Yes
+enable_audio_multithreading =
+
 [Data Storage]
 # Whether to create a virtual SD card.
 # 1 (default): Yes, 0: No
@@ -0,0 +1,31 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra/emu_window/emu_window_headless.h"
+
+#include "video_core/video_core.h"
+
+EmuWindow_Headless::EmuWindow_Headless(u64 max_frames) : max_frames(max_frames) {
+    // Lay out the screens as in a window of the default size, which sets the size of the frames
+    UpdateCurrentFramebufferLayout(VideoCore::kScreenTopWidth,
+                                   VideoCore::kScreenTopHeight + VideoCore::kScreenBottomHeight);
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() {}
+
+void EmuWindow_Headless::SwapBuffers() {}
+
+void EmuWindow_Headless::PollEvents() {}
+
+void EmuWindow_Headless::MakeCurrent() {}
+
+void EmuWindow_Headless::DoneCurrent() {}
+
+void EmuWindow_Headless::PresentFrame(const u32* pixels, unsigned width, unsigned height) {
+    ++num_frames;
+}
+
+bool EmuWindow_Headless::IsOpen() const {
+    return max_frames == 0 || num_frames < max_frames;
+}
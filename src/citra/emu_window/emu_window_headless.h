@@ -0,0 +1,46 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "common/emu_window.h"
+
+/**
+ * Window without any display or input, for unattended runs on hosts without a GPU. It is used
+ * with the software renderer, and only counts the frames it is given.
+ */
+class EmuWindow_Headless : public EmuWindow {
+public:
+    /// @param max_frames Number of frames after which the window reports being closed, 0 for none
+    explicit EmuWindow_Headless(u64 max_frames);
+    ~EmuWindow_Headless();
+
+    /// Swap buffers to display the next frame
+    void SwapBuffers() override;
+
+    /// Polls window events
+    void PollEvents() override;
+
+    /// Makes the graphics context current for the caller thread
+    void MakeCurrent() override;
+
+    /// Releases the GL context from the caller thread
+    void DoneCurrent() override;
+
+    /// Counts and discards a frame composed by the software renderer
+    void PresentFrame(const u32* pixels, unsigned width, unsigned height) override;
+
+    /// Whether the requested number of frames hasn't been presented yet
+    bool IsOpen() const;
+
+    /// Returns the number of frames presented so far
+    u64 GetNumFrames() const {
+        return num_frames;
+    }
+
+private:
+    u64 max_frames;
+    u64 num_frames = 0;
+};
@@ -88,19 +88,29 @@ EmuWindow_SDL2::EmuWindow_SDL2() {
     SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
     SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 0);
 
+    // The software renderer draws into the window surface instead of using OpenGL
+    const bool use_gl = !Settings::values.use_software_renderer;
+
     std::string window_title = Common::StringFromFormat("Citra | %s-%s", Common::g_scm_branch, Common::g_scm_desc);
     render_window = SDL_CreateWindow(window_title.c_str(),
         SDL_WINDOWPOS_UNDEFINED, // x position
         SDL_WINDOWPOS_UNDEFINED, // y position
         VideoCore::kScreenTopWidth,
         VideoCore::kScreenTopHeight + VideoCore::kScreenBottomHeight,
-        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+        (use_gl ? SDL_WINDOW_OPENGL : 0) | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
     if (render_window == nullptr) {
         LOG_CRITICAL(Frontend, "Failed to create SDL2 window! Exiting...");
         exit(1);
     }
 
+    if (!use_gl) {
+        OnResize();
+        OnMinimalClientAreaChangeRequest(GetActiveConfig().min_client_area_size);
+        SDL_PumpEvents();
+        return;
+    }
+
     gl_context = SDL_GL_CreateContext(render_window);
 
     if (gl_context == nullptr) {
@@ -122,13 +132,34 @@ EmuWindow_SDL2::EmuWindow_SDL2() {
 }
 
 EmuWindow_SDL2::~EmuWindow_SDL2() {
-    SDL_GL_DeleteContext(gl_context);
+    if (gl_context != nullptr)
+        SDL_GL_DeleteContext(gl_context);
     SDL_Quit();
 	motion_emu = nullptr;
 }
 
 void EmuWindow_SDL2::SwapBuffers() {
-    SDL_GL_SwapWindow(render_window);
+    if (gl_context != nullptr)
+        SDL_GL_SwapWindow(render_window);
+}
+
+void EmuWindow_SDL2::PresentFrame(const u32* pixels, unsigned width, unsigned height) {
+    // The window surface is recreated on resizes, so it is fetched again for every frame
+    SDL_Surface* window_surface = SDL_GetWindowSurface(render_window);
+    if (window_surface == nullptr)
+        return;
+
+    SDL_Surface* frame = SDL_CreateRGBSurfaceFrom(const_cast<u32*>(pixels), width, height, 32,
+                                                  width * sizeof(u32), 0x00FF0000, 0x0000FF00,
+                                                  0x000000FF, 0);
+    if (frame == nullptr) {
+        LOG_ERROR(Frontend, "Failed to create SDL2 surface for frame: %s", SDL_GetError());
+        return;
+    }
+
+    SDL_BlitScaled(frame, nullptr, window_surface, nullptr);
+    SDL_FreeSurface(frame);
+    SDL_UpdateWindowSurface(render_window);
 }
 
 void EmuWindow_SDL2::PollEvents() {
@@ -170,11 +201,13 @@ void EmuWindow_SDL2::PollEvents() {
 }
 
 void EmuWindow_SDL2::MakeCurrent() {
-    SDL_GL_MakeCurrent(render_window, gl_context);
+    if (gl_context != nullptr)
+        SDL_GL_MakeCurrent(render_window, gl_context);
 }
 
 void EmuWindow_SDL2::DoneCurrent() {
-    SDL_GL_MakeCurrent(render_window, nullptr);
+    if (gl_context != nullptr)
+        SDL_GL_MakeCurrent(render_window, nullptr);
 }
 
 void EmuWindow_SDL2::OnMinimalClientAreaChangeRequest(const std::pair<unsigned, unsigned>& minimal_size) {
@@ -29,6 +29,9 @@ public:
     /// Releases the GL context from the caller thread
     void DoneCurrent() override;
 
+    /// Copies a frame composed by the software renderer to the window surface
+    void PresentFrame(const u32* pixels, unsigned width, unsigned height) override;
+
     /// Whether the window is still open, and a close request hasn't yet been sent
     bool IsOpen() const;
 
@@ -55,8 +58,8 @@ private:
     SDL_Window* render_window;
 
     using SDL_GLContext = void *;
-    /// The OpenGL context associated with the window
-    SDL_GLContext gl_context;
+    /// The OpenGL context associated with the window, null when frames are presented by the CPU
+    SDL_GLContext gl_context = nullptr;
 
     /// Device id of keyboard for use with KeyMap
     int keyboard_id;
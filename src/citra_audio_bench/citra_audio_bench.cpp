@@ -0,0 +1,456 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <unistd.h>
+#include <getopt.h>
+#endif
+
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/thread_pool.h"
+
+#include "core/memory.h"
+#include "core/memory_setup.h"
+
+#include "audio_core/audio_core.h"
+#include "audio_core/file_sink.h"
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/dsp.h"
+#include "audio_core/hle/mixers.h"
+#include "audio_core/hle/source.h"
+#include "audio_core/null_sink.h"
+#include "audio_core/sample_kernels.h"
+#include "audio_core/time_stretch.h"
+
+using namespace DSP::HLE;
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+using Configuration = SourceConfiguration::Configuration;
+
+/// Sources, sample data and mixer settings of the benchmarked audio frames
+struct Scene {
+    /// Backing memory of the sample buffers, mapped at VRAM as sources read physical memory
+    std::vector<u8> memory;
+
+    std::array<Configuration, num_sources> configs;
+    AdpcmCoefficients adpcm;
+    DspConfiguration dsp_config;
+};
+
+} // anonymous namespace
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+                 "-f, --frames=NUMBER     Number of audio frames generated per run (default: 200)\n"
+                 "-l, --loops=NUMBER      Repeat each measurement NUMBER times (default: 20)\n"
+                 "-t, --threads=NUMBER    Generate sources on NUMBER worker threads, like with\n"
+                 "                        enable_audio_multithreading (default: 0)\n"
+                 "-o, --output=FILE       Capture the output of DSP::HLE::Tick to FILE as raw PCM16\n"
+                 "                        (default: a temporary file in the current directory)\n"
+                 "-e, --expect=HASH       Fail unless the captured output has this hash, e.g. one\n"
+                 "                        printed by another build or on another machine\n"
+                 "-h, --help              Display this help and exit\n"
+                 "-v, --version           Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "citra-audio-bench " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static float ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+/// Returns the number of bytes taken by the given number of samples of a source
+static size_t BufferSize(const Configuration& config, size_t sample_count) {
+    const size_t channels = config.mono_or_stereo == Configuration::MonoOrStereo::Stereo ? 2 : 1;
+    switch (config.format) {
+    case Configuration::Format::PCM8:
+        return sample_count * channels;
+    case Configuration::Format::PCM16:
+        return sample_count * channels * 2;
+    case Configuration::Format::ADPCM:
+        // Frames of 8 bytes hold 14 samples
+        return (sample_count + 13) / 14 * 8;
+    }
+    return 0;
+}
+
+/**
+ * Sets up every source with a buffer long enough for the given number of frames, cycling through
+ * sample formats, interpolation modes, rates and filters so that every stage of the pipeline runs.
+ * @return false if the buffers don't fit in the mapped memory
+ */
+static bool CreateScene(Scene& scene, unsigned frames) {
+    std::mt19937 rng(0);
+    std::memset(&scene.configs, 0, sizeof(scene.configs));
+    std::memset(&scene.adpcm, 0, sizeof(scene.adpcm));
+    std::memset(&scene.dsp_config, 0, sizeof(scene.dsp_config));
+    scene.memory.assign(Memory::VRAM_SIZE, 0);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < num_sources; i++) {
+        Configuration& config = scene.configs[i];
+        const float rate = 0.5f + 0.25f * (i % 5);
+
+        config.enable = 1;
+        config.enable_dirty.Assign(1);
+        config.rate_multiplier = rate;
+        config.rate_multiplier_dirty.Assign(1);
+        config.interpolation_mode = i % 2 == 0 ? Configuration::InterpolationMode::Linear
+                                               : Configuration::InterpolationMode::None;
+        config.interpolation_dirty.Assign(1);
+
+        for (size_t mix = 0; mix < 3; mix++) {
+            for (size_t channel = 0; channel < 4; channel++) {
+                config.gain[mix][channel] = ((i + mix + channel) % 4) * 0.25f;
+            }
+        }
+        config.gain_0_dirty.Assign(1);
+        config.gain_1_dirty.Assign(1);
+        config.gain_2_dirty.Assign(1);
+
+        config.simple_filter_enabled.Assign(i % 2);
+        config.biquad_filter_enabled.Assign((i / 2) % 2);
+        config.filters_enabled_dirty.Assign(1);
+        config.simple_filter.b0 = 0x3000;
+        config.simple_filter.a1 = 0x1000;
+        config.simple_filter_dirty.Assign(1);
+        config.biquad_filter.b0 = 0x1000;
+        config.biquad_filter.b1 = 0x2000;
+        config.biquad_filter.b2 = 0x1000;
+        config.biquad_filter.a1 = 0x1800;
+        config.biquad_filter.a2 = -0x0800;
+        config.biquad_filter_dirty.Assign(1);
+
+        const auto format = static_cast<Configuration::Format>(i % 3);
+        config.format.Assign(format);
+        config.mono_or_stereo.Assign(format != Configuration::Format::ADPCM && (i / 3) % 2
+                                         ? Configuration::MonoOrStereo::Stereo
+                                         : Configuration::MonoOrStereo::Mono);
+
+        for (size_t coeff = 0; coeff < 16; coeff++) {
+            scene.adpcm.coeff[i][coeff] = static_cast<s16>(rng() % 0x1000) - 0x800;
+        }
+        config.adpcm_coefficients_dirty.Assign(1);
+
+        const size_t sample_count = static_cast<size_t>(std::ceil(frames * samples_per_frame * rate)) + 16;
+        const size_t size = BufferSize(config, sample_count);
+        if (offset + size > scene.memory.size())
+            return false;
+
+        for (size_t byte = 0; byte < size; byte++) {
+            scene.memory[offset + byte] = static_cast<u8>(rng());
+        }
+
+        config.physical_address = static_cast<u32>(Memory::VRAM_PADDR + offset);
+        config.length = static_cast<u32>(sample_count);
+        config.buffer_id = 1;
+        config.embedded_buffer_dirty.Assign(1);
+
+        offset = (offset + size + 15) & ~size_t(15);
+    }
+
+    // Both auxiliary mixers are enabled so that their buffers are exchanged every frame
+    DspConfiguration& dsp_config = scene.dsp_config;
+    dsp_config.mixer1_enabled = 1;
+    dsp_config.mixer1_enabled_dirty.Assign(1);
+    dsp_config.mixer2_enabled = 1;
+    dsp_config.mixer2_enabled_dirty.Assign(1);
+    dsp_config.volume[0] = 1.0f;
+    dsp_config.volume_0_dirty.Assign(1);
+    dsp_config.volume[1] = 0.5f;
+    dsp_config.volume_1_dirty.Assign(1);
+    dsp_config.volume[2] = 0.25f;
+    dsp_config.volume_2_dirty.Assign(1);
+    dsp_config.output_format = DspConfiguration::OutputFormat::Stereo;
+    dsp_config.output_format_dirty.Assign(1);
+
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, scene.memory.data());
+    return true;
+}
+
+/**
+ * Generates the given number of frames from a fresh DSP state, like DSP::HLE::Tick does.
+ * @param thread_pool Pool generating the source frames, or nullptr to generate them inline
+ * @return Hash of all generated frames
+ */
+static u64 RunPipeline(const Scene& scene, unsigned frames, Common::ThreadPool* thread_pool,
+                       std::vector<s16>& output) {
+    std::vector<Source> sources;
+    sources.reserve(num_sources);
+    for (size_t i = 0; i < num_sources; i++) {
+        sources.emplace_back(i);
+    }
+    Mixers mixers;
+
+    // The DSP clears the dirty flags, so each run starts from a copy
+    std::array<Configuration, num_sources> configs = scene.configs;
+    DspConfiguration dsp_config = scene.dsp_config;
+    IntermediateMixSamples aux_samples = {};
+
+    output.resize(frames * samples_per_frame * 2);
+    for (unsigned frame = 0; frame < frames; frame++) {
+        const auto tick_source = [&](size_t i) {
+            sources[i].Tick(configs[i], scene.adpcm.coeff[i]);
+        };
+        if (thread_pool) {
+            thread_pool->ParallelFor(num_sources, tick_source);
+        } else {
+            for (size_t i = 0; i < num_sources; i++) {
+                tick_source(i);
+            }
+        }
+
+        std::array<QuadFrame32, 3> intermediate_mixes = {};
+        for (size_t i = 0; i < num_sources; i++) {
+            for (size_t mix = 0; mix < 3; mix++) {
+                sources[i].MixInto(intermediate_mixes[mix], mix);
+            }
+        }
+
+        // The application hands the auxiliary samples back unmodified
+        mixers.Tick(dsp_config, aux_samples, aux_samples, intermediate_mixes);
+
+        const StereoFrame16 frame_samples = mixers.GetOutput();
+        std::memcpy(&output[frame * samples_per_frame * 2], &frame_samples[0][0], sizeof(frame_samples));
+    }
+
+    return Common::ComputeHash64(output.data(), static_cast<int>(output.size() * sizeof(s16)));
+}
+
+/**
+ * Generates the given number of frames with DSP::HLE::Tick like the emulator does, capturing them
+ * with the raw file sink. Unlike RunPipeline, this covers the output path to the sink.
+ * @return Hash of the captured file, or 0 if it is incomplete
+ */
+static u64 RunDsp(const Scene& scene, unsigned frames, const std::string& path) {
+    // Region 0 is read as it has the higher frame counter, the DSP writes its output to region 1
+    std::memset(&g_regions, 0, sizeof(g_regions));
+    SharedMemory& read = g_regions[0];
+    read.frame_counter = 1;
+    // The structures are copied bytewise, as their bit fields can't be assigned
+    std::memcpy(read.source_configurations.config, scene.configs.data(), sizeof(scene.configs));
+    std::memcpy(&read.adpcm_coefficients, &scene.adpcm, sizeof(scene.adpcm));
+    std::memcpy(&read.dsp_configuration, &scene.dsp_config, sizeof(scene.dsp_config));
+
+    DSP::HLE::SetSink(std::make_unique<AudioCore::FileSink>(AudioCore::FileSink::Format::Raw, path));
+    DSP::HLE::Init();
+    for (unsigned frame = 0; frame < frames; frame++) {
+        DSP::HLE::Tick();
+    }
+    DSP::HLE::Shutdown();
+
+    // Replacing the sink closes the capture
+    DSP::HLE::SetSink(std::make_unique<AudioCore::NullSink>());
+
+    std::string captured;
+    FileUtil::ReadFileToString(false, path.c_str(), captured);
+    if (captured.size() != frames * sizeof(StereoFrame16))
+        return 0;
+
+    return Common::ComputeHash64(captured.data(), static_cast<int>(captured.size()));
+}
+
+/**
+ * Stretches the given samples, fed one frame at a time, with a constant queue of a tenth of a
+ * second. The ratio depends on how fast this runs, so the output isn't deterministic.
+ * @return Number of samples output
+ */
+static size_t RunTimeStretcher(const std::vector<s16>& samples) {
+    AudioCore::TimeStretcher time_stretcher;
+    const size_t samples_in_queue = AudioCore::native_sample_rate / 10;
+
+    size_t output_count = 0;
+    for (size_t offset = 0; offset + samples_per_frame * 2 <= samples.size(); offset += samples_per_frame * 2) {
+        time_stretcher.AddSamples(&samples[offset], samples_per_frame);
+        output_count += time_stretcher.Process(samples_in_queue).size() / 2;
+    }
+    time_stretcher.Flush();
+    output_count += time_stretcher.Process(samples_in_queue).size() / 2;
+    return output_count;
+}
+
+/// Returns the best time in milliseconds out of the given number of runs
+template <typename Func>
+static float TimeBest(unsigned loops, Func&& func) {
+    float best_ms = 0.0f;
+    for (unsigned loop = 0; loop < loops; ++loop) {
+        Clock::time_point start = Clock::now();
+        func();
+        float ms = ToMilliseconds(Clock::now() - start);
+        best_ms = (loop == 0) ? ms : std::min(best_ms, ms);
+    }
+    return best_ms;
+}
+
+static void PrintResult(const char* name, float ms, unsigned frames, bool match) {
+    std::printf("  %-8s %9.3f ms  %8.2f us/frame  %s\n", name, ms,
+                frames > 0 ? ms * 1000.0f / frames : 0.0f,
+                match ? "matches Generic" : "MISMATCH");
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    unsigned frames = 200;
+    unsigned loops = 20;
+    unsigned threads = 0;
+    std::string output_path;
+    u64 expected_hash = 0;
+
+    static struct option long_options[] = {
+        { "frames", required_argument, 0, 'f' },
+        { "loops", required_argument, 0, 'l' },
+        { "threads", required_argument, 0, 't' },
+        { "output", required_argument, 0, 'o' },
+        { "expect", required_argument, 0, 'e' },
+        { "help", no_argument, 0, 'h' },
+        { "version", no_argument, 0, 'v' },
+        { 0, 0, 0, 0 }
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "f:l:t:o:e:hv", long_options, &option_index);
+        if (arg == -1) {
+            PrintHelp(argv[0]);
+            return 1;
+        }
+
+        switch (arg) {
+        case 'f':
+            frames = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 'l':
+            loops = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 't':
+            threads = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'o':
+            output_path = optarg;
+            break;
+        case 'e':
+            expected_hash = std::strtoull(optarg, nullptr, 16);
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        case 'v':
+            PrintVersion();
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetFilter(&log_filter);
+
+    Scene scene;
+    if (!CreateScene(scene, frames)) {
+        std::cerr << "Sample buffers for " << frames << " frames don't fit in memory, use fewer frames" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Common::ThreadPool> thread_pool;
+    if (threads > 0)
+        thread_pool = std::make_unique<Common::ThreadPool>(threads, "AudioBench");
+
+    std::printf("%d sources, %u frames (%.1f ms of audio), %u worker threads:\n", num_sources,
+                frames, frames * samples_per_frame * 1000.0f / AudioCore::native_sample_rate, threads);
+
+    std::vector<s16> output;
+    u64 reference_hash = 0;
+    bool success = true;
+    for (const AudioCore::SampleKernels* kernels : AudioCore::GetSupportedSampleKernels()) {
+        AudioCore::SetSampleKernels(*kernels);
+
+        u64 hash = 0;
+        float ms = TimeBest(loops, [&] {
+            hash = RunPipeline(scene, frames, thread_pool.get(), output);
+        });
+
+        // The reference is generated inline, so that this also checks that threads don't change the output
+        if (kernels == &AudioCore::sample_kernels_generic)
+            reference_hash = RunPipeline(scene, frames, nullptr, output);
+
+        bool match = hash == reference_hash;
+        success = success && match;
+        PrintResult(kernels->name, ms, frames, match);
+    }
+
+    const bool keep_capture = !output_path.empty();
+    if (!keep_capture)
+        output_path = "citra-audio-bench.raw";
+
+    std::printf("DSP::HLE::Tick captured with the raw file sink:\n");
+    u64 capture_hash = 0;
+    for (const AudioCore::SampleKernels* kernels : AudioCore::GetSupportedSampleKernels()) {
+        AudioCore::SetSampleKernels(*kernels);
+        DSP::HLE::EnableMultithreading(threads > 0);
+
+        u64 hash = 0;
+        float ms = TimeBest(loops, [&] {
+            hash = RunDsp(scene, frames, output_path);
+        });
+
+        if (kernels == &AudioCore::sample_kernels_generic) {
+            DSP::HLE::EnableMultithreading(false);
+            capture_hash = RunDsp(scene, frames, output_path);
+        }
+
+        bool match = hash != 0 && hash == capture_hash;
+        success = success && match;
+        PrintResult(kernels->name, ms, frames, match);
+    }
+
+    // The last capture, made with the fastest kernels, is stretched like audio played in real time
+    std::string captured;
+    FileUtil::ReadFileToString(false, output_path.c_str(), captured);
+    std::vector<s16> samples(captured.size() / sizeof(s16));
+    std::memcpy(samples.data(), captured.data(), samples.size() * sizeof(s16));
+    float stretch_ms = TimeBest(loops, [&] {
+        RunTimeStretcher(samples);
+    });
+    std::printf("  %-8s %9.3f ms  %8.2f us/frame\n", "Stretch", stretch_ms, stretch_ms * 1000.0f / frames);
+
+    if (!keep_capture)
+        FileUtil::Delete(output_path);
+
+    std::printf("Captured output hash: %016llx", static_cast<unsigned long long>(capture_hash));
+    if (expected_hash != 0) {
+        const bool expected = capture_hash == expected_hash;
+        success = success && expected;
+        std::printf(" (%s %016llx)", expected ? "matches" : "MISMATCH, expected",
+                    static_cast<unsigned long long>(expected_hash));
+    }
+    std::printf("\n");
+
+    return success ? 0 : 1;
+}
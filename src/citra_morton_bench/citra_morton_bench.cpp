@@ -0,0 +1,271 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <unistd.h>
+#include <getopt.h>
+#endif
+
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+#include "video_core/morton.h"
+#include "video_core/utils.h"
+
+using namespace VideoCore;
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct TileRoutines {
+    const char* name;
+    UnswizzleTileFunc unswizzle;
+    SwizzleTileFunc swizzle;
+};
+
+} // anonymous namespace
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+                 "-x, --width=PIXELS      Width of the test surface, a multiple of 8 (default: 1024)\n"
+                 "-y, --height=PIXELS     Height of the test surface, a multiple of 8 (default: 1024)\n"
+                 "-l, --loops=NUMBER      Repeat each measurement NUMBER times (default: 20)\n"
+                 "-h, --help              Display this help and exit\n"
+                 "-v, --version           Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "citra-morton-bench " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static float ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+/// Returns the tile routines for the given pixel size which can run on the host CPU, the generic ones first
+static std::vector<TileRoutines> GetTileRoutines(u32 bytes_per_pixel) {
+    std::vector<TileRoutines> routines;
+    switch (bytes_per_pixel) {
+    case 2:
+        routines.push_back({ "Generic", UnswizzleTile2_Generic, SwizzleTile2_Generic });
+        break;
+    case 3:
+        routines.push_back({ "Generic", UnswizzleTile3_Generic, SwizzleTile3_Generic });
+        break;
+    case 4:
+        routines.push_back({ "Generic", UnswizzleTile4_Generic, SwizzleTile4_Generic });
+        break;
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.sse2 && bytes_per_pixel == 2)
+        routines.push_back({ "SSE2", UnswizzleTile2_SSE2, SwizzleTile2_SSE2 });
+    if (caps.sse2 && bytes_per_pixel == 4)
+        routines.push_back({ "SSE2", UnswizzleTile4_SSE2, SwizzleTile4_SSE2 });
+    if (caps.avx2 && bytes_per_pixel == 2)
+        routines.push_back({ "AVX2", UnswizzleTile2_AVX2, SwizzleTile2_AVX2 });
+    if (caps.avx2 && bytes_per_pixel == 4)
+        routines.push_back({ "AVX2", UnswizzleTile4_AVX2, SwizzleTile4_AVX2 });
+#endif
+    return routines;
+}
+
+/// Unswizzles a whole surface one tile at a time, like MortonUnswizzle
+static void UnswizzleSurface(UnswizzleTileFunc unswizzle_tile, u32 width, u32 height,
+                             u32 bytes_per_pixel, const u8* tiled, u8* linear) {
+    const ptrdiff_t stride = width * bytes_per_pixel;
+    for (u32 y = 0; y < height; y += 8) {
+        for (u32 x = 0; x < width; x += 8) {
+            unswizzle_tile(tiled, linear + y * stride + x * bytes_per_pixel, stride);
+            tiled += 64 * bytes_per_pixel;
+        }
+    }
+}
+
+static void SwizzleSurface(SwizzleTileFunc swizzle_tile, u32 width, u32 height,
+                           u32 bytes_per_pixel, u8* tiled, const u8* linear) {
+    const ptrdiff_t stride = width * bytes_per_pixel;
+    for (u32 y = 0; y < height; y += 8) {
+        for (u32 x = 0; x < width; x += 8) {
+            swizzle_tile(tiled, linear + y * stride + x * bytes_per_pixel, stride);
+            tiled += 64 * bytes_per_pixel;
+        }
+    }
+}
+
+/// Per-pixel conversion using GetMortonOffset, as done before the bulk routines existed
+static void UnswizzleSurfacePerPixel(u32 width, u32 height, u32 bytes_per_pixel,
+                                     const u8* tiled, u8* linear) {
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u32 coarse_y = y & ~7;
+            const u32 offset = GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * width * bytes_per_pixel;
+            std::memcpy(linear + (y * width + x) * bytes_per_pixel, tiled + offset, bytes_per_pixel);
+        }
+    }
+}
+
+static void SwizzleSurfacePerPixel(u32 width, u32 height, u32 bytes_per_pixel,
+                                   u8* tiled, const u8* linear) {
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u32 coarse_y = y & ~7;
+            const u32 offset = GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * width * bytes_per_pixel;
+            std::memcpy(tiled + offset, linear + (y * width + x) * bytes_per_pixel, bytes_per_pixel);
+        }
+    }
+}
+
+/// Returns the best time in milliseconds out of the given number of runs
+template <typename Func>
+static float TimeBest(unsigned loops, Func&& func) {
+    float best_ms = 0.0f;
+    for (unsigned loop = 0; loop < loops; ++loop) {
+        Clock::time_point start = Clock::now();
+        func();
+        float ms = ToMilliseconds(Clock::now() - start);
+        best_ms = (loop == 0) ? ms : std::min(best_ms, ms);
+    }
+    return best_ms;
+}
+
+static void PrintResult(const char* name, float ms, size_t bytes, bool match) {
+    std::printf("  %-8s %9.3f ms  %8.1f MB/s  %s\n", name, ms,
+                ms > 0.0f ? bytes / (ms * 1000.0f) : 0.0f,
+                match ? "matches Generic" : "MISMATCH");
+}
+
+/// Times every tile routine for the given pixel size in both directions and checks their results
+static bool BenchmarkPixelSize(u32 width, u32 height, u32 bytes_per_pixel, unsigned loops) {
+    const size_t size = width * height * bytes_per_pixel;
+
+    std::mt19937 rng(bytes_per_pixel);
+    std::vector<u8> tiled(size);
+    for (u8& byte : tiled)
+        byte = static_cast<u8>(rng());
+
+    const auto routines = GetTileRoutines(bytes_per_pixel);
+
+    std::vector<u8> reference_linear(size);
+    UnswizzleSurface(routines[0].unswizzle, width, height, bytes_per_pixel, tiled.data(), reference_linear.data());
+
+    std::vector<u8> linear(size);
+    std::vector<u8> swizzled(size);
+    bool all_match = true;
+
+    std::printf("Unswizzle, %u bytes per pixel, %ux%u:\n", bytes_per_pixel, width, height);
+    {
+        float ms = TimeBest(loops, [&] {
+            UnswizzleSurfacePerPixel(width, height, bytes_per_pixel, tiled.data(), linear.data());
+        });
+        bool match = linear == reference_linear;
+        all_match = all_match && match;
+        PrintResult("PerPixel", ms, size, match);
+    }
+    for (const auto& routine : routines) {
+        std::fill(linear.begin(), linear.end(), 0);
+        float ms = TimeBest(loops, [&] {
+            UnswizzleSurface(routine.unswizzle, width, height, bytes_per_pixel, tiled.data(), linear.data());
+        });
+        bool match = linear == reference_linear;
+        all_match = all_match && match;
+        PrintResult(routine.name, ms, size, match);
+    }
+
+    std::printf("Swizzle, %u bytes per pixel, %ux%u:\n", bytes_per_pixel, width, height);
+    {
+        float ms = TimeBest(loops, [&] {
+            SwizzleSurfacePerPixel(width, height, bytes_per_pixel, swizzled.data(), reference_linear.data());
+        });
+        bool match = swizzled == tiled;
+        all_match = all_match && match;
+        PrintResult("PerPixel", ms, size, match);
+    }
+    for (const auto& routine : routines) {
+        std::fill(swizzled.begin(), swizzled.end(), 0);
+        float ms = TimeBest(loops, [&] {
+            SwizzleSurface(routine.swizzle, width, height, bytes_per_pixel, swizzled.data(), reference_linear.data());
+        });
+        bool match = swizzled == tiled;
+        all_match = all_match && match;
+        PrintResult(routine.name, ms, size, match);
+    }
+
+    return all_match;
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    u32 width = 1024;
+    u32 height = 1024;
+    unsigned loops = 20;
+
+    static struct option long_options[] = {
+        { "width", required_argument, 0, 'x' },
+        { "height", required_argument, 0, 'y' },
+        { "loops", required_argument, 0, 'l' },
+        { "help", no_argument, 0, 'h' },
+        { "version", no_argument, 0, 'v' },
+        { 0, 0, 0, 0 }
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "x:y:l:hv", long_options, &option_index);
+        if (arg == -1) {
+            PrintHelp(argv[0]);
+            return 1;
+        }
+
+        switch (arg) {
+        case 'x':
+            width = std::max(8ul, std::strtoul(optarg, nullptr, 0) & ~7ul);
+            break;
+        case 'y':
+            height = std::max(8ul, std::strtoul(optarg, nullptr, 0) & ~7ul);
+            break;
+        case 'l':
+            loops = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        case 'v':
+            PrintVersion();
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetFilter(&log_filter);
+
+    bool success = true;
+    for (u32 bytes_per_pixel = 2; bytes_per_pixel <= 4; ++bytes_per_pixel)
+        success = BenchmarkPixelSize(width, height, bytes_per_pixel, loops) && success;
+
+    return success ? 0 : 1;
+}
@@ -48,8 +48,11 @@ void Config::ReadValues() {
     qt_config->beginGroup("Renderer");
     Settings::values.use_hw_renderer = qt_config->value("use_hw_renderer", true).toBool();
     Settings::values.use_shader_jit = qt_config->value("use_shader_jit", true).toBool();
+    Settings::values.shader_cache_size = qt_config->value("shader_cache_size", 64).toInt();
+    Settings::values.use_shader_disk_cache = qt_config->value("use_shader_disk_cache", false).toBool();
     Settings::values.use_scaled_resolution = qt_config->value("use_scaled_resolution", false).toBool();
     Settings::values.use_vsync = qt_config->value("use_vsync", false).toBool();
+    Settings::values.use_gpu_thread = qt_config->value("use_gpu_thread", false).toBool();
 
     Settings::values.bg_red   = qt_config->value("bg_red",   1.0).toFloat();
     Settings::values.bg_green = qt_config->value("bg_green", 1.0).toFloat();
@@ -58,6 +61,8 @@ void Config::ReadValues() {
 
 	Settings::values.tex_filter = qt_config->value("tex_filter", 0).toInt();
 	Settings::values.tex_filter_scaling = qt_config->value("tex_filter_scaling", 1).toInt();
+    Settings::values.tex_filter_cache_size = qt_config->value("tex_filter_cache_size", 128).toInt();
+    Settings::values.use_tex_filter_disk_cache = qt_config->value("use_tex_filter_disk_cache", false).toBool();
 	
     qt_config->beginGroup("Layout");
     Settings::values.layout_option = static_cast<Settings::LayoutOption>(qt_config->value("layout_option").toInt());
@@ -67,7 +72,9 @@ void Config::ReadValues() {
     qt_config->beginGroup("Audio");
     Settings::values.sink_id = qt_config->value("output_engine", "auto").toString().toStdString();
 	Settings::values.audio_device_id = qt_config->value("output_device", "auto").toString().toStdString();
+    Settings::values.audio_output_file = qt_config->value("output_file", "").toString().toStdString();
 	Settings::values.enable_audio_stretching = qt_config->value("enable_audio_stretching", true).toBool();
+    Settings::values.enable_audio_multithreading = qt_config->value("enable_audio_multithreading", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
@@ -152,8 +159,11 @@ void Config::SaveValues() {
     qt_config->beginGroup("Renderer");
     qt_config->setValue("use_hw_renderer", Settings::values.use_hw_renderer);
     qt_config->setValue("use_shader_jit", Settings::values.use_shader_jit);
+    qt_config->setValue("shader_cache_size", Settings::values.shader_cache_size);
+    qt_config->setValue("use_shader_disk_cache", Settings::values.use_shader_disk_cache);
     qt_config->setValue("use_scaled_resolution", Settings::values.use_scaled_resolution);
     qt_config->setValue("use_vsync", Settings::values.use_vsync);
+    qt_config->setValue("use_gpu_thread", Settings::values.use_gpu_thread);
 
     // Cast to double because Qt's written float values are not human-readable
     qt_config->setValue("bg_red",   (double)Settings::values.bg_red);
@@ -163,6 +173,8 @@ void Config::SaveValues() {
 
 	qt_config->setValue("tex_filter", Settings::values.tex_filter);
 	qt_config->setValue("tex_filter_scaling", Settings::values.tex_filter_scaling);
+    qt_config->setValue("tex_filter_cache_size", Settings::values.tex_filter_cache_size);
+    qt_config->setValue("use_tex_filter_disk_cache", Settings::values.use_tex_filter_disk_cache);
 	
     qt_config->beginGroup("Layout");
     qt_config->setValue("layout_option", static_cast<int>(Settings::values.layout_option));
@@ -172,7 +184,9 @@ void Config::SaveValues() {
     qt_config->beginGroup("Audio");
     qt_config->setValue("output_engine", QString::fromStdString(Settings::values.sink_id));
 	qt_config->setValue("output_device", QString::fromStdString(Settings::values.audio_device_id));
+    qt_config->setValue("output_file", QString::fromStdString(Settings::values.audio_output_file));
     qt_config->setValue("enable_audio_stretching", (Settings::values.enable_audio_stretching));
+    qt_config->setValue("enable_audio_multithreading", Settings::values.enable_audio_multithreading);
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
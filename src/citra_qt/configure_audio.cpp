@@ -43,6 +43,7 @@ void ConfigureAudio::setConfiguration() {
 	ui->output_sink_combo_box->setCurrentIndex(new_sink_index);
 
     ui->toggle_audio_stretching->setChecked(Settings::values.enable_audio_stretching);
+    ui->output_file_edit->setText(QString::fromStdString(Settings::values.audio_output_file));
 
 	// The device list cannot be pre-populated (nor listed) until the output sink is known.
 	updateAudioDevices(new_sink_index);
@@ -60,6 +61,7 @@ void ConfigureAudio::applyConfiguration() {
 	Settings::values.sink_id = ui->output_sink_combo_box->itemText(ui->output_sink_combo_box->currentIndex()).toStdString();
 	Settings::values.audio_device_id = ui->audio_device_combo_box->itemText(ui->audio_device_combo_box->currentIndex()).toStdString();
 	Settings::values.enable_audio_stretching = ui->toggle_audio_stretching->isChecked();
+    Settings::values.audio_output_file = ui->output_file_edit->text().toStdString();
 	Settings::Apply();
 }
 
@@ -76,6 +78,10 @@ void ConfigureAudio::updateAudioDevices(int sink_index) {
 		// The first index (0) should be "auto", which is not in the vector list (-1).
 		quick_sink_populate_device = AudioCore::g_sink_details[sink_index - 1];
 	}
+
+    // Only capturing sinks write to the output file
+    ui->output_file_edit->setEnabled(quick_sink_populate_device.writes_file);
+
 	auto iter = quick_sink_populate_device.factory();
 
 	// Prevent accessing a null device list.
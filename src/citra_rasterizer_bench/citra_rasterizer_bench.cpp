@@ -0,0 +1,412 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <unistd.h>
+#include <getopt.h>
+#endif
+
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/math_util.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer.h"
+#include "video_core/rasterizer_interpolation.h"
+#include "video_core/shader/shader.h"
+
+using namespace Pica::Rasterizer;
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct InterpolationRoutine {
+    const char* name;
+    InterpolateBlockFunc func;
+};
+
+/// Random triangle, with vertex positions in 12.4 fixed point rasterizer coordinates
+struct BenchTriangle {
+    int vertices[3][2];
+    TriangleInterpolants interpolants;
+};
+
+/// Block of a triangle which the rasterizer would pass to the block interpolation routine
+struct BlockJob {
+    size_t triangle;
+    int x, y;
+    unsigned width, height;
+};
+
+const unsigned FRAMEBUFFER_WIDTH = 240;
+const unsigned FRAMEBUFFER_HEIGHT = 400;
+const PAddr COLOR_BUFFER_ADDRESS = Memory::FCRAM_PADDR;
+const PAddr DEPTH_BUFFER_ADDRESS = Memory::FCRAM_PADDR + 0x100000;
+
+} // anonymous namespace
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+                 "-t, --triangles=NUMBER  Number of random triangles to rasterize (default: 2000)\n"
+                 "-s, --size=PIXELS       Maximum triangle extent in pixels (default: 64)\n"
+                 "-l, --loops=NUMBER      Repeat each measurement NUMBER times (default: 5)\n"
+                 "-h, --help              Display this help and exit\n"
+                 "-v, --version           Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "citra-rasterizer-bench " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static float ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+/// Returns the block interpolation routines which can run on the host CPU, the generic one first
+static std::vector<InterpolationRoutine> GetInterpolationRoutines() {
+    std::vector<InterpolationRoutine> routines = { { "Generic", InterpolateBlock_Generic } };
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.sse2)
+        routines.push_back({ "SSE2", InterpolateBlock_SSE2 });
+    if (caps.avx2)
+        routines.push_back({ "AVX2", InterpolateBlock_AVX2 });
+#endif
+    return routines;
+}
+
+/// Creates a random counter-clockwise triangle within the framebuffer
+static BenchTriangle RandomTriangle(std::mt19937& rng, unsigned max_size) {
+    std::uniform_int_distribution<int> position_x(0, FRAMEBUFFER_WIDTH * 16 - 1);
+    std::uniform_int_distribution<int> position_y(0, FRAMEBUFFER_HEIGHT * 16 - 1);
+    std::uniform_int_distribution<int> offset(-static_cast<int>(max_size) * 8, max_size * 8);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    BenchTriangle triangle;
+    auto& vertices = triangle.vertices;
+    int area;
+    do {
+        const int center_x = position_x(rng);
+        const int center_y = position_y(rng);
+        for (auto& vertex : vertices) {
+            vertex[0] = MathUtil::Clamp<int>(center_x + offset(rng), 0, FRAMEBUFFER_WIDTH * 16 - 1);
+            vertex[1] = MathUtil::Clamp<int>(center_y + offset(rng), 0, FRAMEBUFFER_HEIGHT * 16 - 1);
+        }
+        area = (vertices[1][0] - vertices[0][0]) * (vertices[2][1] - vertices[0][1]) -
+               (vertices[1][1] - vertices[0][1]) * (vertices[2][0] - vertices[0][0]);
+    } while (area == 0);
+
+    // Make sure the triangle is wound counter-clockwise, like the rasterizer does
+    if (area < 0)
+        std::swap(vertices[1], vertices[2]);
+
+    auto& interpolants = triangle.interpolants;
+    for (int i = 0; i < 3; ++i) {
+        const int* vtx1 = vertices[(i + 1) % 3];
+        const int* vtx2 = vertices[(i + 2) % 3];
+        interpolants.edges[i] = { vtx1[0], vtx1[1], vtx2[0] - vtx1[0], vtx2[1] - vtx1[1], 0 };
+
+        interpolants.w[i] = 0.5f + unit(rng);
+        interpolants.z[i] = unit(rng);
+        for (auto& attribute : interpolants.attributes)
+            attribute[i] = unit(rng);
+    }
+
+    interpolants.depth_scale = -1.0f;
+    interpolants.depth_offset = 1.0f;
+    interpolants.w_buffering = false;
+    return triangle;
+}
+
+/// Collects the blocks of the triangle's bounding box which the rasterizer would not skip
+static void AddBlockJobs(const BenchTriangle& triangle, size_t index, std::vector<BlockJob>& jobs) {
+    const auto& vertices = triangle.vertices;
+    const int min_x = std::min({ vertices[0][0], vertices[1][0], vertices[2][0] }) & ~0xF;
+    const int min_y = std::min({ vertices[0][1], vertices[1][1], vertices[2][1] }) & ~0xF;
+    const int max_x = (std::max({ vertices[0][0], vertices[1][0], vertices[2][0] }) + 0xF) & ~0xF;
+    const int max_y = (std::max({ vertices[0][1], vertices[1][1], vertices[2][1] }) + 0xF) & ~0xF;
+
+    for (int y = min_y; y < max_y; y += BLOCK_SIZE * 16) {
+        for (int x = min_x; x < max_x; x += BLOCK_SIZE * 16) {
+            BlockJob job{ index, x + 8, y + 8,
+                          std::min<unsigned>((max_x - x) >> 4, BLOCK_SIZE),
+                          std::min<unsigned>((max_y - y) >> 4, BLOCK_SIZE) };
+            if (BlockIntersectsTriangle(triangle.interpolants, job.x, job.y, job.width, job.height))
+                jobs.push_back(job);
+        }
+    }
+}
+
+/// Returns true if the covered pixels of both blocks have bit-identical values
+static bool BlocksMatch(const BlockInterpolants& a, const BlockInterpolants& b) {
+    if (a.coverage != b.coverage)
+        return false;
+
+    for (unsigned index = 0; index < BLOCK_SIZE * BLOCK_SIZE; ++index) {
+        if (!(a.coverage & (u64(1) << index)))
+            continue;
+
+        if (std::memcmp(&a.depth[index], &b.depth[index], sizeof(float)) != 0)
+            return false;
+        for (unsigned attribute = 0; attribute < TriangleInterpolants::NumAttributes; ++attribute) {
+            if (std::memcmp(&a.attributes[attribute][index], &b.attributes[attribute][index], sizeof(float)) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+/// Times every block interpolation routine on the same set of blocks and checks their results
+static bool BenchmarkInterpolation(const std::vector<BenchTriangle>& triangles, unsigned loops) {
+    std::vector<BlockJob> jobs;
+    for (size_t i = 0; i < triangles.size(); ++i)
+        AddBlockJobs(triangles[i], i, jobs);
+
+    std::vector<BlockInterpolants> reference(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BlockJob& job = jobs[i];
+        InterpolateBlock_Generic(triangles[job.triangle].interpolants, job.x, job.y, job.width, job.height, reference[i]);
+    }
+
+    std::printf("Block interpolation, %zu blocks:\n", jobs.size());
+
+    bool all_match = true;
+    for (const auto& routine : GetInterpolationRoutines()) {
+        BlockInterpolants result;
+        bool match = true;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            const BlockJob& job = jobs[i];
+            routine.func(triangles[job.triangle].interpolants, job.x, job.y, job.width, job.height, result);
+            match = match && BlocksMatch(result, reference[i]);
+        }
+        all_match = all_match && match;
+
+        float best_ms = 0.0f;
+        for (unsigned loop = 0; loop < loops; ++loop) {
+            Clock::time_point start = Clock::now();
+            for (const BlockJob& job : jobs)
+                routine.func(triangles[job.triangle].interpolants, job.x, job.y, job.width, job.height, result);
+            float ms = ToMilliseconds(Clock::now() - start);
+            best_ms = (loop == 0) ? ms : std::min(best_ms, ms);
+        }
+
+        std::printf("  %-8s %9.3f ms  %7.1f ns/block  %s\n", routine.name, best_ms,
+                    best_ms * 1e6f / std::max<size_t>(jobs.size(), 1),
+                    match ? "matches Generic" : "MISMATCH");
+    }
+    return all_match;
+}
+
+/// Sets up just enough of the emulated system for the rasterizer to access physical memory
+static void InitEnvironment() {
+    CoreTiming::Init();
+    Memory::Init();
+    Kernel::Init();
+    Pica::Init();
+
+    Kernel::g_current_process = Kernel::Process::Create(Kernel::CodeSet::Create("rasterizer-bench", 0));
+    auto fcram = std::make_shared<std::vector<u8>>(Memory::FCRAM_SIZE);
+    Kernel::g_current_process->vm_manager.MapMemoryBlock(
+            Kernel::g_current_process->GetLinearHeapAreaAddress(), std::move(fcram), 0,
+            Memory::FCRAM_SIZE, Kernel::MemoryState::Continuous).Unwrap();
+}
+
+static void ShutdownEnvironment() {
+    Pica::Shutdown();
+    Kernel::Shutdown();
+    CoreTiming::Shutdown();
+}
+
+/// Configures the Pica registers for depth tested, alpha blended, vertex colored triangles
+static void SetupRegisters() {
+    using Pica::Regs;
+    auto& regs = Pica::g_state.regs;
+
+    regs.framebuffer.width.Assign(FRAMEBUFFER_WIDTH);
+    regs.framebuffer.height.Assign(FRAMEBUFFER_HEIGHT);
+    regs.framebuffer.color_format.Assign(Regs::ColorFormat::RGBA8);
+    regs.framebuffer.depth_format = Regs::DepthFormat::D24S8;
+    regs.framebuffer.color_buffer_address = COLOR_BUFFER_ADDRESS / 8;
+    regs.framebuffer.depth_buffer_address = DEPTH_BUFFER_ADDRESS / 8;
+    regs.framebuffer.allow_color_write.Assign(0xF);
+    regs.framebuffer.allow_depth_stencil_write.Assign(0xF);
+
+    regs.depthmap_enable.Assign(Regs::DepthBuffering::ZBuffering);
+    regs.viewport_depth_range.Assign(0xBF0000); // -1.0 as float24
+    regs.viewport_depth_near_plane.Assign(0x3F0000); // 1.0 as float24
+
+    regs.output_merger.depth_test_enable.Assign(1);
+    regs.output_merger.depth_test_func.Assign(Regs::CompareFunc::GreaterThan);
+    regs.output_merger.depth_write_enable.Assign(1);
+    regs.output_merger.red_enable.Assign(1);
+    regs.output_merger.green_enable.Assign(1);
+    regs.output_merger.blue_enable.Assign(1);
+    regs.output_merger.alpha_enable.Assign(1);
+    regs.output_merger.alphablend_enable.Assign(1);
+    regs.output_merger.alpha_blending.factor_source_rgb.Assign(Regs::BlendFactor::SourceAlpha);
+    regs.output_merger.alpha_blending.factor_dest_rgb.Assign(Regs::BlendFactor::OneMinusSourceAlpha);
+    regs.output_merger.alpha_blending.factor_source_a.Assign(Regs::BlendFactor::One);
+    regs.output_merger.alpha_blending.factor_dest_a.Assign(Regs::BlendFactor::Zero);
+
+    regs.tev_stage0.color_source1.Assign(Regs::TevStageConfig::Source::PrimaryColor);
+    regs.tev_stage0.alpha_source1.Assign(Regs::TevStageConfig::Source::PrimaryColor);
+}
+
+/// Creates post-clipping vertices in screen space for a benchmark triangle
+static std::array<Pica::Shader::OutputVertex, 3> MakeVertices(const BenchTriangle& triangle) {
+    using Pica::float24;
+
+    std::array<Pica::Shader::OutputVertex, 3> vertices;
+    for (int i = 0; i < 3; ++i) {
+        auto& vertex = vertices[i];
+        std::memset(&vertex, 0, sizeof(vertex));
+
+        vertex.screenpos[0] = float24::FromFloat32(triangle.vertices[i][0] / 16.0f);
+        vertex.screenpos[1] = float24::FromFloat32(triangle.vertices[i][1] / 16.0f);
+        vertex.screenpos[2] = float24::FromFloat32(triangle.interpolants.z[i]);
+        vertex.pos.w = float24::FromFloat32(triangle.interpolants.w[i]);
+        for (int component = 0; component < 4; ++component) {
+            const float value = triangle.interpolants.attributes[TriangleInterpolants::ColorR + component][i];
+            vertex.color[component] = float24::FromFloat32(value);
+        }
+    }
+    return vertices;
+}
+
+/// Times whole triangle rasterization, without and with triangle binning
+static bool BenchmarkRasterization(const std::vector<BenchTriangle>& triangles, unsigned loops) {
+    std::vector<std::array<Pica::Shader::OutputVertex, 3>> vertices;
+    vertices.reserve(triangles.size());
+    for (const auto& triangle : triangles)
+        vertices.push_back(MakeVertices(triangle));
+
+    u8* color_buffer = Memory::GetPhysicalPointer(COLOR_BUFFER_ADDRESS);
+    u8* depth_buffer = Memory::GetPhysicalPointer(DEPTH_BUFFER_ADDRESS);
+    const size_t buffer_size = FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT * 4;
+
+    std::printf("Rasterization, %zu triangles:\n", triangles.size());
+
+    u64 hashes[2];
+    for (int binning = 0; binning < 2; ++binning) {
+        SetTriangleBinning(binning != 0);
+
+        float best_ms = 0.0f;
+        for (unsigned loop = 0; loop < loops; ++loop) {
+            std::memset(color_buffer, 0, buffer_size);
+            std::memset(depth_buffer, 0, buffer_size);
+
+            Clock::time_point start = Clock::now();
+            for (const auto& triangle : vertices)
+                ProcessTriangle(triangle[0], triangle[1], triangle[2]);
+            FlushTriangles();
+            float ms = ToMilliseconds(Clock::now() - start);
+            best_ms = (loop == 0) ? ms : std::min(best_ms, ms);
+        }
+
+        SetTriangleBinning(false);
+        hashes[binning] = Common::ComputeHash64(color_buffer, buffer_size);
+        std::printf("  %-8s %9.3f ms  %7.2f us/triangle  hash %016" PRIx64 "\n",
+                    binning ? "Binned" : "Serial", best_ms, best_ms * 1e3f / triangles.size(), hashes[binning]);
+    }
+    return hashes[0] == hashes[1];
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    unsigned num_triangles = 2000;
+    unsigned max_size = 64;
+    unsigned loops = 5;
+
+    static struct option long_options[] = {
+        { "triangles", required_argument, 0, 't' },
+        { "size", required_argument, 0, 's' },
+        { "loops", required_argument, 0, 'l' },
+        { "help", no_argument, 0, 'h' },
+        { "version", no_argument, 0, 'v' },
+        { 0, 0, 0, 0 }
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "t:s:l:hv", long_options, &option_index);
+        if (arg == -1) {
+            PrintHelp(argv[0]);
+            return 1;
+        }
+
+        switch (arg) {
+        case 't':
+            num_triangles = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 's':
+            max_size = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 'l':
+            loops = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        case 'v':
+            PrintVersion();
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetFilter(&log_filter);
+
+    std::mt19937 rng(0);
+    std::vector<BenchTriangle> triangles;
+    triangles.reserve(num_triangles);
+    for (unsigned i = 0; i < num_triangles; ++i)
+        triangles.push_back(RandomTriangle(rng, max_size));
+
+    bool success = BenchmarkInterpolation(triangles, loops);
+
+    InitEnvironment();
+    SCOPE_EXIT({ ShutdownEnvironment(); });
+    SetupRegisters();
+
+    if (!BenchmarkRasterization(triangles, loops)) {
+        std::printf("Binned rasterization does not match serial rasterization\n");
+        success = false;
+    }
+
+    return success ? 0 : 1;
+}
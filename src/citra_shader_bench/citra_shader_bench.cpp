@@ -0,0 +1,564 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <unistd.h>
+#include <getopt.h>
+#endif
+
+#include <nihstro/shader_bytecode.h>
+
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/video_core.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_batch_x64.h"
+#endif
+
+using namespace Pica;
+using namespace Pica::Shader;
+using nihstro::Instruction;
+using nihstro::OpCode;
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+/// Generates random shader programs covering the instructions and control flow handled by the batch interpreter
+class ProgramGenerator {
+public:
+    explicit ProgramGenerator(u32 seed) : rng(seed) {}
+
+    /// Generates a new program and sets it up, together with random uniforms, on the given shader
+    u32 Generate(ShaderSetup& setup) {
+        code.clear();
+        swizzles.clear();
+        subroutines.clear();
+
+        // Subroutines first, the main program after them
+        for (int i = 0; i < 3; ++i) {
+            u32 start = static_cast<u32>(code.size());
+            EmitBlock(2, 1 + Random(5));
+            subroutines.emplace_back(start, static_cast<u32>(code.size()) - start);
+        }
+
+        u32 main_offset = static_cast<u32>(code.size());
+        EmitArithmetic();
+        EmitBlock(0, 10 + Random(30));
+        EmitFlowControl(OpCode::Id::END);
+
+        swizzles.resize(std::min<size_t>(swizzles.size(), setup.swizzle_data.size()));
+        while (swizzles.size() < setup.swizzle_data.size())
+            swizzles.push_back(RandomSwizzle());
+
+        setup.program_code.fill(0);
+        std::copy(code.begin(), code.end(), setup.program_code.begin());
+        std::copy(swizzles.begin(), swizzles.end(), setup.swizzle_data.begin());
+
+        for (auto& f : setup.uniforms.f)
+            for (unsigned comp = 0; comp < 4; ++comp)
+                f[comp] = float24::FromFloat32(RandomFloat());
+        for (auto& b : setup.uniforms.b)
+            b = Random(2) != 0;
+        for (auto& i : setup.uniforms.i)
+            i = Math::MakeVec<u8>(Random(4), Random(4), 1 + Random(2), 0);
+
+        return main_offset;
+    }
+
+    /// Fills the attributes with random values, using small integers for those MOVA reads from
+    void GenerateInput(InputVertex& input) {
+        for (auto& attr : input.attr)
+            for (unsigned comp = 0; comp < 4; ++comp)
+                attr[comp] = float24::FromFloat32(RandomFloat());
+
+        for (unsigned comp = 0; comp < 4; ++comp)
+            input.attr[15][comp] = float24::FromFloat32(static_cast<float>(Random(Random(3) ? 1 : 8)));
+    }
+
+    u32 Random(u32 max) {
+        return rng() % max;
+    }
+
+private:
+    static void SetOpCode(Instruction& instr, OpCode::Id op) {
+        instr.hex = (instr.hex & ~(0x3fu << 26)) | (static_cast<u32>(op) << 26);
+    }
+
+    float RandomFloat() {
+        switch (Random(16)) {
+        case 0:
+            return 0.0f;
+        case 1:
+            return -0.0f;
+        case 2:
+            return INFINITY;
+        case 3:
+            return 1.0f;
+        default:
+            return (static_cast<int>(Random(2000)) - 1000) / 100.0f;
+        }
+    }
+
+    /// Returns a random operand descriptor, negating some of the source operands
+    u32 RandomSwizzle() {
+        u32 swizzle = rng();
+        for (unsigned negate_bit : { 4, 13, 22 }) {
+            if (Random(2))
+                swizzle &= ~(1u << negate_bit);
+        }
+        return swizzle;
+    }
+
+    u32 AddSwizzle(u32 swizzle) {
+        swizzles.push_back(swizzle);
+        return static_cast<u32>(swizzles.size() - 1) & 0x7f;
+    }
+
+    /// Returns a source register, keeping relative addressing of uniforms in range
+    u32 RandomSource(bool relative) {
+        u32 source = Random(0x80);
+        if (relative && source >= 0x70)
+            source -= 0x10;
+        return source;
+    }
+
+    void EmitArithmetic() {
+        static const OpCode::Id ops[] = {
+            OpCode::Id::ADD, OpCode::Id::DP3, OpCode::Id::DP4, OpCode::Id::DPH, OpCode::Id::MUL,
+            OpCode::Id::SGE, OpCode::Id::SLT, OpCode::Id::FLR, OpCode::Id::MAX, OpCode::Id::MIN,
+            OpCode::Id::RCP, OpCode::Id::RSQ, OpCode::Id::MOV, OpCode::Id::EX2, OpCode::Id::LG2,
+            OpCode::Id::DPHI, OpCode::Id::SGEI, OpCode::Id::SLTI, OpCode::Id::CMP, OpCode::Id::CMP,
+            OpCode::Id::MAD, OpCode::Id::MADI, OpCode::Id::MOVA,
+        };
+        const OpCode::Id op = ops[Random(sizeof(ops) / sizeof(ops[0]))];
+
+        Instruction instr;
+        instr.hex = 0;
+        if (op == OpCode::Id::MAD || op == OpCode::Id::MADI) {
+            // MAD takes its descriptor from the first 32 entries and its opcode from the low bits
+            instr.hex = (static_cast<u32>(op) + Random(8)) << 26;
+            if (swizzles.size() < 32)
+                swizzles.push_back(RandomSwizzle());
+            instr.mad.operand_desc_id = Random(std::min<u32>(static_cast<u32>(swizzles.size()), 32));
+
+            const u32 address_register = Random(4);
+            instr.mad.address_register_index = address_register;
+            instr.mad.src1 = Random(0x20);
+            if (op == OpCode::Id::MADI) {
+                instr.mad.src2i = Random(0x20);
+                instr.mad.src3i = RandomSource(address_register != 0);
+            } else {
+                instr.mad.src2 = RandomSource(address_register != 0);
+                instr.mad.src3 = Random(0x20);
+            }
+            instr.mad.dest = Random(0x20);
+        } else if (op == OpCode::Id::MOVA) {
+            // MOVA always reads the small integers of input 15
+            SetOpCode(instr, op);
+            instr.common.operand_desc_id = AddSwizzle(RandomSwizzle() & ~(1u << 4));
+            instr.common.src1 = 15;
+        } else {
+            SetOpCode(instr, op);
+            instr.common.operand_desc_id = AddSwizzle(RandomSwizzle());
+
+            const u32 address_register = Random(4);
+            instr.common.address_register_index = address_register;
+            if (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed) {
+                instr.common.src1i = Random(0x20);
+                instr.common.src2i = RandomSource(address_register != 0);
+            } else {
+                instr.common.src1 = RandomSource(address_register != 0);
+                instr.common.src2 = Random(0x20);
+            }
+            instr.common.dest = Random(0x20);
+
+            if (op == OpCode::Id::CMP) {
+                using CompareOp = Instruction::Common::CompareOpType::Op;
+                instr.common.compare_op.x = static_cast<CompareOp>(Random(6));
+                instr.common.compare_op.y = static_cast<CompareOp>(Random(6));
+            }
+        }
+        code.push_back(instr.hex);
+    }
+
+    /// Returns a flow control instruction with a random condition, which the uniform variants replace by their uniform id
+    Instruction MakeFlowControl(OpCode::Id op) {
+        Instruction instr;
+        instr.hex = 0;
+        SetOpCode(instr, op);
+        instr.flow_control.refx = Random(2);
+        instr.flow_control.refy = Random(2);
+        instr.flow_control.op = static_cast<Instruction::FlowControlType::Op>(Random(4));
+        return instr;
+    }
+
+    void EmitFlowControl(OpCode::Id op) {
+        code.push_back(MakeFlowControl(op).hex);
+    }
+
+    void EmitBlock(int depth, u32 length) {
+        for (u32 n = 0; n < length; ++n) {
+            const u32 choice = Random(20);
+            if (depth < 3 && choice == 0) {
+                size_t at = code.size();
+                code.push_back(0);
+                EmitBlock(depth + 1, Random(4));
+                u32 else_offset = static_cast<u32>(code.size());
+                EmitBlock(depth + 1, Random(4));
+
+                Instruction instr = MakeFlowControl(Random(4) ? OpCode::Id::IFC : OpCode::Id::IFU);
+                if (instr.opcode.Value() == OpCode::Id::IFU)
+                    instr.flow_control.bool_uniform_id = Random(16);
+                instr.flow_control.dest_offset = else_offset;
+                instr.flow_control.num_instructions = static_cast<u32>(code.size()) - else_offset;
+                code[at] = instr.hex;
+            } else if (depth < 3 && choice == 1) {
+                size_t at = code.size();
+                code.push_back(0);
+                EmitBlock(depth + 1, Random(4));
+                EmitArithmetic();
+
+                // The loop body runs up to and including dest_offset + 1
+                Instruction instr = MakeFlowControl(OpCode::Id::LOOP);
+                instr.flow_control.int_uniform_id = Random(4);
+                instr.flow_control.dest_offset = static_cast<u32>(code.size()) - 2;
+                code[at] = instr.hex;
+            } else if (choice == 2 && !subroutines.empty()) {
+                static const OpCode::Id calls[] = { OpCode::Id::CALL, OpCode::Id::CALLU, OpCode::Id::CALLC };
+                const auto& subroutine = subroutines[Random(static_cast<u32>(subroutines.size()))];
+
+                Instruction instr = MakeFlowControl(calls[Random(3)]);
+                if (instr.opcode.Value() == OpCode::Id::CALLU)
+                    instr.flow_control.bool_uniform_id = Random(16);
+                instr.flow_control.dest_offset = subroutine.first;
+                instr.flow_control.num_instructions = subroutine.second;
+                code.push_back(instr.hex);
+            } else if (choice == 3 && depth > 0 && Random(4) == 0) {
+                EmitFlowControl(OpCode::Id::END);
+            } else if (choice == 4 && Random(3) == 0) {
+                // Forward jump over a couple of instructions
+                size_t at = code.size();
+                code.push_back(0);
+                EmitArithmetic();
+                EmitArithmetic();
+
+                Instruction instr = MakeFlowControl(Random(2) ? OpCode::Id::JMPC : OpCode::Id::JMPU);
+                if (instr.opcode.Value() == OpCode::Id::JMPU) {
+                    instr.flow_control.bool_uniform_id = Random(16);
+                    instr.flow_control.num_instructions = Random(2);
+                }
+                instr.flow_control.dest_offset = static_cast<u32>(code.size());
+                code[at] = instr.hex;
+            } else {
+                EmitArithmetic();
+            }
+        }
+    }
+
+    std::mt19937 rng;
+    std::vector<u32> code;
+    std::vector<u32> swizzles;
+    std::vector<std::pair<u32, u32>> subroutines; ///< Offset and length of each subroutine
+};
+
+} // anonymous namespace
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+                 "-p, --programs=NUMBER   Compare the batch interpreter on NUMBER random programs (default: 20000)\n"
+                 "-n, --vertices=NUMBER   Time shading NUMBER vertices (default: 1048576)\n"
+                 "-h, --help              Display this help and exit\n"
+                 "-v, --version           Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "citra-shader-bench " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+/// Returns whether the two output registers hold the same bits, treating all NaNs as equal
+static bool OutputsMatch(const OutputRegisters& a, const OutputRegisters& b) {
+    for (unsigned reg = 0; reg < 16; ++reg) {
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            float x = a.value[reg][comp].ToFloat32();
+            float y = b.value[reg][comp].ToFloat32();
+            if (std::isnan(x) && std::isnan(y))
+                continue;
+            if (std::memcmp(&x, &y, sizeof(float)) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+#ifdef ARCHITECTURE_x86_64
+/**
+ * Runs random programs through the batch interpreters and the scalar interpreter and checks that
+ * they produce the same outputs for every vertex handled by the batch.
+ */
+static bool CompareBatchInterpreter(unsigned num_programs) {
+    struct BatchInterpreter {
+        const char* name;
+        BatchInterpreterFunc run;
+    };
+    std::vector<BatchInterpreter> interpreters = { { "SSE2", RunBatchInterpreter_SSE2 } };
+    if (Common::GetCPUCaps().avx2)
+        interpreters.push_back({ "AVX2", RunBatchInterpreter_AVX2 });
+
+    ShaderSetup& setup = g_state.vs;
+    ProgramGenerator generator(1);
+    static UnitState<false> state;
+    static BatchUnitState batch_state;
+    std::array<InputVertex, MAX_BATCH_SIZE> inputs;
+    std::array<OutputRegisters, MAX_BATCH_SIZE> expected;
+
+    bool success = true;
+    for (const auto& interpreter : interpreters) {
+        unsigned mismatches = 0;
+        unsigned vertices = 0;
+        unsigned rerun = 0;
+
+        for (unsigned program = 0; program < num_programs; ++program) {
+            const u32 main_offset = generator.Generate(setup);
+            const unsigned count = 1 + generator.Random(MAX_BATCH_SIZE);
+
+            for (unsigned vertex = 0; vertex < count; ++vertex) {
+                generator.GenerateInput(inputs[vertex]);
+
+                std::memset(&state.registers, 0, sizeof(state.registers));
+                std::memset(&state.output_registers, 0, sizeof(state.output_registers));
+                std::fill(std::begin(state.address_registers), std::end(state.address_registers), 0);
+                std::copy(std::begin(inputs[vertex].attr), std::end(inputs[vertex].attr), state.registers.input);
+                state.conditional_code[0] = false;
+                state.conditional_code[1] = false;
+
+                RunInterpreter(setup, state, main_offset);
+                expected[vertex] = state.output_registers;
+            }
+
+            std::memset(&batch_state, 0, sizeof(batch_state));
+            for (unsigned vertex = 0; vertex < count; ++vertex) {
+                for (unsigned reg = 0; reg < 16; ++reg) {
+                    for (unsigned comp = 0; comp < 4; ++comp)
+                        batch_state.registers.input[reg][comp][vertex] = inputs[vertex].attr[reg][comp].ToFloat32();
+                }
+            }
+
+            const unsigned scalar = interpreter.run(setup, batch_state, count, main_offset);
+
+            for (unsigned vertex = 0; vertex < count; ++vertex) {
+                ++vertices;
+                if (scalar & (1 << vertex)) {
+                    ++rerun;
+                    continue;
+                }
+
+                OutputRegisters output;
+                for (unsigned reg = 0; reg < 16; ++reg) {
+                    for (unsigned comp = 0; comp < 4; ++comp)
+                        output.value[reg][comp] = float24::FromFloat32(batch_state.registers.output[reg][comp][vertex]);
+                }
+
+                if (!OutputsMatch(expected[vertex], output)) {
+                    if (mismatches++ < 10)
+                        std::printf("  %s: program %u vertex %u differs from the interpreter\n",
+                                    interpreter.name, program, vertex);
+                }
+            }
+        }
+
+        std::printf("%-4s batch interpreter: %u programs, %u vertices, %u rerun on their own, %u mismatches\n",
+                    interpreter.name, num_programs, vertices, rerun, mismatches);
+        success = success && mismatches == 0;
+    }
+    return success;
+}
+#endif // ARCHITECTURE_x86_64
+
+/// Sets up a typical transform shader: two matrix multiplications, a scaled color and a texcoord
+static void SetupTransformShader(ShaderSetup& setup) {
+    std::vector<u32> code;
+    auto arithmetic = [&code](OpCode::Id op, u32 dest, u32 src1, u32 src2, u32 operand_desc_id) {
+        Instruction instr;
+        instr.hex = static_cast<u32>(op) << 26;
+        instr.common.dest = dest;
+        instr.common.src1 = src1;
+        instr.common.src2 = src2;
+        instr.common.operand_desc_id = operand_desc_id;
+        code.push_back(instr.hex);
+    };
+
+    // Descriptor 0 writes xyzw, descriptors 1 to 4 write x, y, z and w, all with unswizzled sources
+    auto descriptor = [](u32 dest_mask) {
+        return dest_mask | (0u << 11) | (1u << 9) | (2u << 7) | (3u << 5) |
+               (0u << 20) | (1u << 18) | (2u << 16) | (3u << 14);
+    };
+    setup.swizzle_data.fill(descriptor(0xF));
+    setup.swizzle_data[1] = descriptor(8);
+    setup.swizzle_data[2] = descriptor(4);
+    setup.swizzle_data[3] = descriptor(2);
+    setup.swizzle_data[4] = descriptor(1);
+
+    for (u32 row = 0; row < 4; ++row)
+        arithmetic(OpCode::Id::DP4, 0x10, 0x20 + row, 0, 1 + row);
+    for (u32 row = 0; row < 4; ++row)
+        arithmetic(OpCode::Id::DP4, 0, 0x24 + row, 0x10, 1 + row);
+    arithmetic(OpCode::Id::MOV, 1, 1, 0, 0);
+    arithmetic(OpCode::Id::MUL, 2, 0x28, 2, 0);
+    arithmetic(OpCode::Id::MOV, 3, 3, 0, 0);
+    arithmetic(OpCode::Id::END, 0, 0, 0, 0);
+
+    setup.program_code.fill(0);
+    std::copy(code.begin(), code.end(), setup.program_code.begin());
+
+    std::mt19937 rng(2);
+    for (auto& f : setup.uniforms.f)
+        for (unsigned comp = 0; comp < 4; ++comp)
+            f[comp] = float24::FromFloat32((rng() % 100) / 10.0f);
+}
+
+/**
+ * Times the transform shader one vertex at a time and in batches, with and without the shader JIT,
+ * and checks that RunBatch matches Run for each of them.
+ */
+static bool BenchmarkTransformShader(unsigned num_vertices) {
+    ShaderSetup& setup = g_state.vs;
+    SetupTransformShader(setup);
+
+    Regs::ShaderConfig config;
+    std::memset(&config, 0, sizeof(config));
+    config.input_register_map.attribute0_register.Assign(0);
+    config.input_register_map.attribute1_register.Assign(1);
+    config.input_register_map.attribute2_register.Assign(2);
+    config.input_register_map.attribute3_register.Assign(3);
+    const int num_attributes = 4;
+
+    std::mt19937 rng(3);
+    std::vector<InputVertex> inputs(4096);
+    for (auto& input : inputs)
+        for (auto& attr : input.attr)
+            for (unsigned comp = 0; comp < 4; ++comp)
+                attr[comp] = float24::FromFloat32((rng() % 100) / 10.0f);
+
+    static UnitState<false> state;
+    static BatchUnitState batch_state;
+    std::vector<OutputRegisters> expected(inputs.size());
+    std::vector<OutputRegisters> outputs(inputs.size());
+
+    bool success = true;
+    for (bool use_jit : { false, true }) {
+#ifndef ARCHITECTURE_x86_64
+        if (use_jit)
+            break;
+#endif
+        VideoCore::g_shader_jit_enabled = use_jit;
+        setup.Setup();
+
+        for (bool batched : { false, true }) {
+            Clock::time_point start = Clock::now();
+            for (unsigned vertex = 0; vertex < num_vertices; vertex += MAX_BATCH_SIZE) {
+                const size_t first = vertex % inputs.size();
+                if (batched) {
+                    setup.RunBatch(state, batch_state, &inputs[first], MAX_BATCH_SIZE, num_attributes, config,
+                                   &outputs[first]);
+                } else {
+                    for (unsigned i = 0; i < MAX_BATCH_SIZE; ++i) {
+                        setup.Run(state, inputs[first + i], num_attributes, config);
+                        outputs[first + i] = state.output_registers;
+                    }
+                }
+            }
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+            if (!batched)
+                expected = outputs;
+            bool match = std::equal(expected.begin(), expected.end(), outputs.begin(), OutputsMatch);
+            success = success && match;
+
+            std::printf("%-11s %-8s %8.1f ns/vertex  %s\n", use_jit ? "JIT" : "Interpreter",
+                        batched ? "RunBatch" : "Run", ns / num_vertices, match ? "" : "MISMATCH");
+        }
+    }
+    return success;
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    unsigned num_programs = 20000;
+    unsigned num_vertices = 1 << 20;
+
+    static struct option long_options[] = {
+        { "programs", required_argument, 0, 'p' },
+        { "vertices", required_argument, 0, 'n' },
+        { "help", no_argument, 0, 'h' },
+        { "version", no_argument, 0, 'v' },
+        { 0, 0, 0, 0 }
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "p:n:hv", long_options, &option_index);
+        if (arg == -1) {
+            PrintHelp(argv[0]);
+            return 1;
+        }
+
+        switch (arg) {
+        case 'p':
+            num_programs = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'n':
+            // Whole batches covering all of the input vertices at least once
+            num_vertices = std::max(4096ul, std::strtoul(optarg, nullptr, 0) & ~4095ul);
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        case 'v':
+            PrintVersion();
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetFilter(&log_filter);
+
+    bool success = true;
+#ifdef ARCHITECTURE_x86_64
+    success = CompareBatchInterpreter(num_programs) && success;
+#endif
+    success = BenchmarkTransformShader(num_vertices) && success;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,314 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <unistd.h>
+#include <getopt.h>
+#endif
+
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/player.h"
+
+#include "video_core/pica.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+/// Renderer which only drives the software rasterizer and never presents anything
+class TraceBenchRenderer final : public RendererBase {
+public:
+    void SwapBuffers() override {
+        RefreshRasterizerSetting();
+        m_current_frame++;
+    }
+
+    void SetWindow(EmuWindow* window) override {}
+
+    bool Init() override {
+        RefreshRasterizerSetting();
+        return true;
+    }
+
+    void ShutDown() override {}
+};
+
+/// Pipeline stages reported per frame, named after their microprofile timers in the "GPU" group
+const char* const stage_names[] = {
+    "Cmdlist Processing",
+    "Vertex Load",
+    "Shader",
+    "Rasterization",
+    "DisplayTransfer",
+};
+const size_t num_stages = sizeof(stage_names) / sizeof(stage_names[0]);
+
+/// MicroProfile only sums up the timers of a frame this many flips after the frame has ended
+const size_t stage_timing_delay = MICROPROFILE_GPU_FRAME_DELAY;
+
+struct FrameResult {
+    float total_ms;
+    float stage_ms[num_stages];
+    u64 framebuffer_hash;
+    u64 bottom_hash;
+};
+
+} // anonymous namespace
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options] <filename.ctf>\n"
+                 "-f, --frames=NUMBER   Only replay the first NUMBER frames of the trace\n"
+                 "-l, --loops=NUMBER    Replay the trace NUMBER times (default: 1)\n"
+                 "-i, --interpreter     Use the shader interpreter instead of the shader JIT\n"
+                 "-q, --quiet           Only print the summary, not the per-frame timings\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "citra-trace-bench " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+/// Sets up just enough of the emulated system to run the GPU without a CPU core or a window
+static void InitEnvironment() {
+    CoreTiming::Init();
+    Memory::Init();
+    HW::Init();
+    Kernel::Init();
+    Pica::Init();
+
+    VideoCore::g_renderer = std::make_unique<TraceBenchRenderer>();
+    VideoCore::g_renderer->Init();
+
+    // Traces refer to physical addresses, so back the whole FCRAM with memory. VRAM is mapped by
+    // the legacy address space setup of the process.
+    Kernel::g_current_process = Kernel::Process::Create(Kernel::CodeSet::Create("citrace", 0));
+    auto fcram = std::make_shared<std::vector<u8>>(Memory::FCRAM_SIZE);
+    Kernel::g_current_process->vm_manager.MapMemoryBlock(
+            Kernel::g_current_process->GetLinearHeapAreaAddress(), std::move(fcram), 0,
+            Memory::FCRAM_SIZE, Kernel::MemoryState::Continuous).Unwrap();
+}
+
+static void ShutdownEnvironment() {
+    VideoCore::g_renderer.reset();
+    Pica::Shutdown();
+    Kernel::Shutdown();
+    HW::Shutdown();
+    CoreTiming::Shutdown();
+}
+
+/// Hashes the framebuffer currently scanned out to the given screen
+static u64 HashFramebuffer(int screen) {
+    const auto& framebuffer = GPU::g_regs.framebuffer_config[screen];
+    PAddr address = framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    const u8* data = Memory::GetPhysicalPointer(address);
+    if (data == nullptr)
+        return 0;
+
+    return Common::ComputeHash64(data, framebuffer.stride * framebuffer.height);
+}
+
+static float ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+static void PrintSummaryLine(const char* name, const std::vector<float>& values) {
+    float sum = 0.0f;
+    float min = values[0];
+    float max = values[0];
+    for (float value : values) {
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    std::printf("%-20s avg %8.3f ms  min %8.3f ms  max %8.3f ms\n", name, sum / values.size(), min, max);
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    size_t max_frames = SIZE_MAX;
+    unsigned loops = 1;
+    bool use_jit = true;
+    bool quiet = false;
+    std::string trace_filename;
+
+    static struct option long_options[] = {
+        { "frames", required_argument, 0, 'f' },
+        { "loops", required_argument, 0, 'l' },
+        { "interpreter", no_argument, 0, 'i' },
+        { "quiet", no_argument, 0, 'q' },
+        { "help", no_argument, 0, 'h' },
+        { "version", no_argument, 0, 'v' },
+        { 0, 0, 0, 0 }
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "f:l:iqhv", long_options, &option_index);
+        if (arg != -1) {
+            switch (arg) {
+            case 'f':
+                max_frames = std::strtoul(optarg, nullptr, 0);
+                break;
+            case 'l':
+                loops = std::max(1ul, std::strtoul(optarg, nullptr, 0));
+                break;
+            case 'i':
+                use_jit = false;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            default:
+                PrintHelp(argv[0]);
+                return 1;
+            }
+        } else {
+            trace_filename = argv[optind];
+            optind++;
+        }
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetFilter(&log_filter);
+
+    MicroProfileOnThreadCreate("TraceBench");
+    MicroProfileSetForceEnable(true);
+    MicroProfileSetEnableAllGroups(true);
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (trace_filename.empty()) {
+        LOG_CRITICAL(Frontend, "No CiTrace file specified");
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    CiTrace::Player player;
+    if (!player.Load(trace_filename)) {
+        LOG_CRITICAL(Frontend, "Failed to load CiTrace file %s", trace_filename.c_str());
+        return 1;
+    }
+
+    size_t num_frames = std::min(player.GetNumFrames(), max_frames);
+    if (num_frames == 0) {
+        LOG_CRITICAL(Frontend, "CiTrace file %s does not contain any complete frames", trace_filename.c_str());
+        return 1;
+    }
+
+    VideoCore::g_hw_renderer_enabled = false;
+    VideoCore::g_shader_jit_enabled = use_jit;
+    Settings::values.shader_cache_size = 64;
+
+    InitEnvironment();
+    SCOPE_EXIT({ ShutdownEnvironment(); });
+
+    std::vector<FrameResult> results;
+    results.reserve(num_frames * loops);
+
+    if (!quiet) {
+        std::printf("loop,frame,total_ms");
+        for (const char* stage : stage_names)
+            std::printf(",%s", stage);
+        std::printf(",top_hash,bottom_hash\n");
+    }
+
+    for (unsigned loop = 0; loop < loops; ++loop) {
+        const size_t first_result = results.size();
+
+        // Ends the frame holding the initial state, so that its setup isn't charged to frame 0
+        player.ApplyInitialState();
+        MicroProfileFlip();
+
+        // Each flip ends a frame and yields the stage timings of the frame ended stage_timing_delay
+        // flips earlier, so a few more flips are needed to get the timings of the last frames
+        for (size_t flip = 0; flip < num_frames + stage_timing_delay; ++flip) {
+            if (flip < num_frames) {
+                Clock::time_point start = Clock::now();
+                player.ReplayFrame(flip);
+                VideoCore::g_renderer->SwapBuffers();
+                Clock::time_point end = Clock::now();
+
+                FrameResult result = {};
+                result.total_ms = ToMilliseconds(end - start);
+                result.framebuffer_hash = HashFramebuffer(0);
+                result.bottom_hash = HashFramebuffer(1);
+                results.push_back(result);
+            }
+
+            MicroProfileFlip();
+
+            if (flip >= stage_timing_delay) {
+                FrameResult& result = results[first_result + flip - stage_timing_delay];
+                for (size_t stage = 0; stage < num_stages; ++stage)
+                    result.stage_ms[stage] = MicroProfileGetTime("GPU", stage_names[stage]);
+            }
+        }
+
+        if (!quiet) {
+            for (size_t frame = 0; frame < num_frames; ++frame) {
+                const FrameResult& result = results[first_result + frame];
+                std::printf("%u,%zu,%.3f", loop, frame, result.total_ms);
+                for (float stage_ms : result.stage_ms)
+                    std::printf(",%.3f", stage_ms);
+                std::printf(",%016" PRIx64 ",%016" PRIx64 "\n", result.framebuffer_hash, result.bottom_hash);
+            }
+        }
+    }
+
+    std::printf("\n%zu frames replayed (%s)\n", results.size(), use_jit ? "shader JIT" : "shader interpreter");
+    std::vector<float> values(results.size());
+    std::transform(results.begin(), results.end(), values.begin(),
+                   [](const FrameResult& result) { return result.total_ms; });
+    PrintSummaryLine("Frame", values);
+
+    for (size_t stage = 0; stage < num_stages; ++stage) {
+        std::transform(results.begin(), results.end(), values.begin(),
+                       [stage](const FrameResult& result) { return result.stage_ms[stage]; });
+        PrintSummaryLine(stage_names[stage], values);
+    }
+
+    // Runs are deterministic, so the hash of the final top screen image identifies the output
+    std::printf("Final top screen hash: %016" PRIx64 "\n", results.back().framebuffer_hash);
+
+    return 0;
+}
@@ -122,7 +122,7 @@ public:
             else
             {
                 int bit = LeastSignificantSetBit(m_val);
-                m_val &= ~(1 << bit);
+                m_val &= ~((IntTy)1 << bit);
                 m_bit = bit;
             }
             return *this;
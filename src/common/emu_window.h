@@ -62,6 +62,15 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /**
+     * Presents a frame composed on the CPU, for renderers which don't draw through the graphics
+     * context of the window. By default, the frame is discarded.
+     * @param pixels Frame in XRGB8888 (0xFFRRGGBB words), rows from top to bottom
+     * @param width Frame width in pixels, the width of the current framebuffer layout
+     * @param height Frame height in pixels, the height of the current framebuffer layout
+     */
+    virtual void PresentFrame(const u32* pixels, unsigned width, unsigned height) {}
+
     /**
      * Signal that a touch pressed event has occurred (e.g. mouse click pressed)
      * @param framebuffer_x Framebuffer x-coordinate that was pressed
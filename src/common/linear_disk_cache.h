@@ -4,11 +4,12 @@
 
 #pragma once
 
-#include "common/common_types.h"
+#include <cstring>
 #include <fstream>
 
-// defined in Version.cpp
-extern const char *scm_rev_git_str;
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/scm_rev.h"
 
 // On disk format:
 //header{
@@ -173,7 +174,7 @@ private:
             , key_t_size(sizeof(K))
             , value_t_size(sizeof(V))
         {
-            memcpy(ver, scm_rev_git_str, 40);
+            strncpy(ver, Common::g_scm_rev, sizeof(ver));
         }
 
         const u32 id;
@@ -0,0 +1,71 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Unbounded lock-free queue with any number of producers and a single consumer, based on Dmitry
+ * Vyukov's intrusive MPSC node queue. Push never blocks and may be called from any thread, Pop
+ * must only be called from the consuming thread.
+ *
+ * A Push which is still in progress while Pop runs may not be visible yet; the element is
+ * returned by a later Pop instead.
+ */
+template <typename T>
+class MPSCQueue : NonCopyable {
+public:
+    MPSCQueue() : head(new Node), tail(head.load(std::memory_order_relaxed)) {}
+
+    ~MPSCQueue() {
+        T value;
+        while (Pop(value)) {}
+        delete tail;
+    }
+
+    void Push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Removes the oldest element from the queue
+     * @param value Receives the element
+     * @return false if the queue was empty
+     */
+    bool Pop(T& value) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+
+        // The popped node becomes the new stub, so only its value is moved out
+        value = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T value) : value(std::move(value)) {}
+
+        T value{};
+        std::atomic<Node*> next{nullptr};
+    };
+
+    /// Most recently pushed node, shared between producers
+    std::atomic<Node*> head;
+    /// Stub node preceding the oldest element, only touched by the consumer
+    Node* tail;
+};
+
+} // namespace Common
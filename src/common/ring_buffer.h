@@ -0,0 +1,100 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Fixed-size lock-free ring buffer with a single producer and a single consumer. Push must only be
+ * called from the producing thread and Pop from the consuming thread; Size may be called from
+ * either and never blocks. Nothing is allocated after construction.
+ *
+ * @tparam T Element type, which must be trivially copyable
+ * @tparam capacity Number of slots, a power of two
+ * @tparam granularity Number of elements per slot, e.g. 2 for interleaved stereo samples
+ */
+template <typename T, size_t capacity, size_t granularity = 1>
+class RingBuffer final : NonCopyable {
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(granularity > 0, "granularity must be at least one");
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+    static constexpr size_t slot_size = granularity * sizeof(T);
+
+public:
+    /**
+     * Appends slots to the ring. Slots which don't fit are dropped.
+     * @param new_slots Pointer to slot_count * granularity elements
+     * @return The number of slots actually pushed
+     */
+    size_t Push(const void* new_slots, size_t slot_count) {
+        const size_t write_index = this->write_index.load(std::memory_order_relaxed);
+        const size_t slots_free = capacity - (write_index - read_index.load(std::memory_order_acquire));
+        const size_t push_count = std::min(slot_count, slots_free);
+
+        const size_t pos = write_index % capacity;
+        const size_t first_copy = std::min(capacity - pos, push_count);
+        const size_t second_copy = push_count - first_copy;
+
+        const u8* in = static_cast<const u8*>(new_slots);
+        std::memcpy(&data[pos * granularity], in, first_copy * slot_size);
+        std::memcpy(&data[0], in + first_copy * slot_size, second_copy * slot_size);
+
+        this->write_index.store(write_index + push_count, std::memory_order_release);
+        return push_count;
+    }
+
+    /**
+     * Removes the oldest slots from the ring.
+     * @param output Pointer to room for max_slots * granularity elements
+     * @return The number of slots actually popped
+     */
+    size_t Pop(void* output, size_t max_slots) {
+        const size_t read_index = this->read_index.load(std::memory_order_relaxed);
+        const size_t slots_filled = write_index.load(std::memory_order_acquire) - read_index;
+        const size_t pop_count = std::min(slots_filled, max_slots);
+
+        const size_t pos = read_index % capacity;
+        const size_t first_copy = std::min(capacity - pos, pop_count);
+        const size_t second_copy = pop_count - first_copy;
+
+        u8* out = static_cast<u8*>(output);
+        std::memcpy(out, &data[pos * granularity], first_copy * slot_size);
+        std::memcpy(out + first_copy * slot_size, &data[0], second_copy * slot_size);
+
+        this->read_index.store(read_index + pop_count, std::memory_order_release);
+        return pop_count;
+    }
+
+    /// Number of slots waiting to be popped, in O(1)
+    size_t Size() const {
+        return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_acquire);
+    }
+
+    /// Maximum number of slots the ring can hold
+    constexpr size_t Capacity() const {
+        return capacity;
+    }
+
+private:
+    // The indices only ever increase and wrap around together with size_t, so their difference is
+    // always the fill level. Each one is written by a single thread and lives on its own cache
+    // line, so the producer and the consumer don't contend for it.
+    alignas(64) std::atomic<size_t> read_index{0};
+    alignas(64) std::atomic<size_t> write_index{0};
+
+    std::array<T, granularity * capacity> data;
+};
+
+} // namespace Common
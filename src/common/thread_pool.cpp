@@ -0,0 +1,94 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t num_workers, const std::string& name) : next_index(0) {
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, name + " " + std::to_string(i));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_available.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+size_t ThreadPool::DefaultNumWorkers() {
+    // Leave a hardware thread each to the emulation and the GPU thread, one of which calls ParallelFor
+    unsigned num_threads = std::thread::hardware_concurrency();
+    return num_threads > 2 ? num_threads - 2 : 0;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> call_lock(call_mutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        job_count = count;
+        next_index = 0;
+        busy_workers = workers.size();
+        ++job_generation;
+    }
+    job_available.notify_all();
+
+    RunJob(func, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job_done.wait(lock, [this] { return busy_workers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::RunJob(const std::function<void(size_t)>& func, size_t count) {
+    for (size_t i = next_index++; i < count; i = next_index++)
+        func(i);
+}
+
+void ThreadPool::WorkerLoop(std::string name) {
+    SetCurrentThreadName(name.c_str());
+    MicroProfileOnThreadCreate(name.c_str());
+
+    u64 last_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        job_available.wait(lock, [&] { return stop || job_generation != last_generation; });
+        if (stop)
+            break;
+
+        last_generation = job_generation;
+        const auto& func = *job;
+        size_t count = job_count;
+
+        lock.unlock();
+        RunJob(func, count);
+        lock.lock();
+
+        if (--busy_workers == 0)
+            job_done.notify_one();
+    }
+    lock.unlock();
+
+    // MicroProfile only has room for a few dozen threads, so pools which are recreated need to
+    // give their logs back
+    MicroProfileOnThreadExit();
+}
+
+} // namespace
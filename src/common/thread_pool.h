@@ -0,0 +1,74 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Fixed set of worker threads for data-parallel loops. The calling thread takes part in every
+ * loop, so a pool without workers simply runs loops inline.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param num_workers Number of worker threads to start in addition to the calling thread
+     * @param name Name of the worker threads, used for debugging and profiling
+     */
+    ThreadPool(size_t num_workers, const std::string& name);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Returns the number of threads taking part in a ParallelFor, including the calling thread
+    size_t GetNumThreads() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Calls func(i) for every i in [0, count), distributing the indices over the worker threads
+     * and the calling thread, and returns once all calls have completed. Indices are handed out
+     * in increasing order, but may complete in any order. Concurrent calls are serialized.
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+    /// Returns the number of worker threads to use so that the pool and the emulation keep every hardware thread busy
+    static size_t DefaultNumWorkers();
+
+private:
+    void WorkerLoop(std::string name);
+    void RunJob(const std::function<void(size_t)>& func, size_t count);
+
+    std::vector<std::thread> workers;
+
+    /// Serializes ParallelFor calls from different threads
+    std::mutex call_mutex;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_count = 0;
+    /// Incremented for every job, so that workers can tell a new job from a spurious wakeup
+    u64 job_generation = 0;
+    /// Number of workers which have not finished the current job yet
+    size_t busy_workers = 0;
+    bool stop = false;
+
+    std::atomic<size_t> next_index;
+};
+
+} // namespace
@@ -0,0 +1,16 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+// Marks a function which uses AVX2 intrinsics, so that it can live in a file compiled for the
+// baseline instruction set and be called once Common::GetCPUCaps().avx2 has been checked.
+//
+// Only AVX2 is enabled, not FMA, so that multiplications and additions are never contracted and
+// results stay identical to the generic implementations.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
@@ -1,3 +1,12 @@
+#include <algorithm>
+#include <cstring>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+
 #include "core/aes/aes.h"
 
 namespace AES {
@@ -94,15 +103,107 @@ void AddCtr(std::array<u8, 16>& ctr, u32 carry) {
 
 void AesCtrDecrypt(void* data, u64 length, const std::array<u8, 16>& key,
                    const std::array<u8, 16>& ctr) {
-    u8* p = reinterpret_cast<u8*>(data);
-    std::array<u8, 16> c(ctr), xorpad;
+    AesCtrCipher(key, ctr).Transform(data, static_cast<size_t>(length), 0);
+}
+
+/// Adds a 64-bit value to the big-endian 128-bit counter
+static void AddCtr64(std::array<u8, 16>& ctr, u64 value) {
+    AddCtr(ctr, static_cast<u32>(value));
+    u32 high = static_cast<u32>(value >> 32);
+    if (high == 0)
+        return;
+
+    // Add the high word to the upper 96 bits of the counter
+    std::array<u8, 16> upper{};
+    std::copy(ctr.begin(), ctr.begin() + 12, upper.begin() + 4);
+    AddCtr(upper, high);
+    std::copy(upper.begin() + 4, upper.end(), ctr.begin());
+}
+
+#ifdef ARCHITECTURE_x86_64
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("aes,sse2")))
+#endif
+static void EncryptBlocksAesNi(u8* blocks, size_t count, const RoundKeys& round_keys) {
+    // The round keys produced by ExpandKey have the byte layout AESENC expects
+    __m128i keys[11];
+    for (int i = 0; i < 11; ++i)
+        keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys.data() + i * 16));
+
+    __m128i* data = reinterpret_cast<__m128i*>(blocks);
+    size_t i = 0;
+
+    // Interleave four blocks to hide the latency of AESENC
+    for (; i + 4 <= count; i += 4) {
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(data + i + 0), keys[0]);
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(data + i + 1), keys[0]);
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(data + i + 2), keys[0]);
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(data + i + 3), keys[0]);
+        for (int round = 1; round < 10; ++round) {
+            b0 = _mm_aesenc_si128(b0, keys[round]);
+            b1 = _mm_aesenc_si128(b1, keys[round]);
+            b2 = _mm_aesenc_si128(b2, keys[round]);
+            b3 = _mm_aesenc_si128(b3, keys[round]);
+        }
+        _mm_storeu_si128(data + i + 0, _mm_aesenclast_si128(b0, keys[10]));
+        _mm_storeu_si128(data + i + 1, _mm_aesenclast_si128(b1, keys[10]));
+        _mm_storeu_si128(data + i + 2, _mm_aesenclast_si128(b2, keys[10]));
+        _mm_storeu_si128(data + i + 3, _mm_aesenclast_si128(b3, keys[10]));
+    }
+
+    for (; i < count; ++i) {
+        __m128i b = _mm_xor_si128(_mm_loadu_si128(data + i), keys[0]);
+        for (int round = 1; round < 10; ++round)
+            b = _mm_aesenc_si128(b, keys[round]);
+        _mm_storeu_si128(data + i, _mm_aesenclast_si128(b, keys[10]));
+    }
+}
+#endif // ARCHITECTURE_x86_64
+
+AesCtrCipher::AesCtrCipher(const std::array<u8, 16>& key, const std::array<u8, 16>& ctr, bool allow_aes_ni)
+    : round_keys(ExpandKey(key)), ctr(ctr) {
+#ifdef ARCHITECTURE_x86_64
+    use_aes_ni = allow_aes_ni && Common::GetCPUCaps().aes;
+#else
+    use_aes_ni = false;
+#endif
+}
+
+void AesCtrCipher::EncryptBlocks(u8* blocks, size_t count) const {
+#ifdef ARCHITECTURE_x86_64
+    if (use_aes_ni) {
+        EncryptBlocksAesNi(blocks, count, round_keys);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+        EncryptBlock(blocks + i * 16, round_keys);
+}
+
+void AesCtrCipher::Transform(void* data, size_t length, u64 offset) const {
+    const size_t BATCH_BLOCKS = 64;
+    std::array<u8, BATCH_BLOCKS * 16> keystream;
+
+    u8* p = static_cast<u8*>(data);
+    std::array<u8, 16> c(ctr);
+    AddCtr64(c, offset / 16);
+    size_t skip = offset % 16;
+
     while (length > 0) {
-        xorpad = AesCipher(c, key);
-        AddCtr(c, 1);
-        u64 l = length > 16 ? 16 : length;
-        for (u64 j = 0; j < l; ++j)
-            *(p++) ^= xorpad[j];
-        length -= l;
+        size_t num_blocks = std::min(BATCH_BLOCKS, (skip + length + 15) / 16);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            std::memcpy(&keystream[i * 16], c.data(), 16);
+            AddCtr(c, 1);
+        }
+        EncryptBlocks(keystream.data(), num_blocks);
+
+        size_t n = std::min(length, num_blocks * 16 - skip);
+        for (size_t i = 0; i < n; ++i)
+            p[i] ^= keystream[skip + i];
+
+        p += n;
+        length -= n;
+        skip = 0;
     }
 }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 
 #include "common/common_types.h"
 
@@ -12,12 +13,45 @@ extern const std::array<u8, 16> SLOT25_KEY_X;
 extern const std::array<u8, 16> SLOT2C_KEY_X; // placeholder
 extern const std::array<u8, 16> ZERO_KEY;
 
+/// Expanded AES-128 key schedule, 11 round keys of 16 bytes
+using RoundKeys = std::array<u8, 176>;
+
 std::array<u8, 16> MakeKey(int slot, const std::array<u8, 16>& y);
 void AddCtr(std::array<u8, 16>& ctr, u32 carry);
+RoundKeys ExpandKey(const std::array<u8, 16>& key);
+void EncryptBlock(u8* block, const RoundKeys& round_keys);
 std::array<u8, 16> AesCipher(const std::array<u8, 16>& input, const std::array<u8, 16>& key);
 void AesCtrDecrypt(void* data, u64 length, const std::array<u8, 16>& key,
                    const std::array<u8, 16>& ctr);
 
+/**
+ * AES-128 in CTR mode with the key schedule expanded once, for decrypting large streams.
+ * Keystream blocks are generated in batches, using AES-NI when the host CPU supports it.
+ */
+class AesCtrCipher {
+public:
+    /**
+     * @param allow_aes_ni Set to false to always use the portable implementation, e.g. to check
+     *                     the AES-NI path against it
+     */
+    AesCtrCipher(const std::array<u8, 16>& key, const std::array<u8, 16>& ctr, bool allow_aes_ni = true);
+
+    /**
+     * Decrypts (or encrypts) a part of the stream in place
+     * @param data Data to transform
+     * @param length Size of the data in bytes
+     * @param offset Byte offset of the data from the start of the stream
+     */
+    void Transform(void* data, size_t length, u64 offset) const;
+
+private:
+    void EncryptBlocks(u8* blocks, size_t count) const;
+
+    RoundKeys round_keys;
+    std::array<u8, 16> ctr;
+    bool use_aes_ni;
+};
+
 struct AesContext {
     std::array<u8, 16> key, ctr;
     bool encrypted;
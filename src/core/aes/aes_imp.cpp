@@ -17,17 +17,10 @@
 #define Nr 10
 
 /*****************************************************************************/
-/* Private variables:                                                        */
+/* Private types:                                                            */
 /*****************************************************************************/
 // state - array holding the intermediate results during decryption.
 typedef u8 state_t[4][4];
-static state_t* state;
-
-// The array that stores the round keys.
-static u8 RoundKey[176];
-
-// The Key input to the AES Program
-static const u8* Key;
 
 // The lookup-tables are marked const so they can be placed in read-only storage instead of RAM
 // The numbers below can be computed dynamically trading ROM for RAM -
@@ -78,7 +71,7 @@ static const u8 Rcon[255] = {
 
 // This function produces Nb(Nr+1) round keys. The round keys are used in each round to decrypt the
 // states.
-static void KeyExpansion(void) {
+static void KeyExpansion(u8* RoundKey, const u8* Key) {
     u32 i, j, k;
     u8 tempa[4]; // Used for the column/row operations
 
@@ -132,7 +125,7 @@ static void KeyExpansion(void) {
 
 // This function adds the round key to state.
 // The round key is added to the state by an XOR function.
-static void AddRoundKey(u8 round) {
+static void AddRoundKey(u8 round, state_t* state, const u8* RoundKey) {
     u8 i, j;
     for (i = 0; i < 4; ++i) {
         for (j = 0; j < 4; ++j) {
@@ -143,7 +136,7 @@ static void AddRoundKey(u8 round) {
 
 // The SubBytes Function Substitutes the values in the
 // state matrix with values in an S-box.
-static void SubBytes(void) {
+static void SubBytes(state_t* state) {
     u8 i, j;
     for (i = 0; i < 4; ++i) {
         for (j = 0; j < 4; ++j) {
@@ -155,7 +148,7 @@ static void SubBytes(void) {
 // The ShiftRows() function shifts the rows in the state to the left.
 // Each row is shifted with different offset.
 // Offset = Row number. So the first row is not shifted.
-static void ShiftRows(void) {
+static void ShiftRows(state_t* state) {
     u8 temp;
 
     // Rotate first row 1 columns to left
@@ -187,7 +180,7 @@ static u8 xtime(u8 x) {
 }
 
 // MixColumns function mixes the columns of the state matrix
-static void MixColumns(void) {
+static void MixColumns(state_t* state) {
     u8 i;
     u8 Tmp, Tm, t;
     for (i = 0; i < 4; ++i) {
@@ -216,36 +209,43 @@ static u8 Multiply(u8 x, u8 y) {
 }
 
 // Cipher is the main function that encrypts the PlainText.
-static void Cipher(void) {
+static void Cipher(state_t* state, const u8* RoundKey) {
     u8 round = 0;
 
     // Add the First round key to the state before starting the rounds.
-    AddRoundKey(0);
+    AddRoundKey(0, state, RoundKey);
 
     // There will be Nr rounds.
     // The first Nr-1 rounds are identical.
     // These Nr-1 rounds are executed in the loop below.
     for (round = 1; round < Nr; ++round) {
-        SubBytes();
-        ShiftRows();
-        MixColumns();
-        AddRoundKey(round);
+        SubBytes(state);
+        ShiftRows(state);
+        MixColumns(state);
+        AddRoundKey(round, state, RoundKey);
     }
 
     // The last round is given below.
     // The MixColumns function is not here in the last round.
-    SubBytes();
-    ShiftRows();
-    AddRoundKey(Nr);
+    SubBytes(state);
+    ShiftRows(state);
+    AddRoundKey(Nr, state, RoundKey);
 }
 
 namespace AES {
+RoundKeys ExpandKey(const std::array<u8, 16>& key) {
+    RoundKeys round_keys;
+    KeyExpansion(round_keys.data(), key.data());
+    return round_keys;
+}
+
+void EncryptBlock(u8* block, const RoundKeys& round_keys) {
+    Cipher((state_t*)block, round_keys.data());
+}
+
 std::array<u8, 16> AesCipher(const std::array<u8, 16>& input, const std::array<u8, 16>& key) {
     std::array<u8, 16> output(input);
-    state = (state_t*)output.data();
-    Key = key.data();
-    KeyExpansion();
-    Cipher();
+    EncryptBlock(output.data(), ExpandKey(key));
     return output;
 }
 }
@@ -9,8 +9,11 @@
 
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
+#include "core/arm/dyncom/arm_dyncom_trans.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/vm_manager.h"
 #include "core/hle/svc.h"
 #include "core/memory.h"
 
@@ -36,8 +39,20 @@ static void InterpreterFallback(u32 pc, Dynarmic::Jit* jit, void* user_arg) {
 }
 
 static bool IsReadOnlyMemory(u32 vaddr) {
-    // TODO(bunnei): ImplementMe
-    return false;
+    // The JIT folds loads from read-only memory into constants, so only report code segments.
+    // Other read-only mappings, like the shared page and config memory, are updated by HLE.
+    if (Kernel::g_current_process == nullptr)
+        return false;
+
+    const Kernel::VMManager& vm_manager = Kernel::g_current_process->vm_manager;
+    auto vma = vm_manager.FindVMA(vaddr);
+    if (vma == vm_manager.vma_map.end() || vma->second.type == Kernel::VMAType::Free)
+        return false;
+
+    const Kernel::VirtualMemoryArea& area = vma->second;
+    return area.meminfo_state == Kernel::MemoryState::Code &&
+           (area.permissions == Kernel::VMAPermission::Read ||
+            area.permissions == Kernel::VMAPermission::ReadExecute);
 }
 
 static Dynarmic::UserCallbacks GetUserCallbacks(ARMul_State* interpeter_state) {
@@ -54,6 +69,9 @@ static Dynarmic::UserCallbacks GetUserCallbacks(ARMul_State* interpeter_state) {
     user_callbacks.MemoryWrite16 = &Memory::Write16;
     user_callbacks.MemoryWrite32 = &Memory::Write32;
     user_callbacks.MemoryWrite64 = &Memory::Write64;
+    // Pages of regular memory are accessed directly by the generated code. All other pages have a
+    // null entry, which makes the JIT fall back to the callbacks above.
+    user_callbacks.page_table = Memory::GetCurrentPageTablePointers();
     return user_callbacks;
 }
 
@@ -164,4 +182,5 @@ void ARM_Dynarmic::PrepareReschedule() {
 
 void ARM_Dynarmic::ClearInstructionCache() {
     jit->ClearCache();
+    trans_cache.Clear();
 }
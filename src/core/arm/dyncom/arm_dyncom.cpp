@@ -25,8 +25,7 @@ ARM_DynCom::~ARM_DynCom() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
-    trans_cache_buf_top = 0;
+    trans_cache.Clear();
 }
 
 void ARM_DynCom::SetPC(u32 pc) {
@@ -9,14 +9,74 @@
 #include "core/arm/skyeye_common/armsupp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
 
-char trans_cache_buf[TRANS_CACHE_SIZE];
-size_t trans_cache_buf_top = 0;
+TranslationCache trans_cache;
+
+TranslationCache::Page::Page() {
+    blocks.fill(-1);
+}
+
+int TranslationCache::BeginBlock(u32 addr) {
+    if (buffer_top + MAX_BLOCK_SIZE > (current_region + 1) * REGION_SIZE) {
+        current_region = (current_region + 1) % NUM_REGIONS;
+        buffer_top = current_region * REGION_SIZE;
+        EvictRegion(current_region);
+    }
+
+    std::unique_ptr<Page>& page = pages[addr >> Memory::PAGE_BITS];
+    if (page == nullptr)
+        page = std::make_unique<Page>();
+
+    int& entry = page->blocks[(addr & Memory::PAGE_MASK) >> 1];
+    if (entry == -1)
+        page->num_blocks++;
+    entry = static_cast<int>(buffer_top);
+
+    region_blocks[current_region].push_back(addr);
+    return entry;
+}
+
+void* TranslationCache::Alloc(size_t size) {
+    size_t start = buffer_top;
+    buffer_top += size;
+    ASSERT_MSG(buffer_top <= (current_region + 1) * REGION_SIZE, "Translated block exceeds MAX_BLOCK_SIZE!");
+    return static_cast<void*>(&buffer[start]);
+}
+
+void TranslationCache::EvictRegion(size_t region) {
+    const int region_start = static_cast<int>(region * REGION_SIZE);
+    const int region_end = static_cast<int>(region_start + REGION_SIZE);
+
+    for (u32 addr : region_blocks[region]) {
+        std::unique_ptr<Page>& page = pages[addr >> Memory::PAGE_BITS];
+        if (page == nullptr)
+            continue;
+
+        // Only drop the entry while it still refers to a block of this region
+        int& entry = page->blocks[(addr & Memory::PAGE_MASK) >> 1];
+        if (entry < region_start || entry >= region_end)
+            continue;
+
+        entry = -1;
+        if (--page->num_blocks == 0)
+            page.reset();
+    }
+    region_blocks[region].clear();
+}
+
+void TranslationCache::Clear() {
+    // Every page with translated blocks is referenced by at least one region
+    for (auto& blocks : region_blocks) {
+        for (u32 addr : blocks)
+            pages[addr >> Memory::PAGE_BITS].reset();
+        blocks.clear();
+    }
+
+    buffer_top = 0;
+    current_region = 0;
+}
 
 static void* AllocBuffer(size_t size) {
-    size_t start = trans_cache_buf_top;
-    trans_cache_buf_top += size;
-    ASSERT_MSG(trans_cache_buf_top <= TRANS_CACHE_SIZE, "Translation cache is full!");
-    return static_cast<void*>(&trans_cache_buf[start]);
+    return trans_cache.Alloc(size);
 }
 
 #define glue(x, y) x ## y
@@ -1,3 +1,14 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "common/common_types.h"
+
+#include "core/memory.h"
+
 struct ARMul_State;
 typedef unsigned int (*shtop_fp_t)(ARMul_State* cpu, unsigned int sht_oper);
 
@@ -488,6 +499,68 @@ typedef ARM_INST_PTR (*transop_fp_t)(unsigned int, int);
 extern const transop_fp_t arm_instruction_trans[];
 extern const size_t arm_instruction_trans_len;
 
-#define TRANS_CACHE_SIZE (64 * 1024 * 2000)
-extern char trans_cache_buf[TRANS_CACHE_SIZE];
-extern size_t trans_cache_buf_top;
+/**
+ * Storage and lookup for translated basic blocks.
+ *
+ * Blocks never cross a page boundary (the translator ends them with END_OF_PAGE), so lookups are
+ * indexed by page and by halfword offset within the page.
+ *
+ * The buffer is split into regions which are filled one after another. When the last region is
+ * full, allocation wraps around and the oldest region is evicted, dropping every block stored in
+ * it, so the cache stays bounded without ever having to be flushed completely.
+ */
+class TranslationCache {
+public:
+    static constexpr size_t NUM_REGIONS = 16;
+    static constexpr size_t REGION_SIZE = 4 * 1024 * 1024;
+
+    /// Upper bound on the size of a block: a page full of Thumb instructions with the largest cream
+    static constexpr size_t MAX_BLOCK_SIZE = (Memory::PAGE_SIZE / 2) * 64;
+
+    /// Returns the buffer offset of the block starting at addr, or -1 if it is not translated
+    int Find(u32 addr) const {
+        const Page* page = pages[addr >> Memory::PAGE_BITS].get();
+        if (page == nullptr)
+            return -1;
+        return page->blocks[(addr & Memory::PAGE_MASK) >> 1];
+    }
+
+    /**
+     * Starts translating a new block, evicting the oldest region if the current one can't hold it.
+     * @param addr Address of the first instruction of the block
+     * @return Buffer offset the block will be stored at
+     */
+    int BeginBlock(u32 addr);
+
+    /// Allocates space for an instruction cream of the block currently being translated
+    void* Alloc(size_t size);
+
+    arm_inst* GetInstruction(int offset) {
+        return reinterpret_cast<arm_inst*>(&buffer[offset]);
+    }
+
+    /// Drops all translated blocks
+    void Clear();
+
+private:
+    struct Page {
+        Page();
+
+        /// Buffer offset of the block starting at each halfword of the page, or -1
+        std::array<int, Memory::PAGE_SIZE / 2> blocks;
+        /// Number of valid entries in blocks
+        size_t num_blocks = 0;
+    };
+
+    void EvictRegion(size_t region);
+
+    std::array<char, NUM_REGIONS * REGION_SIZE> buffer;
+    size_t buffer_top = 0;
+    size_t current_region = 0;
+
+    std::array<std::unique_ptr<Page>, (1ULL << (32 - Memory::PAGE_BITS))> pages;
+    /// Start addresses of the blocks stored in each region, used to unlink them on eviction
+    std::array<std::vector<u32>, NUM_REGIONS> region_blocks;
+};
+
+extern TranslationCache trans_cache;
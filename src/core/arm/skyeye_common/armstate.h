@@ -18,7 +18,6 @@
 #pragma once
 
 #include <array>
-#include <unordered_map>
 
 #include "common/common_types.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
@@ -236,10 +235,6 @@ public:
     unsigned bigendSig;
     unsigned syscallSig;
 
-    // TODO(bunnei): Move this cache to a better place - it should be per codeset (likely per
-    // process for our purposes), not per ARMul_State (which tracks CPU core state).
-    std::unordered_map<u32, int> instruction_cache;
-
 private:
     void ResetMPCoreCP15Registers();
 
@@ -2,13 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
 #include <cinttypes>
-#include <mutex>
+#include <unordered_map>
 #include <vector>
 
-#include "common/chunk_file.h"
 #include "common/logging/log.h"
+#include "common/mpsc_queue.h"
 #include "common/string_util.h"
 
 #include "core/arm/arm_interface.h"
@@ -43,16 +44,25 @@ struct BaseEvent
     int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
-
-static Event* first;
-static Event* ts_first;
-static Event* ts_last;
+struct Event : BaseEvent
+{
+    /// Events scheduled for the same time fire in the order they were scheduled in
+    u64 fifo_order;
+    /// Position of this event in event_queue
+    size_t heap_index;
+};
 
-// event pools
-static Event* event_pool = nullptr;
-static Event* event_ts_pool = nullptr;
-static int allocated_ts_events = 0;
+// Pending events are kept in a binary min-heap of indices into the event slots, so that an event
+// can be removed from the middle of the heap in O(log n) once its slot is known. Slots are looked
+// up by userdata, which is unique among events of the same type in practice.
+static std::vector<Event> event_slots;
+static std::vector<u32> free_event_slots;
+static std::vector<u32> event_queue;
+static std::unordered_multimap<u64, u32> event_slots_by_userdata;
+static u64 event_fifo_order;
+
+// Events scheduled from other threads, moved into the queue by the CPU thread.
+static Common::MPSCQueue<BaseEvent> ts_queue;
 // Optimization to skip MoveEvents when possible.
 static std::atomic<bool> has_ts_events(false);
 
@@ -63,8 +73,6 @@ static s64 idled_cycles;
 static s64 last_global_time_ticks;
 static s64 last_global_time_us;
 
-static std::recursive_mutex external_event_section;
-
 // Warning: not included in save state.
 using AdvanceCallback = void(int cycles_executed);
 static AdvanceCallback* advance_callback = nullptr;
@@ -98,35 +106,95 @@ u64 GetGlobalTimeUs() {
     return last_global_time_us + us_since_last;
 }
 
-static Event* GetNewEvent() {
-    if (!event_pool)
-        return new Event;
+static bool EventBefore(u32 a, u32 b) {
+    const Event& event_a = event_slots[a];
+    const Event& event_b = event_slots[b];
+    if (event_a.time != event_b.time)
+        return event_a.time < event_b.time;
+    return event_a.fifo_order < event_b.fifo_order;
+}
 
-    Event* event = event_pool;
-    event_pool = event->next;
-    return event;
+static void SetQueueEntry(size_t index, u32 slot) {
+    event_queue[index] = slot;
+    event_slots[slot].heap_index = index;
 }
 
-static Event* GetNewTsEvent() {
-    allocated_ts_events++;
+static void SiftUp(size_t index) {
+    u32 slot = event_queue[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!EventBefore(slot, event_queue[parent]))
+            break;
+        SetQueueEntry(index, event_queue[parent]);
+        index = parent;
+    }
+    SetQueueEntry(index, slot);
+}
 
-    if (!event_ts_pool)
-        return new Event;
+static void SiftDown(size_t index) {
+    u32 slot = event_queue[index];
+    const size_t size = event_queue.size();
+    for (;;) {
+        size_t child = index * 2 + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && EventBefore(event_queue[child + 1], event_queue[child]))
+            child++;
+        if (!EventBefore(event_queue[child], slot))
+            break;
+        SetQueueEntry(index, event_queue[child]);
+        index = child;
+    }
+    SetQueueEntry(index, slot);
+}
 
-    Event* event = event_ts_pool;
-    event_ts_pool = event->next;
-    return event;
+static const Event* GetFirstEvent() {
+    return event_queue.empty() ? nullptr : &event_slots[event_queue.front()];
 }
 
-static void FreeEvent(Event* event) {
-    event->next = event_pool;
-    event_pool = event;
+static void AddEventToQueue(const BaseEvent& new_event) {
+    u32 slot;
+    if (free_event_slots.empty()) {
+        slot = static_cast<u32>(event_slots.size());
+        event_slots.emplace_back();
+    } else {
+        slot = free_event_slots.back();
+        free_event_slots.pop_back();
+    }
+
+    Event& event = event_slots[slot];
+    static_cast<BaseEvent&>(event) = new_event;
+    event.fifo_order = event_fifo_order++;
+
+    event_queue.push_back(slot);
+    SiftUp(event_queue.size() - 1);
+    event_slots_by_userdata.emplace(new_event.userdata, slot);
 }
 
-static void FreeTsEvent(Event* event) {
-    event->next = event_ts_pool;
-    event_ts_pool = event;
-    allocated_ts_events--;
+/// Removes the event in the given slot from the queue and returns it
+static BaseEvent RemoveEventFromQueue(u32 slot) {
+    const Event& event = event_slots[slot];
+    BaseEvent removed = event;
+
+    size_t index = event.heap_index;
+    u32 last = event_queue.back();
+    event_queue.pop_back();
+    if (index < event_queue.size()) {
+        SetQueueEntry(index, last);
+        SiftDown(index);
+        SiftUp(event_slots[last].heap_index);
+    }
+
+    auto range = event_slots_by_userdata.equal_range(removed.userdata);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == slot) {
+            event_slots_by_userdata.erase(it);
+            break;
+        }
+    }
+
+    free_event_slots.push_back(slot);
+    return removed;
 }
 
 int RegisterEvent(const char* name, TimedCallback callback) {
@@ -147,7 +215,7 @@ void RestoreRegisterEvent(int event_type, const char* name, TimedCallback callba
 }
 
 void UnregisterAllEvents() {
-    if (first)
+    if (!event_queue.empty())
         LOG_ERROR(Core_Timing, "Cannot unregister events with events pending");
     event_types.clear();
 }
@@ -162,13 +230,11 @@ void Init() {
     has_ts_events = 0;
     mhz_change_callbacks.clear();
 
-    first = nullptr;
-    ts_first = nullptr;
-    ts_last = nullptr;
-
-    event_pool = nullptr;
-    event_ts_pool = nullptr;
-    allocated_ts_events = 0;
+    event_slots.clear();
+    free_event_slots.clear();
+    event_queue.clear();
+    event_slots_by_userdata.clear();
+    event_fifo_order = 0;
 
     advance_callback = nullptr;
 }
@@ -177,19 +243,6 @@ void Shutdown() {
     MoveEvents();
     ClearPendingEvents();
     UnregisterAllEvents();
-
-    while (event_pool) {
-        Event* event = event_pool;
-        event_pool = event->next;
-        delete event;
-    }
-
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    while (event_ts_pool) {
-        Event* event = event_ts_pool;
-        event_ts_pool = event->next;
-        delete event;
-    }
 }
 
 u64 GetTicks() {
@@ -204,17 +257,11 @@ u64 GetIdleTicks() {
 // This is to be called when outside threads, such as the graphics thread, wants to
 // schedule things to be executed on the main thread.
 void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userdata) {
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    Event* new_event = GetNewTsEvent();
-    new_event->time = GetTicks() + cycles_into_future;
-    new_event->type = event_type;
-    new_event->next = nullptr;
-    new_event->userdata = userdata;
-    if (!ts_first)
-        ts_first = new_event;
-    if (ts_last)
-        ts_last->next = new_event;
-    ts_last = new_event;
+    BaseEvent new_event;
+    new_event.time = GetTicks() + cycles_into_future;
+    new_event.type = event_type;
+    new_event.userdata = userdata;
+    ts_queue.Push(new_event);
 
     has_ts_events = true;
 }
@@ -224,7 +271,6 @@ void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userda
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata) {
     if (false) //Core::IsCPUThread())
     {
-        std::lock_guard<std::recursive_mutex> lock(external_event_section);
         event_types[event_type].callback(userdata, 0);
     }
     else
@@ -232,115 +278,45 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata) {
 }
 
 void ClearPendingEvents() {
-    while (first) {
-        Event* event = first->next;
-        FreeEvent(first);
-        first = event;
-    }
-}
-
-static void AddEventToQueue(Event* new_event) {
-    Event* prev_event = nullptr;
-    Event** next_event = &first;
-    for (;;) {
-        Event*& next = *next_event;
-        if (!next || new_event->time < next->time) {
-            new_event->next = next;
-            next = new_event;
-            break;
-        }
-        prev_event = next;
-        next_event = &prev_event->next;
-    }
+    event_slots.clear();
+    free_event_slots.clear();
+    event_queue.clear();
+    event_slots_by_userdata.clear();
 }
 
 void ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata) {
-    Event* new_event = GetNewEvent();
-    new_event->userdata = userdata;
-    new_event->type = event_type;
-    new_event->time = GetTicks() + cycles_into_future;
+    BaseEvent new_event;
+    new_event.userdata = userdata;
+    new_event.type = event_type;
+    new_event.time = GetTicks() + cycles_into_future;
     AddEventToQueue(new_event);
 }
 
 s64 UnscheduleEvent(int event_type, u64 userdata) {
     s64 result = 0;
-    if (!first)
-        return result;
-    while (first) {
-        if (first->type == event_type && first->userdata == userdata) {
-            result = first->time - GetTicks();
-
-            Event* next = first->next;
-            FreeEvent(first);
-            first = next;
-        } else {
-            break;
-        }
-    }
-    if (!first)
-        return result;
 
-    Event* prev_event = first;
-    Event* ptr = prev_event->next;
+    // Collect the matching slots first, removing them modifies the lookup table
+    std::vector<u32> slots;
+    auto range = event_slots_by_userdata.equal_range(userdata);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (event_slots[it->second].type == event_type)
+            slots.push_back(it->second);
+    }
 
-    while (ptr) {
-        if (ptr->type == event_type && ptr->userdata == userdata) {
-            result = ptr->time - GetTicks();
+    // Like the sorted event list this replaced, report the matching event which fires last
+    std::sort(slots.begin(), slots.end(), EventBefore);
 
-            prev_event->next = ptr->next;
-            FreeEvent(ptr);
-            ptr = prev_event->next;
-        } else {
-            prev_event = ptr;
-            ptr = ptr->next;
-        }
-    }
+    for (u32 slot : slots)
+        result = RemoveEventFromQueue(slot).time - GetTicks();
 
     return result;
 }
 
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata) {
-    s64 result = 0;
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    if (!ts_first)
-        return result;
-
-    while (ts_first) {
-        if (ts_first->type == event_type && ts_first->userdata == userdata) {
-            result = ts_first->time - GetTicks();
-
-            Event* next = ts_first->next;
-            FreeTsEvent(ts_first);
-            ts_first = next;
-        } else {
-            break;
-        }
-    }
-
-    if (!ts_first)
-    {
-        ts_last = nullptr;
-        return result;
-    }
-
-    Event* prev_event = ts_first;
-    Event* next = prev_event->next;
-    while (next) {
-        if (next->type == event_type && next->userdata == userdata) {
-            result = next->time - GetTicks();
-
-            prev_event->next = next->next;
-            if (next == ts_last)
-                ts_last = prev_event;
-            FreeTsEvent(next);
-            next = prev_event->next;
-        } else {
-            prev_event = next;
-            next = next->next;
-        }
-    }
-
-    return result;
+    // Threadsafe events can't be removed from the lock-free queue, so move them into the main
+    // queue first. This must therefore only be called from the CPU thread.
+    MoveEvents();
+    return UnscheduleEvent(event_type, userdata);
 }
 
 // Warning: not included in save state.
@@ -353,94 +329,41 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 }
 
 bool IsScheduled(int event_type) {
-    if (!first)
-        return false;
-    Event* event = first;
-    while (event) {
-        if (event->type == event_type)
+    for (u32 slot : event_queue) {
+        if (event_slots[slot].type == event_type)
             return true;
-        event = event->next;
     }
     return false;
 }
 
 void RemoveEvent(int event_type) {
-    if (!first)
-        return;
-    while (first) {
-        if (first->type == event_type) {
-            Event *next = first->next;
-            FreeEvent(first);
-            first = next;
-        } else {
-            break;
-        }
-    }
-    if (!first)
-        return;
-    Event* prev = first;
-    Event* next = prev->next;
-    while (next) {
-        if (next->type == event_type) {
-            prev->next = next->next;
-            FreeEvent(next);
-            next = prev->next;
-        } else {
-            prev = next;
-            next = next->next;
-        }
+    std::vector<u32> slots;
+    for (u32 slot : event_queue) {
+        if (event_slots[slot].type == event_type)
+            slots.push_back(slot);
     }
+
+    for (u32 slot : slots)
+        RemoveEventFromQueue(slot);
 }
 
 void RemoveThreadsafeEvent(int event_type) {
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
-    if (!ts_first)
-        return;
-
-    while (ts_first) {
-        if (ts_first->type == event_type) {
-            Event* next = ts_first->next;
-            FreeTsEvent(ts_first);
-            ts_first = next;
-        } else {
-            break;
-        }
-    }
-
-    if (!ts_first) {
-        ts_last = nullptr;
-        return;
-    }
-
-    Event* prev = ts_first;
-    Event* next = prev->next;
-    while (next) {
-        if (next->type == event_type) {
-            prev->next = next->next;
-            if (next == ts_last)
-                ts_last = prev;
-            FreeTsEvent(next);
-            next = prev->next;
-        } else {
-            prev = next;
-            next = next->next;
-        }
-    }
+    // See UnscheduleThreadsafeEvent
+    MoveEvents();
+    RemoveEvent(event_type);
 }
 
 void RemoveAllEvents(int event_type) {
     RemoveThreadsafeEvent(event_type);
-    RemoveEvent(event_type);
 }
 
 // This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents() {
-    while (first) {
-        if (first->time <= (s64)GetTicks()) {
-            Event* evt = first;
-            first = first->next;
-            event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-            FreeEvent(evt);
+    while (!event_queue.empty()) {
+        if (GetFirstEvent()->time <= (s64)GetTicks()) {
+            // The callback may schedule new events, so the event has to be removed first
+            BaseEvent evt = RemoveEventFromQueue(event_queue.front());
+            event_types[evt.type].callback(evt.userdata, (int)(GetTicks() - evt.time));
         } else {
             break;
         }
@@ -450,23 +373,10 @@ void ProcessFifoWaitEvents() {
 void MoveEvents() {
     has_ts_events = false;
 
-    std::lock_guard<std::recursive_mutex> lock(external_event_section);
     // Move events from async queue into main queue
-    while (ts_first) {
-        Event* next = ts_first->next;
-        AddEventToQueue(ts_first);
-        ts_first = next;
-    }
-    ts_last = nullptr;
-
-    // Move free events to threadsafe pool
-    while (allocated_ts_events > 0 && event_pool) {
-        Event* event = event_pool;
-        event_pool = event->next;
-        event->next = event_ts_pool;
-        event_ts_pool = event;
-        allocated_ts_events--;
-    }
+    BaseEvent event;
+    while (ts_queue.Pop(event))
+        AddEventToQueue(event);
 }
 
 void ForceCheck() {
@@ -487,6 +397,7 @@ void Advance() {
         MoveEvents();
     ProcessFifoWaitEvents();
 
+    const Event* first = GetFirstEvent();
     if (!first) {
         if (g_slice_length < 10000) {
             g_slice_length += 10000;
@@ -507,10 +418,9 @@ void Advance() {
 }
 
 void LogPendingEvents() {
-    Event* event = first;
-    while (event) {
-        //LOG_TRACE(Core_Timing, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, next->time, next->type);
-        event = event->next;
+    for (u32 slot : event_queue) {
+        const Event& event = event_slots[slot];
+        LOG_TRACE(Core_Timing, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", global_timer, event.time, event.type);
     }
 }
 
@@ -519,6 +429,7 @@ void Idle(int max_idle) {
     if (max_idle != 0 && cycles_down > max_idle)
         cycles_down = max_idle;
 
+    const Event* first = GetFirstEvent();
     if (first && cycles_down > 0) {
         s64 cycles_executed = g_slice_length - Core::g_app_core->down_count;
         s64 cycles_next_event = first->time - global_timer;
@@ -540,10 +451,14 @@ void Idle(int max_idle) {
 }
 
 std::string GetScheduledEventsSummary() {
-    Event* event = first;
+    // List the events in the order they will fire in
+    std::vector<u32> slots(event_queue);
+    std::sort(slots.begin(), slots.end(), EventBefore);
+
     std::string text = "Scheduled events\n";
     text.reserve(1000);
-    while (event) {
+    for (u32 slot : slots) {
+        const Event* event = &event_slots[slot];
         unsigned int t = event->type;
         if (t >= event_types.size())
             LOG_ERROR(Core_Timing, "Invalid event type"); // %i", t);
@@ -552,7 +467,6 @@ std::string GetScheduledEventsSummary() {
             name = "[unknown]";
         text += Common::StringFromFormat("%s : %i %08x%08x\n", name, (int)event->time,
                 (u32)(event->userdata >> 32), (u32)(event->userdata));
-        event = event->next;
     }
     return text;
 }
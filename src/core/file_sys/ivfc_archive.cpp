@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "common/common_types.h"
@@ -78,37 +79,49 @@ u64 IVFCArchive::GetFreeBytes() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-u8 IVFCFile::ReadEncryptedByte(u64 offset) const {
-    u64 index = offset / 16;
-    u8 buf_offset = offset % 16;
-    if (!decrypt_buffered || index != buf_index) {
-        decrypt_buffered = true;
-        buf_index = index;
-        std::array<u8, 16> ctr = aes_context.ctr;
-        AES::AddCtr(ctr, index);
-        std::array<u8, 16> xorpad = AES::AesCipher(ctr, aes_context.key);
-        romfs_file->Seek(data_offset + index * 16, SEEK_SET);
-        romfs_file->ReadBytes(decrypt_buf.data(), 16);
-        for (int i = 0; i < 16; ++i)
-            decrypt_buf[i] ^= xorpad[i];
-    }
-    return decrypt_buf[buf_offset];
+IVFCFile::IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size,
+                   const AES::AesContext& ac)
+    : romfs_file(file), data_offset(offset), data_size(size) {
+    if (ac.encrypted)
+        cipher = std::make_unique<AES::AesCtrCipher>(ac.key, ac.ctr);
+}
+
+size_t IVFCFile::ReadDecrypted(u64 offset, size_t length, u8* buffer) const {
+    romfs_file->Seek(data_offset + offset, SEEK_SET);
+    size_t read_length = romfs_file->ReadBytes(buffer, length);
+    cipher->Transform(buffer, read_length, offset);
+    return read_length;
 }
 
 ResultVal<size_t> IVFCFile::Read(const u64 offset, const size_t length, u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset=%llu, length=%zu", offset, length);
-    if (!romfs_file)
+    if (!romfs_file || offset >= data_size)
         return MakeResult<size_t>(0);
     size_t read_length = (size_t)std::min((u64)length, data_size - offset);
-    if (aes_context.encrypted) {
-        for (size_t i = 0; i < read_length; ++i) {
-            buffer[i] = ReadEncryptedByte(offset + i);
-        }
-        return MakeResult<size_t>(read_length);
-    } else {
+    if (!cipher) {
         romfs_file->Seek(data_offset + offset, SEEK_SET);
         return MakeResult<size_t>(romfs_file->ReadBytes(buffer, read_length));
     }
+
+    if (read_length >= READ_AHEAD_SIZE)
+        return MakeResult<size_t>(ReadDecrypted(offset, read_length, buffer));
+
+    // Games tend to read encrypted RomFS files in many small sequential pieces, so decrypt a
+    // larger window at once and serve the following reads from it.
+    auto InReadAhead = [&] {
+        return offset >= read_ahead_offset &&
+               offset + read_length <= read_ahead_offset + read_ahead.size();
+    };
+    if (!InReadAhead()) {
+        read_ahead.resize((size_t)std::min((u64)READ_AHEAD_SIZE, data_size - offset));
+        read_ahead.resize(ReadDecrypted(offset, read_ahead.size(), read_ahead.data()));
+        read_ahead_offset = offset;
+    }
+    if (!InReadAhead())
+        return MakeResult<size_t>(ReadDecrypted(offset, read_length, buffer));
+
+    std::memcpy(buffer, &read_ahead[offset - read_ahead_offset], read_length);
+    return MakeResult<size_t>(read_length);
 }
 
 ResultVal<size_t> IVFCFile::Write(const u64 offset, const size_t length, const bool flush,
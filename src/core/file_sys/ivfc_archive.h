@@ -56,8 +56,7 @@ protected:
 class IVFCFile : public FileBackend {
 public:
     IVFCFile(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size,
-             const AES::AesContext& ac)
-        : romfs_file(file), data_offset(offset), data_size(size), aes_context(ac) {}
+             const AES::AesContext& ac);
 
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) const override;
@@ -69,14 +68,18 @@ public:
     void Flush() const override {}
 
 private:
-    u8 ReadEncryptedByte(u64 offset) const;
+    /// Reads smaller than this are served from a window of decrypted data read ahead of them
+    static constexpr size_t READ_AHEAD_SIZE = 0x10000;
+
+    /// Reads and decrypts data directly into the buffer, returning the number of bytes read
+    size_t ReadDecrypted(u64 offset, size_t length, u8* buffer) const;
+
     std::shared_ptr<FileUtil::IOFile> romfs_file;
     u64 data_offset;
     u64 data_size;
-    AES::AesContext aes_context;
-    mutable std::array<u8, 16> decrypt_buf;
-    mutable u64 buf_index;
-    mutable bool decrypt_buffered = false;
+    std::unique_ptr<AES::AesCtrCipher> cipher; ///< Only set for encrypted files
+    mutable std::vector<u8> read_ahead;
+    mutable u64 read_ahead_offset = 0;
 };
 
 class IVFCDirectory : public DirectoryBackend {
@@ -23,10 +23,11 @@
 
 #include "core/hw/hw.h"
 #include "core/hw/gpu.h"
+#include "core/hw/gpu_transfer.h"
 
 #include "core/tracer/recorder.h"
 
-#include "video_core/command_processor.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -113,6 +114,9 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
+            // The fill may overwrite memory which is still being rendered to
+            VideoCore::GPUThread::WaitForIdle();
+
             if (config.address_start) { // Some games pass invalid values here
                 u8* start = Memory::GetPhysicalPointer(config.GetStartAddress());
                 u8* end = Memory::GetPhysicalPointer(config.GetEndAddress());
@@ -129,27 +133,7 @@ inline void Write(u32 addr, const T data) {
                 if (!VideoCore::g_renderer->Rasterizer()->AccelerateFill(config)) {
                     Memory::RasterizerFlushAndInvalidateRegion(config.GetStartAddress(), config.GetEndAddress() - config.GetStartAddress());
 
-                    if (config.fill_24bit) {
-                        // fill with 24-bit values
-                        for (u8* ptr = start; ptr < end; ptr += 3) {
-                            ptr[0] = config.value_24bit_r;
-                            ptr[1] = config.value_24bit_g;
-                            ptr[2] = config.value_24bit_b;
-                        }
-                    } else if (config.fill_32bit) {
-                        // fill with 32-bit values
-                        if (end > start) {
-                            u32 value = config.value_32bit;
-                            size_t len = (end - start) / sizeof(u32);
-                            for (size_t i = 0; i < len; ++i)
-                                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-                        }
-                    } else {
-                        // fill with 16-bit values
-                        u16 value_16bit = config.value_16bit.Value();
-                        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-                            memcpy(ptr, &value_16bit, sizeof(u16));
-                    }
+                    MemoryFill(config, start, end);
                 }
 
                 LOG_TRACE(HW_GPU, "MemoryFill from 0x%08x to 0x%08x", config.GetStartAddress(), config.GetEndAddress());
@@ -175,6 +159,8 @@ inline void Write(u32 addr, const T data) {
 
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
+            // The transfer usually copies the output of the command lists submitted before it
+            VideoCore::GPUThread::WaitForIdle();
 
             if (Pica::g_debug_context)
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer, nullptr);
@@ -253,102 +239,104 @@ inline void Write(u32 addr, const T data) {
                 Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
                 Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-                for (u32 y = 0; y < output_height; ++y) {
-                    for (u32 x = 0; x < output_width; ++x) {
-                        Math::Vec4<u8> src_color;
-
-                        // Calculate the [x,y] position of the input image
-                        // based on the current output position and the scale
-                        u32 input_x = x << horizontal_scale;
-                        u32 input_y = y << vertical_scale;
-
-                        if (config.flip_vertically) {
-                            // Flip the y value of the output data,
-                            // we do this after calculating the [x,y] position of the input image
-                            // to account for the scaling options.
-                            y = output_height - y - 1;
-                        }
-
-                        u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-                        u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-                        u32 src_offset;
-                        u32 dst_offset;
-
-                        if (config.input_linear) {
-                            if (!config.dont_swizzle) {
-                                // Interpret the input as linear and the output as tiled
-                                u32 coarse_y = y & ~7;
-                                u32 stride = output_width * dst_bytes_per_pixel;
+                if (!DisplayTransfer(config, src_pointer, dst_pointer, output_width, output_height)) {
+                    for (u32 y = 0; y < output_height; ++y) {
+                        for (u32 x = 0; x < output_width; ++x) {
+                            Math::Vec4<u8> src_color;
+
+                            // Calculate the [x,y] position of the input image
+                            // based on the current output position and the scale
+                            u32 input_x = x << horizontal_scale;
+                            u32 input_y = y << vertical_scale;
+
+                            if (config.flip_vertically) {
+                                // Flip the y value of the output data,
+                                // we do this after calculating the [x,y] position of the input image
+                                // to account for the scaling options.
+                                y = output_height - y - 1;
+                            }
 
-                                src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                                dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + coarse_y * stride;
+                            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+                            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+                            u32 src_offset;
+                            u32 dst_offset;
+
+                            if (config.input_linear) {
+                                if (!config.dont_swizzle) {
+                                    // Interpret the input as linear and the output as tiled
+                                    u32 coarse_y = y & ~7;
+                                    u32 stride = output_width * dst_bytes_per_pixel;
+
+                                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                                    dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + coarse_y * stride;
+                                } else {
+                                    // Both input and output are linear
+                                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                                    dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
+                                }
                             } else {
-                                // Both input and output are linear
-                                src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                                dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
+                                if (!config.dont_swizzle) {
+                                    // Interpret the input as tiled and the output as linear
+                                    u32 coarse_y = input_y & ~7;
+                                    u32 stride = config.input_width * src_bytes_per_pixel;
+
+                                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + coarse_y * stride;
+                                    dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
+                                } else {
+                                    // Both input and output are tiled
+                                    u32 out_coarse_y = y & ~7;
+                                    u32 out_stride = output_width * dst_bytes_per_pixel;
+
+                                    u32 in_coarse_y = input_y & ~7;
+                                    u32 in_stride = config.input_width * src_bytes_per_pixel;
+
+                                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + in_coarse_y * in_stride;
+                                    dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + out_coarse_y * out_stride;
+                                }
                             }
-                        } else {
-                            if (!config.dont_swizzle) {
-                                // Interpret the input as tiled and the output as linear
-                                u32 coarse_y = input_y & ~7;
-                                u32 stride = config.input_width * src_bytes_per_pixel;
-
-                                src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + coarse_y * stride;
-                                dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
-                            } else {
-                                // Both input and output are tiled
-                                u32 out_coarse_y = y & ~7;
-                                u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                                u32 in_coarse_y = input_y & ~7;
-                                u32 in_stride = config.input_width * src_bytes_per_pixel;
 
-                                src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + in_coarse_y * in_stride;
-                                dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + out_coarse_y * out_stride;
+                            if (!dst_pointer) {
+                                LOG_CRITICAL(HW_GPU, "Invalid address %08x", dst_pointer);
+                                break;
+                            }
+                            const u8* src_pixel = src_pointer + src_offset;
+                            src_color = DecodePixel(config.input_format, src_pixel);
+                            if (config.scaling == config.ScaleX) {
+                                Math::Vec4<u8> pixel = DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                                src_color = ((src_color + pixel) / 2).Cast<u8>();
+                            } else if (config.scaling == config.ScaleXY) {
+                                Math::Vec4<u8> pixel1 = DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                                Math::Vec4<u8> pixel2 = DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                                Math::Vec4<u8> pixel3 = DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
                             }
-                        }
-
-                        if (!dst_pointer) {
-                            LOG_CRITICAL(HW_GPU, "Invalid address %08x", dst_pointer);
-                            break;
-                        }
-                        const u8* src_pixel = src_pointer + src_offset;
-                        src_color = DecodePixel(config.input_format, src_pixel);
-                        if (config.scaling == config.ScaleX) {
-                            Math::Vec4<u8> pixel = DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                            src_color = ((src_color + pixel) / 2).Cast<u8>();
-                        } else if (config.scaling == config.ScaleXY) {
-                            Math::Vec4<u8> pixel1 = DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                            Math::Vec4<u8> pixel2 = DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                            Math::Vec4<u8> pixel3 = DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                            src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-                        }
 
-                        u8* dst_pixel = dst_pointer + dst_offset;
-                        switch (config.output_format) {
-                        case Regs::PixelFormat::RGBA8:
-                            Color::EncodeRGBA8(src_color, dst_pixel);
-                            break;
+                            u8* dst_pixel = dst_pointer + dst_offset;
+                            switch (config.output_format) {
+                            case Regs::PixelFormat::RGBA8:
+                                Color::EncodeRGBA8(src_color, dst_pixel);
+                                break;
 
-                        case Regs::PixelFormat::RGB8:
-                            Color::EncodeRGB8(src_color, dst_pixel);
-                            break;
+                            case Regs::PixelFormat::RGB8:
+                                Color::EncodeRGB8(src_color, dst_pixel);
+                                break;
 
-                        case Regs::PixelFormat::RGB565:
-                            Color::EncodeRGB565(src_color, dst_pixel);
-                            break;
+                            case Regs::PixelFormat::RGB565:
+                                Color::EncodeRGB565(src_color, dst_pixel);
+                                break;
 
-                        case Regs::PixelFormat::RGB5A1:
-                            Color::EncodeRGB5A1(src_color, dst_pixel);
-                            break;
+                            case Regs::PixelFormat::RGB5A1:
+                                Color::EncodeRGB5A1(src_color, dst_pixel);
+                                break;
 
-                        case Regs::PixelFormat::RGBA4:
-                            Color::EncodeRGBA4(src_color, dst_pixel);
-                            break;
+                            case Regs::PixelFormat::RGBA4:
+                                Color::EncodeRGBA4(src_color, dst_pixel);
+                                break;
 
-                        default:
-                            LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x", config.output_format.Value());
-                            break;
+                            default:
+                                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x", config.output_format.Value());
+                                break;
+                            }
                         }
                     }
                 }
@@ -380,7 +368,7 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->recorder->MemoryAccessed((u8*)buffer, config.size * sizeof(u32), config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            VideoCore::GPUThread::SubmitCommandList(buffer, config.size);
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -413,6 +401,9 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, int cycles_late) {
+    // The renderer presents the framebuffers below, and the command processor reads g_skip_frame
+    VideoCore::GPUThread::WaitForIdle();
+
     frame_count++;
     last_skip_frame = g_skip_frame;
     g_skip_frame = (frame_count & Settings::values.frame_skip) != 0;
@@ -0,0 +1,436 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/color.h"
+#include "common/vector_math.h"
+
+#include "core/hw/gpu_transfer.h"
+
+#include "video_core/morton.h"
+
+namespace GPU {
+
+using PixelFormat = Regs::PixelFormat;
+
+/// Decodes a row of pixels to RGBA8
+using DecodeRowFunc = void (*)(const u8* src, Math::Vec4<u8>* dst, u32 count);
+
+/// Encodes a row of RGBA8 pixels
+using EncodeRowFunc = void (*)(const Math::Vec4<u8>* src, u8* dst, u32 count);
+
+#ifdef ARCHITECTURE_x86_64
+/// Combines eight 8-bit channel values in each 16-bit lane to eight RGBA8 pixels
+static void StorePixels(__m128i r, __m128i g, __m128i b, __m128i a, Math::Vec4<u8>* dst) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), _mm_unpackhi_epi16(rg, ba));
+}
+
+/// Reverses the byte order of each 32-bit lane, converting between RGBA8 in memory and Vec4<u8>
+static __m128i ByteSwap32(__m128i value) {
+    value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0xB1), 0xB1);
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+/// Packs the low 16 bits of each 32-bit lane of two vectors
+static __m128i Pack32To16(__m128i lo, __m128i hi) {
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+static __m128i Expand4To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 4), value);
+}
+
+static __m128i Expand5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+static __m128i Expand6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+#endif // ARCHITECTURE_x86_64
+
+static void DecodeRowRGBA8(const u8* src, Math::Vec4<u8>* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), ByteSwap32(pixels));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = Color::DecodeRGBA8(src + i * 4);
+}
+
+static void DecodeRowRGB8(const u8* src, Math::Vec4<u8>* dst, u32 count) {
+    for (u32 i = 0; i < count; ++i)
+        dst[i] = Color::DecodeRGB8(src + i * 3);
+}
+
+static void DecodeRowRGB565(const u8* src, Math::Vec4<u8>* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    for (; i + 8 <= count; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        const __m128i r = Expand5To8(_mm_srli_epi16(pixels, 11));
+        const __m128i g = Expand6To8(_mm_and_si128(_mm_srli_epi16(pixels, 5), _mm_set1_epi16(0x3F)));
+        const __m128i b = Expand5To8(_mm_and_si128(pixels, _mm_set1_epi16(0x1F)));
+        StorePixels(r, g, b, _mm_set1_epi16(0xFF), dst + i);
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = Color::DecodeRGB565(src + i * 2);
+}
+
+static void DecodeRowRGB5A1(const u8* src, Math::Vec4<u8>* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        const __m128i r = Expand5To8(_mm_srli_epi16(pixels, 11));
+        const __m128i g = Expand5To8(_mm_and_si128(_mm_srli_epi16(pixels, 6), mask5));
+        const __m128i b = Expand5To8(_mm_and_si128(_mm_srli_epi16(pixels, 1), mask5));
+        const __m128i a = _mm_srli_epi16(_mm_sub_epi16(_mm_setzero_si128(),
+                                                       _mm_and_si128(pixels, _mm_set1_epi16(1))), 8);
+        StorePixels(r, g, b, a, dst + i);
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = Color::DecodeRGB5A1(src + i * 2);
+}
+
+static void DecodeRowRGBA4(const u8* src, Math::Vec4<u8>* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    const __m128i mask4 = _mm_set1_epi16(0xF);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        const __m128i r = Expand4To8(_mm_srli_epi16(pixels, 12));
+        const __m128i g = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixels, 8), mask4));
+        const __m128i b = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixels, 4), mask4));
+        const __m128i a = Expand4To8(_mm_and_si128(pixels, mask4));
+        StorePixels(r, g, b, a, dst + i);
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = Color::DecodeRGBA4(src + i * 2);
+}
+
+static void EncodeRowRGBA8(const Math::Vec4<u8>* src, u8* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), ByteSwap32(pixels));
+    }
+#endif
+    for (; i < count; ++i)
+        Color::EncodeRGBA8(src[i], dst + i * 4);
+}
+
+static void EncodeRowRGB8(const Math::Vec4<u8>* src, u8* dst, u32 count) {
+    for (u32 i = 0; i < count; ++i)
+        Color::EncodeRGB8(src[i], dst + i * 3);
+}
+
+#ifdef ARCHITECTURE_x86_64
+// Pack functions take RGBA8 pixels as 32-bit lanes, with red in the lowest byte and alpha in the
+// highest one, and compute the 16-bit encoding of each lane with shifts and masks.
+
+static __m128i PackRGB565(__m128i p) {
+    return _mm_or_si128(_mm_or_si128(
+        _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8),
+        _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x7E0))),
+        _mm_and_si128(_mm_srli_epi32(p, 19), _mm_set1_epi32(0x1F)));
+}
+
+static __m128i PackRGB5A1(__m128i p) {
+    return _mm_or_si128(_mm_or_si128(
+        _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8),
+        _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x7C0))), _mm_or_si128(
+        _mm_and_si128(_mm_srli_epi32(p, 18), _mm_set1_epi32(0x3E)),
+        _mm_srli_epi32(p, 31)));
+}
+
+static __m128i PackRGBA4(__m128i p) {
+    return _mm_or_si128(_mm_or_si128(
+        _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF0)), 8),
+        _mm_and_si128(_mm_srli_epi32(p, 4), _mm_set1_epi32(0xF00))), _mm_or_si128(
+        _mm_and_si128(_mm_srli_epi32(p, 16), _mm_set1_epi32(0xF0)),
+        _mm_srli_epi32(p, 28)));
+}
+
+/// Encodes the pixels of a row eight at a time to a 16-bit format, returning how many were encoded
+template <__m128i (*pack)(__m128i)>
+static u32 EncodeRow16(const Math::Vec4<u8>* src, u8* dst, u32 count) {
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), Pack32To16(pack(lo), pack(hi)));
+    }
+    return i;
+}
+#endif // ARCHITECTURE_x86_64
+
+static void EncodeRowRGB565(const Math::Vec4<u8>* src, u8* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    i = EncodeRow16<PackRGB565>(src, dst, count);
+#endif
+    for (; i < count; ++i)
+        Color::EncodeRGB565(src[i], dst + i * 2);
+}
+
+static void EncodeRowRGB5A1(const Math::Vec4<u8>* src, u8* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    i = EncodeRow16<PackRGB5A1>(src, dst, count);
+#endif
+    for (; i < count; ++i)
+        Color::EncodeRGB5A1(src[i], dst + i * 2);
+}
+
+static void EncodeRowRGBA4(const Math::Vec4<u8>* src, u8* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    i = EncodeRow16<PackRGBA4>(src, dst, count);
+#endif
+    for (; i < count; ++i)
+        Color::EncodeRGBA4(src[i], dst + i * 2);
+}
+
+static DecodeRowFunc GetRowDecoder(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:  return DecodeRowRGBA8;
+    case PixelFormat::RGB8:   return DecodeRowRGB8;
+    case PixelFormat::RGB565: return DecodeRowRGB565;
+    case PixelFormat::RGB5A1: return DecodeRowRGB5A1;
+    case PixelFormat::RGBA4:  return DecodeRowRGBA4;
+    default:                  return nullptr;
+    }
+}
+
+static EncodeRowFunc GetRowEncoder(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:  return EncodeRowRGBA8;
+    case PixelFormat::RGB8:   return EncodeRowRGB8;
+    case PixelFormat::RGB565: return EncodeRowRGB565;
+    case PixelFormat::RGB5A1: return EncodeRowRGB5A1;
+    case PixelFormat::RGBA4:  return EncodeRowRGBA4;
+    default:                  return nullptr;
+    }
+}
+
+/**
+ * Averages each horizontal pair of pixels, rounding down like the box filter of the hardware.
+ * The result may overwrite the source.
+ */
+static void DownscaleRowX(const Math::Vec4<u8>* src, Math::Vec4<u8>* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    for (; i + 4 <= count; i += 4) {
+        const __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)), 0xD8);
+        const __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 4)), 0xD8);
+        const __m128i even = _mm_unpacklo_epi64(a, b);
+        const __m128i odd = _mm_unpackhi_epi64(a, b);
+
+        // (even + odd) / 2 without overflow: common bits plus half of the differing bits
+        const __m128i half_diff = _mm_and_si128(_mm_srli_epi16(_mm_xor_si128(even, odd), 1), _mm_set1_epi8(0x7F));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(_mm_and_si128(even, odd), half_diff));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = ((src[i * 2] + src[i * 2 + 1]) / 2).Cast<u8>();
+}
+
+/// Averages each 2x2 block of pixels of two rows, rounding down. The result may overwrite row0.
+static void DownscaleRowXY(const Math::Vec4<u8>* row0, const Math::Vec4<u8>* row1,
+                           Math::Vec4<u8>* dst, u32 count) {
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 2 <= count; i += 2) {
+        // Two output pixels from four pixels of each row, summed up in 16-bit lanes
+        const __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i * 2));
+        const __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i * 2));
+        const __m128i sum_lo = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+        const __m128i sum_hi = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+        // Each half holds the two pixels of a block: add the halves of each 64-bit lane
+        const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(sum_lo, sum_hi), _mm_unpackhi_epi64(sum_lo, sum_hi));
+        const __m128i result = _mm_packus_epi16(_mm_srli_epi16(sum, 2), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), result);
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = (((row0[i * 2] + row0[i * 2 + 1]) + (row1[i * 2] + row1[i * 2 + 1])) / 4).Cast<u8>();
+}
+
+/// Scratch buffers, kept between transfers to avoid reallocating them every frame
+static std::vector<u8> tiled_input_buffer;
+static std::vector<u8> tiled_output_buffer;
+static std::vector<Math::Vec4<u8>> decoded_rows[2];
+
+bool DisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                     u8* dst_pointer, u32 output_width, u32 output_height) {
+    const DecodeRowFunc decode_row = GetRowDecoder(config.input_format);
+    const EncodeRowFunc encode_row = GetRowEncoder(config.output_format);
+    if (!src_pointer || !dst_pointer || !decode_row || !encode_row)
+        return false;
+
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+    const u32 horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const u32 vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    const u32 input_width = config.input_width;
+    const u32 input_row_pixels = output_width << horizontal_scale;
+    const u32 input_rows = output_height << vertical_scale;
+
+    // Scaling is only implemented for tiled input, where the pixels the generic path averages are
+    // consecutive in Morton order: a horizontal pair for ScaleX and a 2x2 block for ScaleXY. The
+    // box filters below sample the same pixels from the unswizzled rows.
+    if (!input_tiled && config.scaling != config.NoScale)
+        return false;
+
+    // Pixels outside of the input rows and partial tiles are left to the generic path
+    if (input_row_pixels > input_width)
+        return false;
+    if ((input_tiled || output_tiled) && (output_width % 8 != 0 || output_height % 8 != 0))
+        return false;
+    if (input_tiled && input_width % 8 != 0)
+        return false;
+
+    const u32 src_bytes_per_pixel = Regs::BytesPerPixel(config.input_format);
+    const u32 dst_bytes_per_pixel = Regs::BytesPerPixel(config.output_format);
+    const bool same_format = config.input_format == config.output_format;
+
+    // Plain (un)swizzles copy whole tiles straight between the two buffers
+    if (same_format && config.scaling == config.NoScale && input_tiled != output_tiled &&
+        input_width == output_width) {
+        const ptrdiff_t stride = output_width * src_bytes_per_pixel;
+        ptrdiff_t linear_offset = 0;
+        ptrdiff_t linear_stride = stride;
+        if (config.flip_vertically) {
+            // Flipping is done by walking the linear side bottom to top
+            linear_offset = (output_height - 1) * stride;
+            linear_stride = -stride;
+        }
+
+        if (input_tiled) {
+            VideoCore::MortonUnswizzle(output_width, output_height, src_bytes_per_pixel, src_pointer,
+                                       dst_pointer + linear_offset, linear_stride);
+        } else {
+            VideoCore::MortonSwizzle(output_width, output_height, dst_bytes_per_pixel, dst_pointer,
+                                     src_pointer + linear_offset, linear_stride);
+        }
+        return true;
+    }
+
+    // Linear view of the input rows
+    const ptrdiff_t input_stride = input_width * src_bytes_per_pixel;
+    const u8* input = src_pointer;
+    if (input_tiled) {
+        tiled_input_buffer.resize(input_rows * input_stride);
+        VideoCore::MortonUnswizzle(input_width, input_rows, src_bytes_per_pixel, src_pointer,
+                                   tiled_input_buffer.data(), input_stride);
+        input = tiled_input_buffer.data();
+    }
+
+    const ptrdiff_t output_stride = output_width * dst_bytes_per_pixel;
+    u8* output = dst_pointer;
+    if (output_tiled) {
+        tiled_output_buffer.resize(output_height * output_stride);
+        output = tiled_output_buffer.data();
+    }
+
+    if (!same_format || config.scaling != config.NoScale) {
+        for (auto& row : decoded_rows)
+            row.resize(input_row_pixels);
+    }
+
+    for (u32 y = 0; y < output_height; ++y) {
+        // Flipping reads the input rows bottom to top, after accounting for the scaling
+        const u32 input_y = (config.flip_vertically ? output_height - 1 - y : y) << vertical_scale;
+        const u8* src_row = input + input_y * input_stride;
+        u8* dst_row = output + y * output_stride;
+
+        if (same_format && config.scaling == config.NoScale) {
+            std::memcpy(dst_row, src_row, output_width * dst_bytes_per_pixel);
+            continue;
+        }
+
+        Math::Vec4<u8>* pixels = decoded_rows[0].data();
+        decode_row(src_row, pixels, input_row_pixels);
+        if (config.scaling == config.ScaleX) {
+            DownscaleRowX(pixels, pixels, output_width);
+        } else if (config.scaling == config.ScaleXY) {
+            decode_row(src_row + input_stride, decoded_rows[1].data(), input_row_pixels);
+            DownscaleRowXY(pixels, decoded_rows[1].data(), pixels, output_width);
+        }
+        encode_row(pixels, dst_row, output_width);
+    }
+
+    if (output_tiled) {
+        VideoCore::MortonSwizzle(output_width, output_height, dst_bytes_per_pixel, dst_pointer,
+                                 output, output_stride);
+    }
+    return true;
+}
+
+/// Size of the fill patterns, a common multiple of all fill value sizes
+static const size_t FILL_PATTERN_SIZE = 48;
+
+/// Fills memory with a repeating pattern, copying the whole pattern at once with wide stores
+static void FillPattern(u8* start, size_t size, const u8 (&pattern)[FILL_PATTERN_SIZE]) {
+    size_t offset = 0;
+    for (; offset + FILL_PATTERN_SIZE <= size; offset += FILL_PATTERN_SIZE)
+        std::memcpy(start + offset, pattern, FILL_PATTERN_SIZE);
+    std::memcpy(start + offset, pattern, size - offset);
+}
+
+void MemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end) {
+    if (end <= start)
+        return;
+
+    // Each fill writes whole values, possibly ending past the end address
+    const size_t size = end - start;
+    u8 pattern[FILL_PATTERN_SIZE];
+    if (config.fill_24bit) {
+        // fill with 24-bit values
+        for (size_t i = 0; i < FILL_PATTERN_SIZE; i += 3) {
+            pattern[i + 0] = config.value_24bit_r;
+            pattern[i + 1] = config.value_24bit_g;
+            pattern[i + 2] = config.value_24bit_b;
+        }
+        FillPattern(start, (size + 2) / 3 * 3, pattern);
+    } else if (config.fill_32bit) {
+        // fill with 32-bit values
+        const u32 value = config.value_32bit;
+        for (size_t i = 0; i < FILL_PATTERN_SIZE; i += sizeof(u32))
+            std::memcpy(&pattern[i], &value, sizeof(u32));
+        FillPattern(start, size / sizeof(u32) * sizeof(u32), pattern);
+    } else {
+        // fill with 16-bit values
+        const u16 value = config.value_16bit.Value();
+        for (size_t i = 0; i < FILL_PATTERN_SIZE; i += sizeof(u16))
+            std::memcpy(&pattern[i], &value, sizeof(u16));
+        FillPattern(start, (size + 1) / sizeof(u16) * sizeof(u16), pattern);
+    }
+}
+
+} // namespace
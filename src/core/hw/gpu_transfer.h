@@ -0,0 +1,26 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/**
+ * Performs a display transfer on the CPU. The kernels for each step (untiling, pixel decoding,
+ * downscaling, encoding and tiling) are selected once for the whole transfer.
+ * @param output_width Width of the output image, after horizontal downscaling
+ * @param output_height Height of the output image, after vertical downscaling
+ * @return false if the configuration isn't supported and needs the generic per-pixel path
+ */
+bool DisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                     u8* dst_pointer, u32 output_width, u32 output_height);
+
+/// Fills memory from start to end with the value of the given memory fill configuration
+void MemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end);
+
+} // namespace
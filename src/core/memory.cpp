@@ -2,12 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <cstdio>
 #include <cstring>
 
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/swap.h"
 
 #include "core/hle/kernel/process.h"
@@ -15,6 +18,7 @@
 #include "core/memory_setup.h"
 #include "core/mmio.h"
 
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -37,6 +41,8 @@ struct SpecialRegion {
     VAddr base;
     u32 size;
     MMIORegionPointer handler;
+    /// Profiler timer counting the accesses dispatched to this region
+    MicroProfileToken profile_token;
 };
 
 /**
@@ -46,7 +52,7 @@ struct SpecialRegion {
  * requires an indexed fetch and a check for NULL.
  */
 struct PageTable {
-    static const size_t NUM_ENTRIES = 1 << (32 - PAGE_BITS);
+    static const size_t NUM_ENTRIES = PAGE_TABLE_NUM_ENTRIES;
 
     /**
      * Array of memory pointers backing each page. An entry can only be non-null if the
@@ -59,6 +65,12 @@ struct PageTable {
      */
     std::vector<SpecialRegion> special_regions;
 
+    /**
+     * Index into `special_regions` of the handler backing each page. Only meaningful for pages
+     * whose entry in the `attributes` array is of type `Special` or `RasterizerCachedSpecial`.
+     */
+    std::array<u16, NUM_ENTRIES> special_region_index;
+
     /**
      * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
      * the corresponding entry in `pointers` MUST be set to null.
@@ -70,6 +82,13 @@ struct PageTable {
      * flushed before the memory is accessed
      */
     std::array<u8, NUM_ENTRIES> cached_res_count;
+
+    /**
+     * Set for pages of type `RasterizerCachedMemory` once the rasterizer cache has been flushed
+     * for a CPU read, and cleared again when the rasterizer writes to the page. Reads of a page
+     * which is still flushed don't need to call into the rasterizer.
+     */
+    std::array<bool, NUM_ENTRIES> rasterizer_flushed;
 };
 
 /// Singular page table used for the singleton process
@@ -77,9 +96,20 @@ static PageTable main_page_table;
 /// Currently active page table
 static PageTable* current_page_table = &main_page_table;
 
+/// Page most recently resolved through the VMAs for an access to rasterizer cached memory
+static VAddr last_cached_page = 0;
+static u8* last_cached_page_pointer = nullptr;
+
+std::array<u8*, PAGE_TABLE_NUM_ENTRIES>* GetCurrentPageTablePointers() {
+    return &current_page_table->pointers;
+}
+
 static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping %p onto %08X-%08X", memory, base * PAGE_SIZE, (base + size) * PAGE_SIZE);
 
+    // The GPU thread accesses memory through the page table
+    VideoCore::GPUThread::WaitForIdle();
+
     u32 end = base + size;
 
     while (base != end) {
@@ -94,17 +124,22 @@ static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
         current_page_table->attributes[base] = type;
         current_page_table->pointers[base] = memory;
         current_page_table->cached_res_count[base] = 0;
+        current_page_table->rasterizer_flushed[base] = false;
 
         base += 1;
         if (memory != nullptr)
             memory += PAGE_SIZE;
     }
+
+    last_cached_page_pointer = nullptr;
 }
 
 void InitMemoryMap() {
     main_page_table.pointers.fill(nullptr);
     main_page_table.attributes.fill(PageType::Unmapped);
     main_page_table.cached_res_count.fill(0);
+    main_page_table.special_region_index.fill(0);
+    main_page_table.rasterizer_flushed.fill(false);
 }
 
 void MapMemoryRegion(VAddr base, u32 size, u8* target) {
@@ -118,7 +153,24 @@ void MapIoRegion(VAddr base, u32 size, MMIORegionPointer mmio_handler) {
     ASSERT_MSG((base & PAGE_MASK) == 0, "non-page aligned base: %08X", base);
     MapPages(base / PAGE_SIZE, size / PAGE_SIZE, nullptr, PageType::Special);
 
-    current_page_table->special_regions.emplace_back(SpecialRegion{base, size, mmio_handler});
+    auto& regions = current_page_table->special_regions;
+    auto it = std::find_if(regions.begin(), regions.end(), [&](const SpecialRegion& region) {
+        return region.base == base && region.size == size && region.handler == mmio_handler;
+    });
+    if (it == regions.end()) {
+        ASSERT_MSG(regions.size() <= 0xFFFF, "too many IO regions mapped");
+
+        MicroProfileToken profile_token = 0;
+#if MICROPROFILE_ENABLED
+        char name[32];
+        std::snprintf(name, sizeof(name), "%08X-%08X", base, base + size);
+        profile_token = MicroProfileGetToken("MMIO", name, MP_RGB(200, 100, 50));
+#endif
+        it = regions.insert(regions.end(), SpecialRegion{base, size, mmio_handler, profile_token});
+    }
+
+    u16 index = static_cast<u16>(it - regions.begin());
+    std::fill_n(current_page_table->special_region_index.begin() + base / PAGE_SIZE, size / PAGE_SIZE, index);
 }
 
 void UnmapRegion(VAddr base, u32 size) {
@@ -150,20 +202,49 @@ static u8* GetPointerFromVMA(VAddr vaddr) {
 }
 
 /**
- * This function should only be called for virtual addreses with attribute `PageType::Special`.
+ * Gets a pointer to the exact memory at the virtual address of a `RasterizerCachedMemory` page.
+ * The backing memory of the most recently accessed page is remembered, since the CPU usually
+ * accesses such pages sequentially (e.g. when reading back a framebuffer).
  */
-static MMIORegionPointer GetMMIOHandler(VAddr vaddr) {
-    for (const auto& region : current_page_table->special_regions) {
-        if (vaddr >= region.base && vaddr < (region.base + region.size)) {
-            return region.handler;
-        }
+static u8* GetRasterizerCachedPointer(VAddr vaddr) {
+    VAddr page = vaddr & ~PAGE_MASK;
+    if (last_cached_page_pointer == nullptr || last_cached_page != page) {
+        last_cached_page = page;
+        last_cached_page_pointer = GetPointerFromVMA(page);
     }
-    ASSERT_MSG(false, "Mapped IO page without a handler @ %08X", vaddr);
-    return nullptr; // Should never happen
+    return last_cached_page_pointer + (vaddr & PAGE_MASK);
+}
+
+/**
+ * Flushes the rasterizer cache for the `RasterizerCachedMemory` page containing the given address
+ * ahead of a CPU read. The whole page is flushed at once, and only on the first read after the
+ * rasterizer last wrote to it.
+ */
+static void RasterizerFlushPageForRead(VAddr vaddr) {
+    bool& flushed = current_page_table->rasterizer_flushed[vaddr >> PAGE_BITS];
+    if (!flushed) {
+        RasterizerFlushRegion(VirtualToPhysicalAddress(vaddr & ~PAGE_MASK), PAGE_SIZE);
+        flushed = true;
+    }
+}
+
+/**
+ * This function should only be called for virtual addreses with attribute `PageType::Special`.
+ */
+static const SpecialRegion& GetSpecialRegion(VAddr vaddr) {
+    u16 index = current_page_table->special_region_index[vaddr >> PAGE_BITS];
+    const SpecialRegion& region = current_page_table->special_regions[index];
+    DEBUG_ASSERT_MSG(vaddr >= region.base && vaddr - region.base < region.size,
+                     "Mapped IO page without a handler @ %08X", vaddr);
+    return region;
+}
+
+static const MMIORegionPointer& GetMMIOHandler(VAddr vaddr) {
+    return GetSpecialRegion(vaddr).handler;
 }
 
 template<typename T>
-T ReadMMIO(MMIORegionPointer mmio_handler, VAddr addr);
+T ReadMMIO(const SpecialRegion& region, VAddr addr);
 
 template <typename T>
 T Read(const VAddr vaddr) {
@@ -185,19 +266,19 @@ T Read(const VAddr vaddr) {
         break;
     case PageType::RasterizerCachedMemory:
     {
-        RasterizerFlushRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
+        RasterizerFlushPageForRead(vaddr);
 
         T value;
-        std::memcpy(&value, GetPointerFromVMA(vaddr), sizeof(T));
+        std::memcpy(&value, GetRasterizerCachedPointer(vaddr), sizeof(T));
         return value;
     }
     case PageType::Special:
-        return ReadMMIO<T>(GetMMIOHandler(vaddr), vaddr);
+        return ReadMMIO<T>(GetSpecialRegion(vaddr), vaddr);
     case PageType::RasterizerCachedSpecial:
     {
         RasterizerFlushRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
 
-        return ReadMMIO<T>(GetMMIOHandler(vaddr), vaddr);
+        return ReadMMIO<T>(GetSpecialRegion(vaddr), vaddr);
     }
     default:
         UNREACHABLE();
@@ -205,7 +286,7 @@ T Read(const VAddr vaddr) {
 }
 
 template<typename T>
-void WriteMMIO(MMIORegionPointer mmio_handler, VAddr addr, const T data);
+void WriteMMIO(const SpecialRegion& region, VAddr addr, const T data);
 
 template <typename T>
 void Write(const VAddr vaddr, const T data) {
@@ -228,17 +309,17 @@ void Write(const VAddr vaddr, const T data) {
     {
         RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
 
-        std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
+        std::memcpy(GetRasterizerCachedPointer(vaddr), &data, sizeof(T));
         break;
     }
     case PageType::Special:
-        WriteMMIO<T>(GetMMIOHandler(vaddr), vaddr, data);
+        WriteMMIO<T>(GetSpecialRegion(vaddr), vaddr, data);
         break;
     case PageType::RasterizerCachedSpecial:
     {
         RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
 
-        WriteMMIO<T>(GetMMIOHandler(vaddr), vaddr, data);
+        WriteMMIO<T>(GetSpecialRegion(vaddr), vaddr, data);
         break;
     }
     default:
@@ -257,7 +338,7 @@ bool IsValidVirtualAddress(const VAddr vaddr) {
     if (current_page_table->attributes[vaddr >> PAGE_BITS] != PageType::Special)
         return false;
 
-    MMIORegionPointer mmio_region = GetMMIOHandler(vaddr);
+    const MMIORegionPointer& mmio_region = GetMMIOHandler(vaddr);
     if (mmio_region) {
         return mmio_region->IsValidAddress(vaddr);
     }
@@ -323,6 +404,7 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
             case PageType::Memory:
                 page_type = PageType::RasterizerCachedMemory;
                 current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                current_page_table->rasterizer_flushed[vaddr >> PAGE_BITS] = false;
                 break;
             case PageType::Special:
                 page_type = PageType::RasterizerCachedSpecial;
@@ -353,13 +435,32 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
     }
 }
 
+void RasterizerMarkRegionDirty(PAddr start, u32 size) {
+    if (start == 0 || size == 0) {
+        return;
+    }
+
+    u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
+    PAddr paddr = start;
+
+    for (unsigned i = 0; i < num_pages; ++i) {
+        VAddr vaddr = PhysicalToVirtualAddress(paddr);
+        current_page_table->rasterizer_flushed[vaddr >> PAGE_BITS] = false;
+        paddr += PAGE_SIZE;
+    }
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
+    VideoCore::GPUThread::WaitForIdle();
+
     if (VideoCore::g_renderer != nullptr) {
         VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
     }
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
+    VideoCore::GPUThread::WaitForIdle();
+
     if (VideoCore::g_renderer != nullptr) {
         VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
     }
@@ -410,9 +511,9 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
+            RasterizerFlushPageForRead(current_vaddr);
 
-            std::memcpy(dest_buffer, GetPointerFromVMA(current_vaddr), copy_amount);
+            std::memcpy(dest_buffer, GetRasterizerCachedPointer(current_vaddr), copy_amount);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
@@ -585,9 +686,9 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
+            RasterizerFlushPageForRead(current_vaddr);
 
-            WriteBlock(dest_addr, GetPointerFromVMA(current_vaddr), copy_amount);
+            WriteBlock(dest_addr, GetRasterizerCachedPointer(current_vaddr), copy_amount);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
@@ -613,43 +714,51 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
 }
 
 template<>
-u8 ReadMMIO<u8>(MMIORegionPointer mmio_handler, VAddr addr) {
-    return mmio_handler->Read8(addr);
+u8 ReadMMIO<u8>(const SpecialRegion& region, VAddr addr) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    return region.handler->Read8(addr);
 }
 
 template<>
-u16 ReadMMIO<u16>(MMIORegionPointer mmio_handler, VAddr addr) {
-    return mmio_handler->Read16(addr);
+u16 ReadMMIO<u16>(const SpecialRegion& region, VAddr addr) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    return region.handler->Read16(addr);
 }
 
 template<>
-u32 ReadMMIO<u32>(MMIORegionPointer mmio_handler, VAddr addr) {
-    return mmio_handler->Read32(addr);
+u32 ReadMMIO<u32>(const SpecialRegion& region, VAddr addr) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    return region.handler->Read32(addr);
 }
 
 template<>
-u64 ReadMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr) {
-    return mmio_handler->Read64(addr);
+u64 ReadMMIO<u64>(const SpecialRegion& region, VAddr addr) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    return region.handler->Read64(addr);
 }
 
 template<>
-void WriteMMIO<u8>(MMIORegionPointer mmio_handler, VAddr addr, const u8 data) {
-    mmio_handler->Write8(addr, data);
+void WriteMMIO<u8>(const SpecialRegion& region, VAddr addr, const u8 data) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    region.handler->Write8(addr, data);
 }
 
 template<>
-void WriteMMIO<u16>(MMIORegionPointer mmio_handler, VAddr addr, const u16 data) {
-    mmio_handler->Write16(addr, data);
+void WriteMMIO<u16>(const SpecialRegion& region, VAddr addr, const u16 data) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    region.handler->Write16(addr, data);
 }
 
 template<>
-void WriteMMIO<u32>(MMIORegionPointer mmio_handler, VAddr addr, const u32 data) {
-    mmio_handler->Write32(addr, data);
+void WriteMMIO<u32>(const SpecialRegion& region, VAddr addr, const u32 data) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    region.handler->Write32(addr, data);
 }
 
 template<>
-void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data) {
-    mmio_handler->Write64(addr, data);
+void WriteMMIO<u64>(const SpecialRegion& region, VAddr addr, const u64 data) {
+    MICROPROFILE_SCOPE_TOKEN(region.profile_token);
+    region.handler->Write64(addr, data);
 }
 
 PAddr VirtualToPhysicalAddress(const VAddr addr) {
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <string>
 
@@ -18,6 +19,7 @@ namespace Memory {
 const u32 PAGE_SIZE = 0x1000;
 const u32 PAGE_MASK = PAGE_SIZE - 1;
 const int PAGE_BITS = 12;
+const size_t PAGE_TABLE_NUM_ENTRIES = 1 << (32 - PAGE_BITS);
 
 /// Physical memory regions as seen from the ARM11
 enum : PAddr {
@@ -136,6 +138,14 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, size_t size);
 
 u8* GetPointer(VAddr virtual_address);
 
+/**
+ * Returns the host pointers backing each page of the current address space, for use by CPU
+ * backends which inline the page table lookup into generated code. An entry is only non-null
+ * for pages of regular memory; accesses to any other page must go through Read/Write so that
+ * MMIO handlers and rasterizer cache flushes still run.
+ */
+std::array<u8*, PAGE_TABLE_NUM_ENTRIES>* GetCurrentPageTablePointers();
+
 std::string ReadCString(VAddr virtual_address, std::size_t max_length);
 
 /**
@@ -162,6 +172,12 @@ u8* GetPhysicalPointer(PAddr address);
  */
 void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta);
 
+/**
+ * Notifies the memory system that the rasterizer has written to its cached copy of the given
+ * region, so the next CPU read of it has to flush the rasterizer cache again.
+ */
+void RasterizerMarkRegionDirty(PAddr start, u32 size);
+
 /**
  * Flushes any externally cached rasterizer resources touching the given region.
  */
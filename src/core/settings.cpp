@@ -21,9 +21,11 @@ void Apply() {
     GDBStub::SetServerPort(static_cast<u32>(values.gdbstub_port));
     GDBStub::ToggleServer(values.use_gdbstub);
 
-    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
+    // The software renderer has no graphics context to run the OpenGL rasterizer in
+    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer && !values.use_software_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
     VideoCore::g_scaled_resolution_enabled = values.use_scaled_resolution;
+    VideoCore::g_gpu_thread_enabled = values.use_gpu_thread;
 
     // Ensure that texture caches are empty
 	VideoCore::g_is_rasterizer_dirty = true;
@@ -36,6 +38,7 @@ void Apply() {
 
     AudioCore::SelectSink(values.sink_id);
     AudioCore::EnableStretching(values.enable_audio_stretching);
+    AudioCore::EnableMultithreading(values.enable_audio_multithreading);
     InputCore::ReloadSettings();
 }
 
@@ -139,10 +139,14 @@ struct Values {
     int region_value;
 
     // Renderer
+    bool use_software_renderer;
     bool use_hw_renderer;
     bool use_shader_jit;
+    int shader_cache_size;
+    bool use_shader_disk_cache;
     bool use_scaled_resolution;
     bool use_vsync;
+    bool use_gpu_thread;
 	
     LayoutOption layout_option;
     bool swap_screen;
@@ -153,13 +157,17 @@ struct Values {
 
 	int tex_filter;
 	int tex_filter_scaling;
+    int tex_filter_cache_size;
+    bool use_tex_filter_disk_cache;
 
     std::string log_filter;
 
     // Audio
     std::string sink_id;
     std::string audio_device_id;
+    std::string audio_output_file;
     bool enable_audio_stretching;
+    bool enable_audio_multithreading;
 
     // Debugging
     bool use_gdbstub;
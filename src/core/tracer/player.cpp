@@ -0,0 +1,201 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/assert.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+
+#include "player.h"
+
+namespace CiTrace {
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Could not open CiTrace file %s", filename.c_str());
+        return false;
+    }
+
+    file_data.resize(static_cast<size_t>(file.GetSize()));
+    if (file.ReadBytes(file_data.data(), file_data.size()) != file_data.size()) {
+        LOG_ERROR(HW_GPU, "Failed to read CiTrace file %s", filename.c_str());
+        return false;
+    }
+
+    if (file_data.size() < sizeof(CTHeader)) {
+        LOG_ERROR(HW_GPU, "CiTrace file is too small to contain a header");
+        return false;
+    }
+    std::memcpy(&header, file_data.data(), sizeof(CTHeader));
+
+    if (std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), 4) != 0) {
+        LOG_ERROR(HW_GPU, "Invalid CiTrace magic word");
+        return false;
+    }
+    if (header.version != CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "Unsupported CiTrace version %u", header.version);
+        return false;
+    }
+
+    u64 stream_end = header.stream_offset + u64(header.stream_size) * sizeof(CTStreamElement);
+    if (stream_end > file_data.size()) {
+        LOG_ERROR(HW_GPU, "CiTrace stream exceeds the file size");
+        return false;
+    }
+    stream = reinterpret_cast<const CTStreamElement*>(file_data.data() + header.stream_offset);
+
+    frame_starts.clear();
+    size_t frame_start = 0;
+    for (size_t i = 0; i < header.stream_size; ++i) {
+        switch (stream[i].type) {
+        case FrameMarker:
+            frame_starts.push_back(frame_start);
+            frame_start = i + 1;
+            break;
+
+        case MemoryLoad:
+        {
+            const auto& load = stream[i].memory_load;
+            if (u64(load.file_offset) + load.size > file_data.size()) {
+                LOG_ERROR(HW_GPU, "CiTrace memory load %zu exceeds the file size", i);
+                return false;
+            }
+            break;
+        }
+
+        case RegisterWrite:
+            break;
+
+        default:
+            LOG_ERROR(HW_GPU, "Unknown CiTrace stream element type 0x%X", stream[i].type);
+            return false;
+        }
+    }
+
+    if (frame_start != header.stream_size) {
+        LOG_WARNING(HW_GPU, "Discarding %zu stream elements after the last frame marker",
+                    header.stream_size - frame_start);
+    }
+
+    return true;
+}
+
+const u32* Player::GetWords(u32 offset, u32 size) const {
+    if (u64(offset) + u64(size) * sizeof(u32) > file_data.size())
+        return nullptr;
+
+    return reinterpret_cast<const u32*>(file_data.data() + offset);
+}
+
+void Player::ApplyInitialState() const {
+    const auto& initial = header.initial_state_offsets;
+
+    // Copies as much of the given state block as fits into the destination object
+    auto CopyState = [this](void* dest, size_t dest_size, u32 offset, u32 size) {
+        const u32* words = GetWords(offset, size);
+        if (words == nullptr) {
+            LOG_ERROR(HW_GPU, "CiTrace initial state at 0x%08X exceeds the file size", offset);
+            return;
+        }
+        std::memcpy(dest, words, std::min<size_t>(dest_size, size * sizeof(u32)));
+    };
+
+    CopyState(&GPU::g_regs, sizeof(GPU::g_regs), initial.gpu_registers, initial.gpu_registers_size);
+    CopyState(&LCD::g_regs, sizeof(LCD::g_regs), initial.lcd_registers, initial.lcd_registers_size);
+    CopyState(&Pica::g_state.regs, sizeof(Pica::g_state.regs), initial.pica_registers, initial.pica_registers_size);
+
+    auto& vs = Pica::g_state.vs;
+    auto& gs = Pica::g_state.gs;
+    CopyState(vs.program_code.data(), sizeof(vs.program_code), initial.vs_program_binary, initial.vs_program_binary_size);
+    CopyState(vs.swizzle_data.data(), sizeof(vs.swizzle_data), initial.vs_swizzle_data, initial.vs_swizzle_data_size);
+    CopyState(gs.program_code.data(), sizeof(gs.program_code), initial.gs_program_binary, initial.gs_program_binary_size);
+    CopyState(gs.swizzle_data.data(), sizeof(gs.swizzle_data), initial.gs_swizzle_data, initial.gs_swizzle_data_size);
+    vs.MarkProgramDirty();
+    gs.MarkProgramDirty();
+
+    // Default attributes and float uniforms are stored as one float24 value per u32 word
+    auto LoadFloat24Vectors = [this](Math::Vec4<Pica::float24>* dest, size_t count, u32 offset, u32 size) {
+        const u32* words = GetWords(offset, size);
+        if (words == nullptr) {
+            LOG_ERROR(HW_GPU, "CiTrace initial state at 0x%08X exceeds the file size", offset);
+            return;
+        }
+        size_t num_words = std::min<size_t>(count * 4, size);
+        for (size_t i = 0; i < num_words; ++i)
+            dest[i / 4][i % 4] = Pica::float24::FromRaw(words[i] & 0xFFFFFF);
+    };
+
+    auto& default_attributes = Pica::g_state.vs_default_attributes;
+    LoadFloat24Vectors(default_attributes.data(), default_attributes.size(),
+                       initial.default_attributes, initial.default_attributes_size);
+    LoadFloat24Vectors(vs.uniforms.f, 96, initial.vs_float_uniforms, initial.vs_float_uniforms_size);
+    LoadFloat24Vectors(gs.uniforms.f, 96, initial.gs_float_uniforms, initial.gs_float_uniforms_size);
+
+    Pica::g_state.primitive_assembler.Reconfigure(Pica::g_state.regs.triangle_topology);
+}
+
+void Player::ReplayElement(const CTStreamElement& element) const {
+    switch (element.type) {
+    case MemoryLoad:
+    {
+        const auto& load = element.memory_load;
+        u8* dest = Memory::GetPhysicalPointer(load.physical_address);
+        if (dest == nullptr) {
+            LOG_ERROR(HW_GPU, "CiTrace memory load to unmapped address 0x%08X", load.physical_address);
+            break;
+        }
+        std::memcpy(dest, file_data.data() + load.file_offset, load.size);
+        break;
+    }
+
+    case RegisterWrite:
+    {
+        const auto& write = element.register_write;
+        VAddr addr = write.physical_address - Memory::IO_AREA_PADDR + Memory::IO_AREA_VADDR;
+        switch (write.size) {
+        case CTRegisterWrite::SIZE_8:
+            HW::Write<u8>(addr, static_cast<u8>(write.value));
+            break;
+        case CTRegisterWrite::SIZE_16:
+            HW::Write<u16>(addr, static_cast<u16>(write.value));
+            break;
+        case CTRegisterWrite::SIZE_32:
+            HW::Write<u32>(addr, static_cast<u32>(write.value));
+            break;
+        case CTRegisterWrite::SIZE_64:
+            HW::Write<u64>(addr, write.value);
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown CiTrace register write size 0x%X", write.size);
+            break;
+        }
+        break;
+    }
+
+    default:
+        // Frame markers are handled by the caller
+        break;
+    }
+}
+
+void Player::ReplayFrame(size_t frame) const {
+    ASSERT(frame < frame_starts.size());
+
+    for (size_t i = frame_starts[frame]; stream[i].type != FrameMarker; ++i)
+        ReplayElement(stream[i]);
+}
+
+} // namespace
@@ -0,0 +1,61 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+#include "citrace.h"
+
+namespace CiTrace {
+
+/**
+ * Loads a CiTrace file written by Recorder and plays it back through the emulated GPU.
+ * Memory loads are written to physical memory via the current process address space and
+ * register writes are dispatched through HW::Write, so the regular command processor, shader
+ * and rasterizer paths are exercised exactly as they were during recording.
+ */
+class Player {
+public:
+    /**
+     * Load a CiTrace from disk.
+     * @param filename Path to the .ctf file
+     * @return true on success, false if the file could not be read or is malformed
+     */
+    bool Load(const std::string& filename);
+
+    /// Overwrite the GPU, LCD and Pica state with the state captured at the start of the recording
+    void ApplyInitialState() const;
+
+    /// Returns the number of frame markers contained in the stream
+    size_t GetNumFrames() const {
+        return frame_starts.size();
+    }
+
+    /**
+     * Replay all stream elements belonging to the given frame, up to and including the frame
+     * marker which terminates it.
+     * @param frame Index of the frame to replay, must be smaller than GetNumFrames()
+     */
+    void ReplayFrame(size_t frame) const;
+
+private:
+    /// Returns a pointer to `size` u32 words at the given file offset, or nullptr if out of bounds
+    const u32* GetWords(u32 offset, u32 size) const;
+
+    void ReplayElement(const CTStreamElement& element) const;
+
+    std::vector<u8> file_data;
+    CTHeader header;
+
+    const CTStreamElement* stream = nullptr;
+
+    /// Index of the first stream element of each frame
+    std::vector<size_t> frame_starts;
+};
+
+} // namespace
@@ -0,0 +1,76 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "common/common_types.h"
+
+#include "core/aes/aes.h"
+
+/// Decrypts a part of the stream one block at a time with the portable AesCipher
+static std::vector<u8> ReferenceTransform(std::vector<u8> data, u64 offset,
+                                          const std::array<u8, 16>& key, const std::array<u8, 16>& ctr) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        const u64 position = offset + i;
+
+        std::array<u8, 16> block_ctr = ctr;
+        u64 block = position / 16;
+        while (block > 0xFFFFFFFF) {
+            AES::AddCtr(block_ctr, 0xFFFFFFFF);
+            block -= 0xFFFFFFFF;
+        }
+        AES::AddCtr(block_ctr, static_cast<u32>(block));
+
+        data[i] ^= AES::AesCipher(block_ctr, key)[position % 16];
+    }
+    return data;
+}
+
+TEST_CASE("AES::AesCipher matches the FIPS-197 example", "[core][aes]") {
+    const std::array<u8, 16> key = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const std::array<u8, 16> input = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                       0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    const std::array<u8, 16> expected = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+                                          0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+    REQUIRE(AES::AesCipher(input, key) == expected);
+}
+
+TEST_CASE("AES::AesCtrCipher matches block by block decryption", "[core][aes]") {
+    std::mt19937 rng(1);
+
+    std::array<u8, 16> key;
+    std::array<u8, 16> ctr;
+    for (auto& byte : key)
+        byte = static_cast<u8>(rng());
+    // Close to overflowing the lower words, so that carries into the upper words are covered
+    ctr.fill(0xFF);
+    ctr[15] = 0xEF;
+
+    // Uses AES-NI if the host CPU supports it
+    const AES::AesCtrCipher cipher(key, ctr);
+    const AES::AesCtrCipher portable_cipher(key, ctr, false);
+
+    for (int run = 0; run < 100; ++run) {
+        const u64 offset = (run == 0) ? 0x1234567890ull : rng() % 50000;
+        std::vector<u8> data(rng() % 5000);
+        for (u8& byte : data)
+            byte = static_cast<u8>(rng());
+
+        const std::vector<u8> expected = ReferenceTransform(data, offset, key, ctr);
+
+        std::vector<u8> portable = data;
+        portable_cipher.Transform(portable.data(), portable.size(), offset);
+        REQUIRE(portable == expected);
+
+        cipher.Transform(data.data(), data.size(), offset);
+        REQUIRE(data == expected);
+    }
+}
@@ -19,6 +19,7 @@
 
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
@@ -26,6 +27,8 @@
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/shader/shader.h"
+#include "video_core/texture_cache.h"
+#include "video_core/vertex_cache.h"
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
@@ -47,6 +50,15 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+static VertexCache vertex_cache;
+
+/// Returns whether writing the given register may change the output of the vertex shader
+static bool AffectsVertexShading(u32 id) {
+    return (id >= PICA_REG_INDEX(vertex_attributes) && id < PICA_REG_INDEX(index_array)) ||
+           (id >= PICA_REG_INDEX(vs_default_attributes_setup) && id < PICA_REG_INDEX(command_buffer)) ||
+           (id >= PICA_REG_INDEX(vs) && id < PICA_REG_INDEX(vs) + sizeof(Regs::ShaderConfig) / sizeof(u32));
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -64,6 +76,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     regs[id] = (old_value & ~write_mask) | (value & write_mask);
 
+    if (AffectsVertexShading(id))
+        vertex_cache.Invalidate();
+
     DebugUtils::OnPicaRegWrite({ (u16)id, (u16)mask, regs[id] });
 
     if (g_debug_context)
@@ -72,7 +87,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch(id) {
         // Trigger IRQ
         case PICA_REG_INDEX(trigger_irq):
-            GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::P3D);
+            VideoCore::GPUThread::SignalInterrupt(GSP_GPU::InterruptId::P3D);
             break;
 
         case PICA_REG_INDEX_WORKAROUND(triangle_topology, 0x25E):
@@ -195,7 +210,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
             // Processes information about internal vertex attributes to figure out how a vertex is loaded.
-            // Later, these can be compiled and cached.
+            // With the shader JIT enabled, the loader is compiled once per attribute layout and cached.
             const u32 base_address = regs.vertex_attributes.GetPhysicalBaseAddress();
             VertexLoader loader(regs);
 
@@ -227,14 +242,13 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
             DebugUtils::MemoryAccessTracker memory_accesses;
 
-            // Simple circular-replacement vertex cache
-            // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-            const size_t VERTEX_CACHE_SIZE = 32;
-            std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-            std::array<Shader::OutputRegisters, VERTEX_CACHE_SIZE> vertex_cache;
+            // Vertices shaded by previous draws may be reused unless the shader setup changed in
+            // between, but the debugger needs to see every vertex being loaded
+            if (g_debug_context)
+                vertex_cache.Invalidate();
 
-            unsigned int vertex_cache_pos = 0;
-            vertex_cache_ids.fill(-1);
+            unsigned int cache_hits = 0;
+            unsigned int cache_misses = 0;
 
             auto& vs_shader_unit = Shader::GetShaderUnit(false);
             g_state.vs.Setup();
@@ -242,101 +256,135 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             auto& gs_unit_state = Shader::GetShaderUnit(true);
             g_state.gs.Setup();
 
-            for (unsigned int index = 0; index < regs.num_vertices; ++index)
+            // Cache misses are shaded in batches. Each batch is gathered from a window of indices,
+            // which is then assembled in order once all of its vertices have been shaded.
+            const unsigned int batch_size = g_debug_context ? 1 : Shader::MAX_BATCH_SIZE;
+            Shader::BatchUnitState batch_state;
+            std::array<Shader::InputVertex, Shader::MAX_BATCH_SIZE> batch_inputs;
+            std::array<Shader::OutputRegisters, Shader::MAX_BATCH_SIZE> batch_outputs;
+            std::array<u16, Shader::MAX_BATCH_SIZE> batch_ids;
+            std::array<Shader::OutputRegisters*, 4 * Shader::MAX_BATCH_SIZE> window_outputs;
+
+            for (unsigned int window_start = 0; window_start < regs.num_vertices;)
             {
-                // Indexed rendering doesn't use the start offset
-                unsigned int vertex = is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index]) : (index + regs.vertex_offset);
+                unsigned int window_end = window_start;
+                unsigned int batch_count = 0;
 
-                // -1 is a common special value used for primitive restart. Since it's unknown if
-                // the PICA supports it, and it would mess up the caching, guard against it here.
-                ASSERT(vertex != -1);
+                for (; window_end < regs.num_vertices && window_end - window_start < window_outputs.size(); ++window_end) {
+                    const unsigned int index = window_end;
 
-                bool vertex_cache_hit = false;
-                Shader::OutputRegisters output_registers;
+                    // Indexed rendering doesn't use the start offset
+                    unsigned int vertex = is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index]) : (index + regs.vertex_offset);
 
-                if (is_indexed) {
-                    if (g_debug_context && Pica::g_debug_context->recorder) {
-                        int size = index_u16 ? 2 : 1;
-                        memory_accesses.AddAccess(base_address + index_info.offset + size * index, size);
-                    }
+                    // -1 is a common special value used for primitive restart. Since it's unknown if
+                    // the PICA supports it, and it would mess up the caching, guard against it here.
+                    ASSERT(vertex != -1);
 
-                    for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                        if (vertex == vertex_cache_ids[i]) {
-                            output_registers = vertex_cache[i];
-                            vertex_cache_hit = true;
-                            break;
+                    Shader::OutputRegisters* output_registers = vertex_cache.Lookup(vertex);
+
+                    // The vertex may also have been queued for shading earlier in this window
+                    if (is_indexed) {
+                        for (unsigned int i = 0; i < batch_count && !output_registers; ++i) {
+                            if (vertex == batch_ids[i])
+                                output_registers = &batch_outputs[i];
                         }
                     }
-                }
 
-                if (!vertex_cache_hit) {
-                    // Initialize data for the current vertex
-                    Shader::InputVertex input;
-                    loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                    if (output_registers) {
+                        ++cache_hits;
+                    } else {
+                        if (batch_count == batch_size)
+                            break;
 
-                    // Send to vertex shader
-                    if (g_debug_context)
-                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation, (void*)&input);
-                    g_state.vs.Run(vs_shader_unit, input, loader.GetNumTotalAttributes(), regs.vs);
-                    output_registers = vs_shader_unit.output_registers;
+                        // Initialize data for the current vertex
+                        Shader::InputVertex& input = batch_inputs[batch_count];
+                        loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
 
-                    if (is_indexed) {
-                        vertex_cache[vertex_cache_pos] = output_registers;
-                        vertex_cache_ids[vertex_cache_pos] = vertex;
-                        vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                        if (g_debug_context)
+                            g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation, (void*)&input);
+
+                        batch_ids[batch_count] = vertex;
+                        output_registers = &batch_outputs[batch_count++];
+                        ++cache_misses;
+                    }
+
+                    if (is_indexed && g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index, size);
                     }
+
+                    window_outputs[index - window_start] = output_registers;
                 }
 
-                // Helper to send triangle to renderer
-                using Pica::Shader::OutputVertex;
-                auto AddTriangle = [](
-                        const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
-                    VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
-                };
-
-                if (Shader::UseGS()) {
-
-                    auto& regs = g_state.regs;
-                    auto& gs_regs = g_state.regs.gs;
-                    auto& gs_buf = g_state.gs_input_buffer;
-
-                    // Vertex Shader Outputs are converted into Geometry Shader inputs by filling up a buffer
-                    // For example, if we have a geoshader that takes 6 inputs, and the vertex shader outputs 2 attributes
-                    // It would take 3 vertices to fill up the Geometry Shader buffer
-                    unsigned int gs_input_count = gs_regs.num_input_attributes + 1;
-                    unsigned int vs_output_count = regs.vs_outmap_total2 + 1;
-                    ASSERT_MSG(regs.vs_outmap_total1 == regs.vs_outmap_total2, "VS_OUTMAP_TOTAL1 and VS_OUTMAP_TOTAL2 don't match!");
-                    // copy into the geoshader buffer
-                    for (unsigned int i = 0; i < vs_output_count; i++) {
-                        if (gs_buf.index >= gs_input_count) {
-                            // TODO(ds84182): LOG_ERROR()
-                            ASSERT_MSG(false, "Number of GS inputs (%d) is not divisible by number of VS outputs (%d)",
-                                        gs_input_count, vs_output_count);
-                            continue;
+                // Send to vertex shader
+                g_state.vs.RunBatch(vs_shader_unit, batch_state, batch_inputs.data(), batch_count,
+                                    loader.GetNumTotalAttributes(), regs.vs, batch_outputs.data());
+
+                for (unsigned int index = window_start; index < window_end; ++index) {
+                    Shader::OutputRegisters& output_registers = *window_outputs[index - window_start];
+
+                    // Helper to send triangle to renderer
+                    using Pica::Shader::OutputVertex;
+                    auto AddTriangle = [](
+                            const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+                        VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
+                    };
+                    auto AddTriangles = [](const OutputVertex* vertices, size_t num_triangles) {
+                        VideoCore::g_renderer->Rasterizer()->AddTriangles(vertices, num_triangles);
+                    };
+
+                    if (Shader::UseGS()) {
+
+                        auto& regs = g_state.regs;
+                        auto& gs_regs = g_state.regs.gs;
+                        auto& gs_buf = g_state.gs_input_buffer;
+
+                        // Vertex Shader Outputs are converted into Geometry Shader inputs by filling up a buffer
+                        // For example, if we have a geoshader that takes 6 inputs, and the vertex shader outputs 2 attributes
+                        // It would take 3 vertices to fill up the Geometry Shader buffer
+                        unsigned int gs_input_count = gs_regs.num_input_attributes + 1;
+                        unsigned int vs_output_count = regs.vs_outmap_total2 + 1;
+                        ASSERT_MSG(regs.vs_outmap_total1 == regs.vs_outmap_total2, "VS_OUTMAP_TOTAL1 and VS_OUTMAP_TOTAL2 don't match!");
+                        // copy into the geoshader buffer
+                        for (unsigned int i = 0; i < vs_output_count; i++) {
+                            if (gs_buf.index >= gs_input_count) {
+                                // TODO(ds84182): LOG_ERROR()
+                                ASSERT_MSG(false, "Number of GS inputs (%d) is not divisible by number of VS outputs (%d)",
+                                            gs_input_count, vs_output_count);
+                                continue;
+                            }
+                            gs_buf.buffer.attr[gs_buf.index++] = output_registers.value[i];
                         }
-                        gs_buf.buffer.attr[gs_buf.index++] = output_registers.value[i];
-                    }
 
-                    if (gs_buf.index >= gs_input_count) {
+                        if (gs_buf.index >= gs_input_count) {
 
-                        // b15 will be false when a new primitive starts and then switch to true at some point
-                        //TODO: Test how this works exactly on hardware
-                        g_state.gs.uniforms.b[15] |= (index > 0);
+                            // b15 will be false when a new primitive starts and then switch to true at some point
+                            //TODO: Test how this works exactly on hardware
+                            g_state.gs.uniforms.b[15] |= (index > 0);
 
-                        // Process Geometry Shader
-                        if (g_debug_context)
-                            g_debug_context->OnEvent(DebugContext::Event::GeometryShaderInvocation, static_cast<void*>(&gs_buf.buffer));
-                        gs_unit_state.emit_triangle_callback = AddTriangle;
-                        g_state.gs.Run(gs_unit_state, gs_buf.buffer, gs_input_count, regs.gs);
-                        gs_unit_state.emit_triangle_callback = nullptr;
+                            // Process Geometry Shader
+                            if (g_debug_context)
+                                g_debug_context->OnEvent(DebugContext::Event::GeometryShaderInvocation, static_cast<void*>(&gs_buf.buffer));
+                            // Emitted triangles are buffered and handed to the rasterizer together
+                            gs_unit_state.emit_triangles_callback = AddTriangles;
+                            g_state.gs.Run(gs_unit_state, gs_buf.buffer, gs_input_count, regs.gs);
+                            Shader::FlushEmittedTriangles(gs_unit_state);
+                            gs_unit_state.emit_triangles_callback = nullptr;
 
-                        gs_buf.index = 0;
+                            gs_buf.index = 0;
+                        }
+                    } else {
+                        Shader::OutputVertex output_vertex = output_registers.ToVertex(regs.vs);
+                        primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
                     }
-                } else {
-                    Shader::OutputVertex output_vertex = output_registers.ToVertex(regs.vs);
-                    primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+
                 }
 
+                // The cache is only updated after the window, since the window refers to its entries
+                for (unsigned int i = 0; i < batch_count; ++i)
+                    vertex_cache.Insert(batch_ids[i], batch_outputs[i]);
+
+                window_start = window_end;
             }
 
             for (auto& range : memory_accesses.ranges) {
@@ -344,6 +392,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                                                           range.second, range.first);
             }
 
+            MICROPROFILE_META_CPU("Vertex cache hits", cache_hits);
+            MICROPROFILE_META_CPU("Vertex cache misses", cache_misses);
+
             VideoCore::g_renderer->Rasterizer()->DrawTriangles();
 
             if (g_debug_context) {
@@ -532,6 +583,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 }
 
 void ProcessCommandList(const u32* list, u32 size) {
+    // The vertex data and textures may have been modified since the last command list was processed
+    vertex_cache.Invalidate();
+    TextureCache::MarkAllUnverified();
+
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
 
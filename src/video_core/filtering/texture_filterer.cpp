@@ -2,13 +2,208 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
-#include "common/vector_math.h"
-#include "core/memory.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/string_util.h"
+#include "common/thread_pool.h"
+#include "core/loader/ncch.h"
 #include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/filtering/texture_filterer.h"
 #include "video_core/filtering/xbrz/xbrz.h"
+#include "video_core/video_core.h"
+
+namespace Filtering {
+
+/// Identifies the result of filtering some texture contents with some settings
+struct FilterKey {
+    u64 source_hash;
+    u32 width;
+    u32 height;
+    u32 scaling;
+    FilteringTypes type;
+    xbrz::ColorFormat color_format;
+
+    bool operator==(const FilterKey& other) const {
+        return std::tie(source_hash, width, height, scaling, type, color_format) ==
+               std::tie(other.source_hash, other.width, other.height, other.scaling, other.type,
+                        other.color_format);
+    }
+};
+
+struct FilterKeyHash {
+    size_t operator()(const FilterKey& key) const {
+        return key.source_hash ^ (static_cast<size_t>(key.width) << 16 | key.height) ^
+               (static_cast<size_t>(key.scaling) << 40);
+    }
+};
+
+struct FilteredTexture {
+    /// Unfiltered texels, compared on lookup so that hash collisions can't return wrong results
+    std::vector<u32> source;
+    std::vector<u32> filtered;
+
+    size_t GetSize() const {
+        return (source.size() + filtered.size()) * sizeof(u32);
+    }
+};
+
+/**
+ * Least recently used filtering results, bounded by the tex_filter_cache_size setting. Textures
+ * are uploaded from the render thread only, so no locking is needed.
+ */
+class FilterCache {
+public:
+    const FilteredTexture* Get(const FilterKey& key, const u32* source, size_t source_size) {
+        auto iter = entries.find(key);
+        if (iter == entries.end())
+            return nullptr;
+
+        const FilteredTexture& texture = iter->second->second;
+        if (texture.source.size() != source_size ||
+            std::memcmp(texture.source.data(), source, source_size * sizeof(u32)) != 0)
+            return nullptr;
+
+        lru.splice(lru.begin(), lru, iter->second);
+        return &texture;
+    }
+
+    void Insert(const FilterKey& key, FilteredTexture texture) {
+        const size_t capacity =
+            static_cast<size_t>(std::max(Settings::values.tex_filter_cache_size, 0)) * 1024 * 1024;
+        if (texture.GetSize() > capacity)
+            return;
+
+        auto iter = entries.find(key);
+        if (iter != entries.end()) {
+            size -= iter->second->second.GetSize();
+            lru.erase(iter->second);
+            entries.erase(iter);
+        }
+
+        while (!lru.empty() && size + texture.GetSize() > capacity) {
+            size -= lru.back().second.GetSize();
+            entries.erase(lru.back().first);
+            lru.pop_back();
+        }
+
+        size += texture.GetSize();
+        lru.emplace_front(key, std::move(texture));
+        entries[key] = lru.begin();
+    }
+
+private:
+    using Entry = std::pair<FilterKey, FilteredTexture>;
+
+    std::list<Entry> lru;
+    std::unordered_map<FilterKey, std::list<Entry>::iterator, FilterKeyHash> entries;
+    size_t size = 0;
+};
+
+static FilterCache filter_cache;
+
+/// xBRZ slices are made of at least this many rows, below which the slice overhead dominates
+static const int MIN_ROWS_PER_SLICE = 16;
+
+/// Header of the files of the disk cache, followed by the unfiltered and the filtered texels
+struct DiskCacheHeader {
+    u32 magic;
+    u32 version;
+    u32 width;
+    u32 height;
+    u32 scaling;
+    u32 type;
+    u32 color_format;
+};
+
+static const u32 DISK_CACHE_MAGIC = 0x5A524258; // "XBRZ"
+static const u32 DISK_CACHE_VERSION = 1;
+
+MICROPROFILE_DEFINE(GPU_TextureFiltering, "GPU", "Texture Filtering", MP_RGB(200, 100, 200));
+
+/// Returns the disk cache file of the given filtering result, or an empty string if disabled
+static std::string GetDiskCachePath(const FilterKey& key) {
+    if (!Settings::values.use_tex_filter_disk_cache || Loader::program_id == 0)
+        return {};
+
+    const u64 key_hash = Common::ComputeHash64(&key, static_cast<int>(sizeof(key)));
+    return FileUtil::GetUserPath(D_CACHE_IDX) + "filtered_textures" DIR_SEP +
+           Common::StringFromFormat("%016" PRIX64 DIR_SEP "%016" PRIX64 ".bin",
+                                    static_cast<u64>(Loader::program_id), key_hash);
+}
+
+static bool LoadFromDisk(const std::string& path, const FilterKey& key, const u32* source,
+                         size_t source_size, FilteredTexture& texture) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen())
+        return false;
+
+    DiskCacheHeader header;
+    if (!file.ReadArray(&header, 1) || header.magic != DISK_CACHE_MAGIC ||
+        header.version != DISK_CACHE_VERSION || header.width != key.width ||
+        header.height != key.height || header.scaling != key.scaling ||
+        header.type != static_cast<u32>(key.type) ||
+        header.color_format != static_cast<u32>(key.color_format))
+        return false;
+
+    texture.source.resize(source_size);
+    texture.filtered.resize(source_size * key.scaling * key.scaling);
+    if (file.ReadArray(texture.source.data(), texture.source.size()) != texture.source.size() ||
+        file.ReadArray(texture.filtered.data(), texture.filtered.size()) != texture.filtered.size())
+        return false;
+
+    return std::memcmp(texture.source.data(), source, source_size * sizeof(u32)) == 0;
+}
+
+static void SaveToDisk(const std::string& path, const FilterKey& key, const FilteredTexture& texture) {
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(HW_GPU, "Failed to create filtered texture cache directory for %s", path.c_str());
+        return;
+    }
+
+    FileUtil::IOFile file(path, "wb");
+    const DiskCacheHeader header = {
+        DISK_CACHE_MAGIC, DISK_CACHE_VERSION, key.width, key.height, key.scaling,
+        static_cast<u32>(key.type), static_cast<u32>(key.color_format)
+    };
+    if (!file.WriteArray(&header, 1) ||
+        file.WriteArray(texture.source.data(), texture.source.size()) != texture.source.size() ||
+        file.WriteArray(texture.filtered.data(), texture.filtered.size()) != texture.filtered.size()) {
+        LOG_ERROR(HW_GPU, "Failed to write filtered texture %s", path.c_str());
+    }
+}
+
+/// Scales an image with xBRZ, splitting its rows into slices processed by the thread pool
+static void ScaleXbrz(size_t factor, const u32* source, u32* target, int width, int height,
+                      xbrz::ColorFormat color_format) {
+    Common::ThreadPool& thread_pool = VideoCore::GetThreadPool();
+
+    const int num_threads = static_cast<int>(thread_pool.GetNumThreads());
+    const int rows_per_slice = std::max(MIN_ROWS_PER_SLICE, (height + num_threads - 1) / num_threads);
+    const int num_slices = (height + rows_per_slice - 1) / rows_per_slice;
+
+    // Slices only write their own target rows, so they can run concurrently
+    thread_pool.ParallelFor(num_slices, [&](size_t slice) {
+        const int first = static_cast<int>(slice) * rows_per_slice;
+        xbrz::scale(factor, source, target, width, height, color_format, xbrz::ScalerCfg(),
+                    first, std::min(first + rows_per_slice, height));
+    });
+}
+
+} // namespace Filtering
 
 bool Filtering::isScalingEnabled() {
     int scaling = Filtering::getScaling();
@@ -34,18 +229,45 @@ void Filtering::filterTexture(Pica::DebugUtils::TextureInfo tex_info, unsigned i
                               unsigned int* toBuffer) {
     // Discover filtering type
     Filtering::FilteringTypes type = getScalingType();
+    if (type != Filtering::FilteringTypes::XBRZ)
+        return;
 
-    switch (type) {
-    case Filtering::FilteringTypes::XBRZ:
-        if (tex_info.format == Pica::Regs::TextureFormat::RGB8) {
-            xbrz::scale(Filtering::getScaling(), fromBuffer, toBuffer, tex_info.width,
-                        tex_info.height, xbrz::ColorFormat::RGB);
-        } else {
-            xbrz::scale(Filtering::getScaling(), fromBuffer, toBuffer, tex_info.width,
-                        tex_info.height, xbrz::ColorFormat::ARGB);
-        }
-        break;
+    MICROPROFILE_SCOPE(GPU_TextureFiltering);
+
+    const xbrz::ColorFormat color_format = tex_info.format == Pica::Regs::TextureFormat::RGB8
+                                               ? xbrz::ColorFormat::RGB
+                                               : xbrz::ColorFormat::ARGB;
+    const size_t source_size = tex_info.width * tex_info.height;
+
+    FilterKey key;
+    std::memset(&key, 0, sizeof(key)); // The key is hashed as raw bytes, including padding
+    key.source_hash = Common::ComputeHash64(fromBuffer, static_cast<int>(source_size * sizeof(u32)));
+    key.width = tex_info.width;
+    key.height = tex_info.height;
+    key.scaling = getScaling();
+    key.type = type;
+    key.color_format = color_format;
+
+    // Games often upload the same contents again, e.g. when a surface is recreated
+    if (const FilteredTexture* cached = filter_cache.Get(key, fromBuffer, source_size)) {
+        std::copy(cached->filtered.begin(), cached->filtered.end(), toBuffer);
+        return;
+    }
+
+    FilteredTexture texture;
+    const std::string disk_path = GetDiskCachePath(key);
+    if (disk_path.empty() || !LoadFromDisk(disk_path, key, fromBuffer, source_size, texture)) {
+        texture.source.assign(fromBuffer, fromBuffer + source_size);
+        texture.filtered.resize(source_size * key.scaling * key.scaling);
+        ScaleXbrz(key.scaling, fromBuffer, texture.filtered.data(), tex_info.width,
+                  tex_info.height, color_format);
+
+        if (!disk_path.empty())
+            SaveToDisk(disk_path, key, texture);
     }
+
+    std::copy(texture.filtered.begin(), texture.filtered.end(), toBuffer);
+    filter_cache.Insert(key, std::move(texture));
 }
 
 int Filtering::getScaledTextureSize(Pica::Regs::TextureFormat format, int width, int height) {
@@ -0,0 +1,168 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+
+#include "core/core_timing.h"
+#include "core/tracer/recorder.h"
+
+#include "video_core/command_processor.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+namespace GPUThread {
+
+struct CommandList {
+    const u32* list;
+    u32 size;
+};
+
+/// Maximum number of command lists which may be queued before the emulation thread has to wait
+static const size_t RING_SIZE = 64;
+
+static std::array<CommandList, RING_SIZE> ring;
+/// Number of command lists submitted so far; the next one is stored at ring[write_index % RING_SIZE]
+static u64 write_index;
+/// Number of command lists processed so far
+static u64 read_index;
+
+static std::mutex ring_mutex;
+/// Signalled when a command list has been queued or the thread should stop
+static std::condition_variable work_available;
+/// Signalled when a command list has been processed
+static std::condition_variable work_done;
+static bool stop_requested;
+
+static std::unique_ptr<std::thread> gpu_thread;
+/// True on the GPU thread, so that fences issued while processing a command list don't deadlock
+static thread_local bool is_gpu_thread = false;
+
+/// Event id for CoreTiming, used to raise interrupts on the emulation thread
+static int interrupt_event;
+
+MICROPROFILE_DEFINE(GPU_ThreadCmdlist, "GPU", "Cmdlist Processing (thread)", MP_RGB(100, 255, 100));
+MICROPROFILE_DEFINE(GPU_WaitForIdle, "GPU", "Wait for GPU thread", MP_RGB(255, 100, 100));
+
+static void ThreadFunc() {
+    Common::SetCurrentThreadName("GPU");
+    MicroProfileOnThreadCreate("GPU");
+    is_gpu_thread = true;
+
+    std::unique_lock<std::mutex> lock(ring_mutex);
+    while (true) {
+        work_available.wait(lock, [] { return stop_requested || read_index != write_index; });
+        if (read_index == write_index)
+            break;
+
+        // The slot stays occupied until the list has been processed, so an empty ring means idle
+        CommandList command_list = ring[read_index % RING_SIZE];
+        lock.unlock();
+
+        {
+            MICROPROFILE_SCOPE(GPU_ThreadCmdlist);
+            Pica::CommandProcessor::ProcessCommandList(command_list.list, command_list.size);
+        }
+
+        lock.lock();
+        ++read_index;
+        work_done.notify_all();
+    }
+    lock.unlock();
+
+    MicroProfileOnThreadExit();
+}
+
+static void InterruptCallback(u64 userdata, int cycles_late) {
+    GSP_GPU::SignalInterrupt(static_cast<GSP_GPU::InterruptId>(userdata));
+}
+
+/// Returns true if command lists should be handed to the GPU thread right now
+static bool UseGPUThread() {
+    if (gpu_thread == nullptr || !g_gpu_thread_enabled || g_hw_renderer_enabled)
+        return false;
+
+    // The recorder is not thread-safe, so keep everything on the emulation thread while recording
+    return !(Pica::g_debug_context && Pica::g_debug_context->recorder);
+}
+
+void Init() {
+    interrupt_event = CoreTiming::RegisterEvent("GPUThread::InterruptCallback", InterruptCallback);
+
+    if (!g_gpu_thread_enabled)
+        return;
+
+    write_index = 0;
+    read_index = 0;
+    stop_requested = false;
+    gpu_thread = std::make_unique<std::thread>(ThreadFunc);
+
+    LOG_INFO(HW_GPU, "GPU thread started");
+}
+
+void Shutdown() {
+    if (gpu_thread == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        stop_requested = true;
+    }
+    work_available.notify_one();
+    gpu_thread->join();
+    gpu_thread = nullptr;
+
+    LOG_INFO(HW_GPU, "GPU thread stopped");
+}
+
+void SubmitCommandList(const u32* list, u32 size) {
+    if (!UseGPUThread()) {
+        // Keep the submission order if the GPU thread has just been disabled
+        WaitForIdle();
+        Pica::CommandProcessor::ProcessCommandList(list, size);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(ring_mutex);
+        work_done.wait(lock, [] { return write_index - read_index < RING_SIZE; });
+        ring[write_index % RING_SIZE] = { list, size };
+        ++write_index;
+    }
+    work_available.notify_one();
+}
+
+void WaitForIdle() {
+    if (gpu_thread == nullptr || is_gpu_thread)
+        return;
+
+    std::unique_lock<std::mutex> lock(ring_mutex);
+    if (read_index == write_index)
+        return;
+
+    MICROPROFILE_SCOPE(GPU_WaitForIdle);
+    work_done.wait(lock, [] { return read_index == write_index; });
+}
+
+void SignalInterrupt(GSP_GPU::InterruptId interrupt_id) {
+    if (is_gpu_thread) {
+        CoreTiming::ScheduleEvent_Threadsafe_Immediate(interrupt_event, static_cast<u64>(interrupt_id));
+    } else {
+        GSP_GPU::SignalInterrupt(interrupt_id);
+    }
+}
+
+} // namespace
+
+} // namespace
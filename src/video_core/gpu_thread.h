@@ -0,0 +1,49 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+#include "core/hle/service/gsp_gpu.h"
+
+namespace VideoCore {
+
+/**
+ * Optional worker thread which runs PICA command lists concurrently with the emulated CPU.
+ *
+ * Command lists are queued in a bounded ring and processed in submission order. Anything that
+ * observes the results of GPU work from the emulation thread (memory fills, display transfers,
+ * flushes of rasterizer cached memory, remapping memory and presenting a frame) has to call
+ * WaitForIdle() first. The thread is only used with the software rasterizer, since the OpenGL
+ * context is bound to the emulation thread, and it is bypassed while a CiTrace is recorded.
+ */
+namespace GPUThread {
+
+/// Starts the GPU thread if it has been enabled in the settings
+void Init();
+
+/// Waits for all pending command lists and stops the GPU thread
+void Shutdown();
+
+/**
+ * Processes the given command list, either on the GPU thread or synchronously if the GPU thread
+ * is not used at the moment.
+ * @param list Pointer to the command list, which has to stay valid until it has been processed
+ * @param size Size of the command list in bytes
+ */
+void SubmitCommandList(const u32* list, u32 size);
+
+/**
+ * Blocks until all submitted command lists have been processed. Returns immediately if the GPU
+ * thread is not running or if called from the GPU thread itself.
+ */
+void WaitForIdle();
+
+/// Signals a GSP interrupt raised by the command processor on the emulation thread
+void SignalInterrupt(GSP_GPU::InterruptId interrupt_id);
+
+} // namespace
+
+} // namespace
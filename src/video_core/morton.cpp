@@ -0,0 +1,547 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/math_util.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/morton.h"
+#include "video_core/utils.h"
+
+namespace VideoCore {
+
+struct TexelPosition {
+    u8 x;
+    u8 y;
+};
+
+/// Positions of the texels of an 8x8 tile, in the order they are stored in
+static const std::array<TexelPosition, 64> morton_positions = [] {
+    std::array<TexelPosition, 64> positions;
+    for (u8 y = 0; y < 8; ++y)
+        for (u8 x = 0; x < 8; ++x)
+            positions[MortonInterleave(x, y)] = { x, y };
+    return positions;
+}();
+
+// Horizontally adjacent texels are stored next to each other, so the generic routines move two
+// texels at a time.
+
+template <u32 bytes_per_pixel>
+static void UnswizzleTile(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned i = 0; i < 64; i += 2) {
+        const TexelPosition pos = morton_positions[i];
+        std::memcpy(linear + pos.y * linear_stride + pos.x * bytes_per_pixel,
+                    tile + i * bytes_per_pixel, 2 * bytes_per_pixel);
+    }
+}
+
+template <u32 bytes_per_pixel>
+static void SwizzleTile(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned i = 0; i < 64; i += 2) {
+        const TexelPosition pos = morton_positions[i];
+        std::memcpy(tile + i * bytes_per_pixel,
+                    linear + pos.y * linear_stride + pos.x * bytes_per_pixel, 2 * bytes_per_pixel);
+    }
+}
+
+void UnswizzleTile2_Generic(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    UnswizzleTile<2>(tile, linear, linear_stride);
+}
+
+void UnswizzleTile3_Generic(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    UnswizzleTile<3>(tile, linear, linear_stride);
+}
+
+void UnswizzleTile4_Generic(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    UnswizzleTile<4>(tile, linear, linear_stride);
+}
+
+void SwizzleTile2_Generic(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    SwizzleTile<2>(tile, linear, linear_stride);
+}
+
+void SwizzleTile3_Generic(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    SwizzleTile<3>(tile, linear, linear_stride);
+}
+
+void SwizzleTile4_Generic(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    SwizzleTile<4>(tile, linear, linear_stride);
+}
+
+/// Unswizzles 24-bit depth texels to 32-bit linear pixels, leaving the lowest byte zero
+static void UnswizzleTileD24(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned i = 0; i < 64; ++i) {
+        const TexelPosition pos = morton_positions[i];
+        u8* pixel = linear + pos.y * linear_stride + pos.x * 4;
+        pixel[0] = 0;
+        std::memcpy(pixel + 1, tile + i * 3, 3);
+    }
+}
+
+static void SwizzleTileD24(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned i = 0; i < 64; ++i) {
+        const TexelPosition pos = morton_positions[i];
+        std::memcpy(tile + i * 3, linear + pos.y * linear_stride + pos.x * 4 + 1, 3);
+    }
+}
+
+/**
+ * Rotates D24S8 texels between the PICA layout (stencil in the top byte) and the OpenGL layout
+ * (stencil in the bottom byte).
+ */
+static void RotateDepthStencil(u8* data, u32 count, bool pica_to_gl) {
+    for (u32 i = 0; i < count; ++i) {
+        u32 value;
+        std::memcpy(&value, data + i * 4, sizeof(u32));
+        value = pica_to_gl ? (value << 8) | (value >> 24) : (value << 24) | (value >> 8);
+        std::memcpy(data + i * 4, &value, sizeof(u32));
+    }
+}
+
+/// Returns the offset of a texel in a tiled surface, which may not be a whole number of tiles wide
+static u32 GetTiledOffset(u32 x, u32 y, u32 width, u32 bytes_per_pixel) {
+    return GetMortonOffset(x, y, bytes_per_pixel) + (y & ~7) * width * bytes_per_pixel;
+}
+
+/**
+ * Unswizzles the texels of the partial tiles at the right and bottom edges of a surface whose size
+ * isn't a multiple of 8, one at a time.
+ */
+static void UnswizzleEdgeTexels(u32 width, u32 height, u32 bytes_per_pixel, const u8* tiled, u8* linear,
+                                ptrdiff_t linear_stride, MortonConversion conversion) {
+    const u32 tiled_width = width & ~7;
+    const u32 tiled_height = height & ~7;
+    const bool pad_d24 = conversion == MortonConversion::PadD24;
+    const u32 linear_bytes_per_pixel = pad_d24 ? 4 : bytes_per_pixel;
+
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = (y < tiled_height) ? tiled_width : 0; x < width; ++x) {
+            u8* pixel = linear + static_cast<ptrdiff_t>(y) * linear_stride + x * linear_bytes_per_pixel;
+            if (pad_d24)
+                *pixel++ = 0;
+
+            std::memcpy(pixel, tiled + GetTiledOffset(x, y, width, bytes_per_pixel), bytes_per_pixel);
+            if (conversion == MortonConversion::RotateDepthStencil)
+                RotateDepthStencil(pixel, 1, true);
+        }
+    }
+}
+
+static void SwizzleEdgeTexels(u32 width, u32 height, u32 bytes_per_pixel, u8* tiled, const u8* linear,
+                              ptrdiff_t linear_stride, MortonConversion conversion) {
+    const u32 tiled_width = width & ~7;
+    const u32 tiled_height = height & ~7;
+    const bool pad_d24 = conversion == MortonConversion::PadD24;
+    const u32 linear_bytes_per_pixel = pad_d24 ? 4 : bytes_per_pixel;
+
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = (y < tiled_height) ? tiled_width : 0; x < width; ++x) {
+            const u8* pixel = linear + static_cast<ptrdiff_t>(y) * linear_stride + x * linear_bytes_per_pixel;
+            u8* texel = tiled + GetTiledOffset(x, y, width, bytes_per_pixel);
+
+            std::memcpy(texel, pad_d24 ? pixel + 1 : pixel, bytes_per_pixel);
+            if (conversion == MortonConversion::RotateDepthStencil)
+                RotateDepthStencil(texel, 1, false);
+        }
+    }
+}
+
+void MortonUnswizzle(u32 width, u32 height, u32 bytes_per_pixel, const u8* tiled, u8* linear,
+                     ptrdiff_t linear_stride, MortonConversion conversion) {
+    UnswizzleTileFunc unswizzle_tile = GetUnswizzleTileFunc(bytes_per_pixel);
+    u32 linear_bytes_per_pixel = bytes_per_pixel;
+    if (conversion == MortonConversion::PadD24) {
+        ASSERT(bytes_per_pixel == 3);
+        unswizzle_tile = UnswizzleTileD24;
+        linear_bytes_per_pixel = 4;
+    }
+    ASSERT(conversion != MortonConversion::RotateDepthStencil || bytes_per_pixel == 4);
+
+    // Whole tiles are converted in bulk, the texels of partial ones at the edges afterwards
+    const u32 tiled_width = width & ~7;
+    const u32 tiled_height = height & ~7;
+
+    for (u32 y = 0; y < tiled_height; y += 8) {
+        u8* const rows = linear + static_cast<ptrdiff_t>(y) * linear_stride;
+        const u8* tile = tiled + y * width * bytes_per_pixel;
+        for (u32 x = 0; x < tiled_width; x += 8) {
+            unswizzle_tile(tile, rows + x * linear_bytes_per_pixel, linear_stride);
+            tile += 64 * bytes_per_pixel;
+        }
+
+        // Convert each band of rows while it's still in cache
+        if (conversion == MortonConversion::RotateDepthStencil) {
+            for (int row = 0; row < 8; ++row)
+                RotateDepthStencil(rows + row * linear_stride, tiled_width, true);
+        }
+    }
+
+    if (tiled_width != width || tiled_height != height)
+        UnswizzleEdgeTexels(width, height, bytes_per_pixel, tiled, linear, linear_stride, conversion);
+}
+
+void MortonSwizzle(u32 width, u32 height, u32 bytes_per_pixel, u8* tiled, const u8* linear,
+                   ptrdiff_t linear_stride, MortonConversion conversion) {
+    SwizzleTileFunc swizzle_tile = GetSwizzleTileFunc(bytes_per_pixel);
+    u32 linear_bytes_per_pixel = bytes_per_pixel;
+    if (conversion == MortonConversion::PadD24) {
+        ASSERT(bytes_per_pixel == 3);
+        swizzle_tile = SwizzleTileD24;
+        linear_bytes_per_pixel = 4;
+    }
+    ASSERT(conversion != MortonConversion::RotateDepthStencil || bytes_per_pixel == 4);
+
+    const u32 tiled_width = width & ~7;
+    const u32 tiled_height = height & ~7;
+
+    for (u32 y = 0; y < tiled_height; y += 8) {
+        const u8* const rows = linear + static_cast<ptrdiff_t>(y) * linear_stride;
+        u8* const tile_row = tiled + y * width * bytes_per_pixel;
+        u8* tile = tile_row;
+        for (u32 x = 0; x < tiled_width; x += 8) {
+            swizzle_tile(tile, rows + x * linear_bytes_per_pixel, linear_stride);
+            tile += 64 * bytes_per_pixel;
+        }
+
+        // The source can't be modified, so texels are converted in their tiled destination
+        if (conversion == MortonConversion::RotateDepthStencil)
+            RotateDepthStencil(tile_row, tiled_width * 8, false);
+    }
+
+    if (tiled_width != width || tiled_height != height)
+        SwizzleEdgeTexels(width, height, bytes_per_pixel, tiled, linear, linear_stride, conversion);
+}
+
+/**
+ * Tile decoders convert the 64 texels of an 8x8 tile to RGBA8, keeping them in Morton order.
+ * The color channels match the results of DebugUtils::LookupTexture.
+ */
+using TileDecoder = void (*)(const u8* source, Math::Vec4<u8>* dest);
+
+#ifdef ARCHITECTURE_x86_64
+/// Expands eight 8-bit channel values in each 16-bit lane to eight RGBA8 texels
+static void StoreTexels(__m128i r, __m128i g, __m128i b, __m128i a, Math::Vec4<u8>* dest) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), _mm_unpackhi_epi16(rg, ba));
+}
+
+static __m128i Expand4To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 4), value);
+}
+
+static __m128i Expand5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+static __m128i Expand6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+#endif // ARCHITECTURE_x86_64
+
+static void DecodeTileRGBA8(const u8* source, Math::Vec4<u8>* dest) {
+#ifdef ARCHITECTURE_x86_64
+    for (unsigned i = 0; i < 64; i += 4) {
+        // Reverse the byte order of each texel: swap the 16-bit halves, then the bytes within
+        __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        texels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(texels, 0xB1), 0xB1);
+        texels = _mm_or_si128(_mm_slli_epi16(texels, 8), _mm_srli_epi16(texels, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), texels);
+    }
+#else
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = Color::DecodeRGBA8(source + i * 4);
+#endif
+}
+
+static void DecodeTileRGB8(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = Color::DecodeRGB8(source + i * 3);
+}
+
+static void DecodeTileRGB5A1(const u8* source, Math::Vec4<u8>* dest) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    for (unsigned i = 0; i < 64; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = Expand5To8(_mm_srli_epi16(pixels, 11));
+        const __m128i g = Expand5To8(_mm_and_si128(_mm_srli_epi16(pixels, 6), mask5));
+        const __m128i b = Expand5To8(_mm_and_si128(_mm_srli_epi16(pixels, 1), mask5));
+        const __m128i a = _mm_srli_epi16(_mm_sub_epi16(_mm_setzero_si128(),
+                                                       _mm_and_si128(pixels, _mm_set1_epi16(1))), 8);
+        StoreTexels(r, g, b, a, dest + i);
+    }
+#else
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = Color::DecodeRGB5A1(source + i * 2);
+#endif
+}
+
+static void DecodeTileRGB565(const u8* source, Math::Vec4<u8>* dest) {
+#ifdef ARCHITECTURE_x86_64
+    for (unsigned i = 0; i < 64; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = Expand5To8(_mm_srli_epi16(pixels, 11));
+        const __m128i g = Expand6To8(_mm_and_si128(_mm_srli_epi16(pixels, 5), _mm_set1_epi16(0x3F)));
+        const __m128i b = Expand5To8(_mm_and_si128(pixels, _mm_set1_epi16(0x1F)));
+        StoreTexels(r, g, b, _mm_set1_epi16(0xFF), dest + i);
+    }
+#else
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = Color::DecodeRGB565(source + i * 2);
+#endif
+}
+
+static void DecodeTileRGBA4(const u8* source, Math::Vec4<u8>* dest) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128i mask4 = _mm_set1_epi16(0xF);
+    for (unsigned i = 0; i < 64; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = Expand4To8(_mm_srli_epi16(pixels, 12));
+        const __m128i g = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixels, 8), mask4));
+        const __m128i b = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixels, 4), mask4));
+        const __m128i a = Expand4To8(_mm_and_si128(pixels, mask4));
+        StoreTexels(r, g, b, a, dest + i);
+    }
+#else
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = Color::DecodeRGBA4(source + i * 2);
+#endif
+}
+
+static void DecodeTileIA8(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = { source[i * 2 + 1], source[i * 2 + 1], source[i * 2 + 1], source[i * 2] };
+}
+
+static void DecodeTileRG8(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = Color::DecodeRG8(source + i * 2);
+}
+
+static void DecodeTileI8(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = { source[i], source[i], source[i], 255 };
+}
+
+static void DecodeTileA8(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = { 0, 0, 0, source[i] };
+}
+
+static void DecodeTileIA4(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i) {
+        const u8 intensity = Color::Convert4To8(source[i] >> 4);
+        dest[i] = { intensity, intensity, intensity, Color::Convert4To8(source[i] & 0xF) };
+    }
+}
+
+static void DecodeTileI4(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i) {
+        const u8 intensity = Color::Convert4To8((source[i / 2] >> (4 * (i % 2))) & 0xF);
+        dest[i] = { intensity, intensity, intensity, 255 };
+    }
+}
+
+static void DecodeTileA4(const u8* source, Math::Vec4<u8>* dest) {
+    for (unsigned i = 0; i < 64; ++i)
+        dest[i] = { 0, 0, 0, Color::Convert4To8((source[i / 2] >> (4 * (i % 2))) & 0xF) };
+}
+
+static TileDecoder GetTileDecoder(Pica::Regs::TextureFormat format) {
+    switch (format) {
+    case Pica::Regs::TextureFormat::RGBA8:  return DecodeTileRGBA8;
+    case Pica::Regs::TextureFormat::RGB8:   return DecodeTileRGB8;
+    case Pica::Regs::TextureFormat::RGB5A1: return DecodeTileRGB5A1;
+    case Pica::Regs::TextureFormat::RGB565: return DecodeTileRGB565;
+    case Pica::Regs::TextureFormat::RGBA4:  return DecodeTileRGBA4;
+    case Pica::Regs::TextureFormat::IA8:    return DecodeTileIA8;
+    case Pica::Regs::TextureFormat::RG8:    return DecodeTileRG8;
+    case Pica::Regs::TextureFormat::I8:     return DecodeTileI8;
+    case Pica::Regs::TextureFormat::A8:     return DecodeTileA8;
+    case Pica::Regs::TextureFormat::IA4:    return DecodeTileIA4;
+    case Pica::Regs::TextureFormat::I4:     return DecodeTileI4;
+    case Pica::Regs::TextureFormat::A4:     return DecodeTileA4;
+    default:                          return nullptr;
+    }
+}
+
+/**
+ * Decodes a 4x4 ETC1 block to the given destination. The block colors are computed once for each
+ * of its two subblocks, rather than once per texel.
+ */
+static void DecodeETC1Block(u64 block, u64 alpha, Math::Vec4<u8>* dest, ptrdiff_t dest_stride) {
+    static const std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
+        {{  2,  8 }}, {{  5, 17 }}, {{  9,  29 }}, {{ 13,  42 }},
+        {{ 18, 60 }}, {{ 24, 80 }}, {{ 33, 106 }}, {{ 47, 183 }}
+    }};
+
+    const bool flip = (block >> 32) & 1;
+    const bool differential_mode = (block >> 33) & 1;
+
+    // Base colors of the two subblocks
+    std::array<Math::Vec3<int>, 2> base;
+    if (differential_mode) {
+        auto SignExtend3 = [](u64 value) { return static_cast<int>((value & 7) ^ 4) - 4; };
+        const int r = (block >> 59) & 0x1F, g = (block >> 51) & 0x1F, b = (block >> 43) & 0x1F;
+        const int r2 = r + SignExtend3(block >> 56);
+        const int g2 = g + SignExtend3(block >> 48);
+        const int b2 = b + SignExtend3(block >> 40);
+        base[0] = { Color::Convert5To8(r), Color::Convert5To8(g), Color::Convert5To8(b) };
+        base[1] = { Color::Convert5To8(static_cast<u8>(r2)), Color::Convert5To8(static_cast<u8>(g2)),
+                    Color::Convert5To8(static_cast<u8>(b2)) };
+    } else {
+        base[0] = { Color::Convert4To8((block >> 60) & 0xF), Color::Convert4To8((block >> 52) & 0xF),
+                    Color::Convert4To8((block >> 44) & 0xF) };
+        base[1] = { Color::Convert4To8((block >> 56) & 0xF), Color::Convert4To8((block >> 48) & 0xF),
+                    Color::Convert4To8((block >> 40) & 0xF) };
+    }
+    const std::array<unsigned, 2> table_index = {{
+        static_cast<unsigned>((block >> 37) & 7), static_cast<unsigned>((block >> 34) & 7)
+    }};
+
+    for (unsigned x = 0; x < 4; ++x) {
+        for (unsigned y = 0; y < 4; ++y) {
+            const unsigned texel = 4 * x + y;
+            const unsigned subblock = ((flip ? y : x) < 2) ? 0 : 1;
+
+            int modifier = etc1_modifier_table[table_index[subblock]][(block >> texel) & 1];
+            if ((block >> (16 + texel)) & 1)
+                modifier = -modifier;
+
+            const Math::Vec3<int>& color = base[subblock];
+            dest[static_cast<ptrdiff_t>(y) * dest_stride + x] = {
+                static_cast<u8>(MathUtil::Clamp(color.r() + modifier, 0, 255)),
+                static_cast<u8>(MathUtil::Clamp(color.g() + modifier, 0, 255)),
+                static_cast<u8>(MathUtil::Clamp(color.b() + modifier, 0, 255)),
+                Color::Convert4To8((alpha >> (4 * texel)) & 0xF)
+            };
+        }
+    }
+}
+
+void DecodeTexture(const u8* source, u32 width, u32 height, Pica::Regs::TextureFormat format,
+                   Math::Vec4<u8>* dest, ptrdiff_t dest_stride) {
+    using Pica::Regs;
+
+    const bool tiled = (width % 8) == 0 && (height % 8) == 0;
+
+    if (tiled && (format == Regs::TextureFormat::ETC1 || format == Regs::TextureFormat::ETC1A4)) {
+        // Each 8x8 tile holds four 4x4 blocks, optionally preceded by 4-bit alpha values
+        const bool has_alpha = (format == Regs::TextureFormat::ETC1A4);
+        for (u32 tile_y = 0; tile_y < height; tile_y += 8) {
+            for (u32 tile_x = 0; tile_x < width; tile_x += 8) {
+                for (unsigned subtile = 0; subtile < 4; ++subtile) {
+                    u64 alpha = ~0ull;
+                    if (has_alpha) {
+                        std::memcpy(&alpha, source, sizeof(u64));
+                        source += sizeof(u64);
+                    }
+                    u64 block;
+                    std::memcpy(&block, source, sizeof(u64));
+                    source += sizeof(u64);
+
+                    const u32 x = tile_x + (subtile & 1) * 4;
+                    const u32 y = tile_y + (subtile >> 1) * 4;
+                    DecodeETC1Block(block, alpha, dest + static_cast<ptrdiff_t>(y) * dest_stride + x,
+                                    dest_stride);
+                }
+            }
+        }
+        return;
+    }
+
+    const TileDecoder decode_tile = GetTileDecoder(format);
+    if (tiled && decode_tile) {
+        // Tiles are decoded in Morton order, then moved to their rows like 32-bit pixels
+        const UnswizzleTileFunc unswizzle_tile = GetUnswizzleTileFunc(sizeof(Math::Vec4<u8>));
+        const ptrdiff_t dest_stride_bytes = dest_stride * static_cast<ptrdiff_t>(sizeof(Math::Vec4<u8>));
+        const u32 tile_size = 64 * Regs::NibblesPerPixel(format) / 2;
+        std::array<Math::Vec4<u8>, 64> tile;
+        for (u32 tile_y = 0; tile_y < height; tile_y += 8) {
+            Math::Vec4<u8>* const rows = dest + static_cast<ptrdiff_t>(tile_y) * dest_stride;
+            for (u32 tile_x = 0; tile_x < width; tile_x += 8) {
+                decode_tile(source, tile.data());
+                source += tile_size;
+
+                unswizzle_tile(reinterpret_cast<const u8*>(tile.data()),
+                               reinterpret_cast<u8*>(rows + tile_x), dest_stride_bytes);
+            }
+        }
+        return;
+    }
+
+    // Unusual sizes and formats go through the generic texel lookup
+    Pica::DebugUtils::TextureInfo info;
+    info.physical_address = 0;
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.stride = Regs::NibblesPerPixel(format) * width / 2;
+    for (u32 y = 0; y < height; ++y)
+        for (u32 x = 0; x < width; ++x)
+            dest[static_cast<ptrdiff_t>(y) * dest_stride + x] = Pica::DebugUtils::LookupTexture(source, x, y, info);
+}
+
+UnswizzleTileFunc GetUnswizzleTileFunc(u32 bytes_per_pixel) {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2 && bytes_per_pixel == 2)
+        return UnswizzleTile2_AVX2;
+    if (caps.avx2 && bytes_per_pixel == 4)
+        return UnswizzleTile4_AVX2;
+    if (caps.sse2 && bytes_per_pixel == 2)
+        return UnswizzleTile2_SSE2;
+    if (caps.sse2 && bytes_per_pixel == 4)
+        return UnswizzleTile4_SSE2;
+#endif // ARCHITECTURE_x86_64
+
+    switch (bytes_per_pixel) {
+    case 1: return UnswizzleTile<1>;
+    case 2: return UnswizzleTile2_Generic;
+    case 3: return UnswizzleTile3_Generic;
+    case 4: return UnswizzleTile4_Generic;
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+SwizzleTileFunc GetSwizzleTileFunc(u32 bytes_per_pixel) {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2 && bytes_per_pixel == 2)
+        return SwizzleTile2_AVX2;
+    if (caps.avx2 && bytes_per_pixel == 4)
+        return SwizzleTile4_AVX2;
+    if (caps.sse2 && bytes_per_pixel == 2)
+        return SwizzleTile2_SSE2;
+    if (caps.sse2 && bytes_per_pixel == 4)
+        return SwizzleTile4_SSE2;
+#endif // ARCHITECTURE_x86_64
+
+    switch (bytes_per_pixel) {
+    case 1: return SwizzleTile<1>;
+    case 2: return SwizzleTile2_Generic;
+    case 3: return SwizzleTile3_Generic;
+    case 4: return SwizzleTile4_Generic;
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+} // namespace VideoCore
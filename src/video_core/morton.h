@@ -0,0 +1,96 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#include "video_core/pica.h"
+
+/**
+ * Bulk conversion between the tiled layout of PICA surfaces and linear rows of pixels.
+ *
+ * Tiled surfaces are made of 8x8 tiles stored in row-major order, the texels of each tile being
+ * laid out in Morton order (see VideoCore::GetMortonOffset). Instead of computing the Morton
+ * offset of every pixel, these routines move whole tiles at once using the fixed structure of a
+ * tile: two horizontally adjacent texels are always stored next to each other, and each group of
+ * two rows is made of contiguous runs of four texels.
+ */
+namespace VideoCore {
+
+/// Texel conversions which can be applied while moving data between the two layouts
+enum class MortonConversion {
+    None,
+
+    /// D24S8: the PICA stores stencil in the most significant byte, OpenGL in the least
+    /// significant one. Texels are rotated by one byte, in the direction of the copy.
+    RotateDepthStencil,
+
+    /// D24: linear pixels are 32 bits wide with the depth value in their upper three bytes, as
+    /// needed by OpenGL's GL_UNSIGNED_INT type. The padding byte is written as zero.
+    PadD24,
+};
+
+/**
+ * Copies a tiled surface to linear rows. Surfaces which are not a whole number of tiles in size
+ * are supported, with the texels of the partial tiles at the offsets given by GetMortonOffset.
+ * @param width Width of the surface in pixels
+ * @param height Height of the surface in pixels
+ * @param bytes_per_pixel Size of the tiled pixels, from 1 to 4 bytes
+ * @param tiled Tiled source data
+ * @param linear Destination address of the first linear row, which receives the pixels of y = 0
+ * @param linear_stride Distance in bytes between two linear rows. Can be negative to flip the
+ *                      surface vertically, like OpenGL expects it.
+ */
+void MortonUnswizzle(u32 width, u32 height, u32 bytes_per_pixel, const u8* tiled, u8* linear,
+                     ptrdiff_t linear_stride, MortonConversion conversion = MortonConversion::None);
+
+/// Copies linear rows to a tiled surface. Parameters are the same as for MortonUnswizzle.
+void MortonSwizzle(u32 width, u32 height, u32 bytes_per_pixel, u8* tiled, const u8* linear,
+                   ptrdiff_t linear_stride, MortonConversion conversion = MortonConversion::None);
+
+/**
+ * Decodes a texture to RGBA8. Decoded colors match the results of DebugUtils::LookupTexture.
+ * @param source Texture data
+ * @param dest Destination address of the texel at s = 0, t = 0
+ * @param dest_stride Distance in texels between two destination rows, which may be negative
+ */
+void DecodeTexture(const u8* source, u32 width, u32 height, Pica::Regs::TextureFormat format,
+                   Math::Vec4<u8>* dest, ptrdiff_t dest_stride);
+
+/// Copies the 64 pixels of one tile to eight linear rows
+using UnswizzleTileFunc = void (*)(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+
+/// Copies eight linear rows of eight pixels to one tile
+using SwizzleTileFunc = void (*)(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+
+void UnswizzleTile2_Generic(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void UnswizzleTile3_Generic(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void UnswizzleTile4_Generic(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile2_Generic(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile3_Generic(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile4_Generic(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+
+#ifdef ARCHITECTURE_x86_64
+void UnswizzleTile2_SSE2(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void UnswizzleTile4_SSE2(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile2_SSE2(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile4_SSE2(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+
+void UnswizzleTile2_AVX2(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void UnswizzleTile4_AVX2(const u8* tile, u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile2_AVX2(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+void SwizzleTile4_AVX2(u8* tile, const u8* linear, ptrdiff_t linear_stride);
+#endif // ARCHITECTURE_x86_64
+
+/// Returns the fastest tile unswizzling routine for the given pixel size supported by the host CPU
+UnswizzleTileFunc GetUnswizzleTileFunc(u32 bytes_per_pixel);
+
+/// Returns the fastest tile swizzling routine for the given pixel size supported by the host CPU
+SwizzleTileFunc GetSwizzleTileFunc(u32 bytes_per_pixel);
+
+} // namespace VideoCore
@@ -0,0 +1,138 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <immintrin.h>
+
+#include "common/x64/target_attributes.h"
+
+#include "video_core/morton.h"
+
+namespace VideoCore {
+
+// Rows 2n and 2n + 1 of a tile are stored as two runs of eight texels, starting at these texel
+// indices and 16 texels apart. Within each run, texels alternate in groups of two between the
+// first and the second row: the first run holds columns 0-3 and the second one columns 4-7.
+static const unsigned row_pair_start[4] = { 0, 8, 32, 40 };
+
+void UnswizzleTile2_SSE2(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned pair = 0; pair < 4; ++pair) {
+        const __m128i* src = reinterpret_cast<const __m128i*>(tile + row_pair_start[pair] * 2);
+
+        // Gather the 32-bit groups of each row: [row0 x0-1, row0 x2-3, row1 x0-1, row1 x2-3]
+        const __m128i left = _mm_shuffle_epi32(_mm_loadu_si128(src), 0xD8);
+        const __m128i right = _mm_shuffle_epi32(_mm_loadu_si128(src + 2), 0xD8);
+
+        u8* row = linear + static_cast<ptrdiff_t>(2 * pair) * linear_stride;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_unpacklo_epi64(left, right));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + linear_stride), _mm_unpackhi_epi64(left, right));
+    }
+}
+
+void UnswizzleTile4_SSE2(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned pair = 0; pair < 4; ++pair) {
+        const __m128i* src = reinterpret_cast<const __m128i*>(tile + row_pair_start[pair] * 4);
+        const __m128i a = _mm_loadu_si128(src + 0); // row0 x0-1, row1 x0-1
+        const __m128i b = _mm_loadu_si128(src + 1); // row0 x2-3, row1 x2-3
+        const __m128i c = _mm_loadu_si128(src + 4); // row0 x4-5, row1 x4-5
+        const __m128i d = _mm_loadu_si128(src + 5); // row0 x6-7, row1 x6-7
+
+        __m128i* row0 = reinterpret_cast<__m128i*>(linear + static_cast<ptrdiff_t>(2 * pair) * linear_stride);
+        __m128i* row1 = reinterpret_cast<__m128i*>(reinterpret_cast<u8*>(row0) + linear_stride);
+        _mm_storeu_si128(row0, _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128(row0 + 1, _mm_unpacklo_epi64(c, d));
+        _mm_storeu_si128(row1, _mm_unpackhi_epi64(a, b));
+        _mm_storeu_si128(row1 + 1, _mm_unpackhi_epi64(c, d));
+    }
+}
+
+void SwizzleTile2_SSE2(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned pair = 0; pair < 4; ++pair) {
+        const u8* row = linear + static_cast<ptrdiff_t>(2 * pair) * linear_stride;
+        const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+        const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + linear_stride));
+
+        __m128i* dst = reinterpret_cast<__m128i*>(tile + row_pair_start[pair] * 2);
+        _mm_storeu_si128(dst, _mm_shuffle_epi32(_mm_unpacklo_epi64(row0, row1), 0xD8));
+        _mm_storeu_si128(dst + 2, _mm_shuffle_epi32(_mm_unpackhi_epi64(row0, row1), 0xD8));
+    }
+}
+
+void SwizzleTile4_SSE2(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned pair = 0; pair < 4; ++pair) {
+        const __m128i* row0 = reinterpret_cast<const __m128i*>(linear + static_cast<ptrdiff_t>(2 * pair) * linear_stride);
+        const __m128i* row1 = reinterpret_cast<const __m128i*>(reinterpret_cast<const u8*>(row0) + linear_stride);
+        const __m128i row0_left = _mm_loadu_si128(row0);
+        const __m128i row0_right = _mm_loadu_si128(row0 + 1);
+        const __m128i row1_left = _mm_loadu_si128(row1);
+        const __m128i row1_right = _mm_loadu_si128(row1 + 1);
+
+        __m128i* dst = reinterpret_cast<__m128i*>(tile + row_pair_start[pair] * 4);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi64(row0_left, row1_left));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi64(row0_left, row1_left));
+        _mm_storeu_si128(dst + 4, _mm_unpacklo_epi64(row0_right, row1_right));
+        _mm_storeu_si128(dst + 5, _mm_unpackhi_epi64(row0_right, row1_right));
+    }
+}
+
+// With 16-bit texels, one 256-bit vector holds the left runs of two consecutive row pairs, so the
+// AVX2 routines process four rows at a time.
+TARGET_AVX2 void UnswizzleTile2_AVX2(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned half = 0; half < 2; ++half) {
+        const __m256i* src = reinterpret_cast<const __m256i*>(tile + half * 64);
+        const __m256i left = _mm256_shuffle_epi32(_mm256_loadu_si256(src), 0xD8);
+        const __m256i right = _mm256_shuffle_epi32(_mm256_loadu_si256(src + 1), 0xD8);
+        const __m256i even_rows = _mm256_unpacklo_epi64(left, right); // rows 0 and 2
+        const __m256i odd_rows = _mm256_unpackhi_epi64(left, right);  // rows 1 and 3
+
+        u8* row = linear + static_cast<ptrdiff_t>(4 * half) * linear_stride;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm256_castsi256_si128(even_rows));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + linear_stride), _mm256_castsi256_si128(odd_rows));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + 2 * linear_stride), _mm256_extracti128_si256(even_rows, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + 3 * linear_stride), _mm256_extracti128_si256(odd_rows, 1));
+    }
+}
+
+TARGET_AVX2 void UnswizzleTile4_AVX2(const u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned pair = 0; pair < 4; ++pair) {
+        const __m256i* src = reinterpret_cast<const __m256i*>(tile + row_pair_start[pair] * 4);
+
+        // Reorder the 64-bit groups from [row0, row1, row0, row1] to [row0, row0, row1, row1]
+        const __m256i left = _mm256_permute4x64_epi64(_mm256_loadu_si256(src), 0xD8);
+        const __m256i right = _mm256_permute4x64_epi64(_mm256_loadu_si256(src + 2), 0xD8);
+
+        u8* row = linear + static_cast<ptrdiff_t>(2 * pair) * linear_stride;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row), _mm256_permute2x128_si256(left, right, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + linear_stride), _mm256_permute2x128_si256(left, right, 0x31));
+    }
+}
+
+TARGET_AVX2 void SwizzleTile2_AVX2(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned half = 0; half < 2; ++half) {
+        const u8* row = linear + static_cast<ptrdiff_t>(4 * half) * linear_stride;
+        const __m256i even_rows = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * linear_stride)), 1);
+        const __m256i odd_rows = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + linear_stride))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 3 * linear_stride)), 1);
+
+        __m256i* dst = reinterpret_cast<__m256i*>(tile + half * 64);
+        _mm256_storeu_si256(dst, _mm256_shuffle_epi32(_mm256_unpacklo_epi64(even_rows, odd_rows), 0xD8));
+        _mm256_storeu_si256(dst + 1, _mm256_shuffle_epi32(_mm256_unpackhi_epi64(even_rows, odd_rows), 0xD8));
+    }
+}
+
+TARGET_AVX2 void SwizzleTile4_AVX2(u8* tile, const u8* linear, ptrdiff_t linear_stride) {
+    for (unsigned pair = 0; pair < 4; ++pair) {
+        const u8* row = linear + static_cast<ptrdiff_t>(2 * pair) * linear_stride;
+        const __m256i row0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+        const __m256i row1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + linear_stride));
+
+        __m256i* dst = reinterpret_cast<__m256i*>(tile + row_pair_start[pair] * 4);
+        _mm256_storeu_si256(dst, _mm256_permute4x64_epi64(_mm256_permute2x128_si256(row0, row1, 0x20), 0xD8));
+        _mm256_storeu_si256(dst + 2, _mm256_permute4x64_epi64(_mm256_permute2x128_si256(row0, row1, 0x31), 0xD8));
+    }
+}
+
+} // namespace VideoCore
@@ -11,6 +11,7 @@
 #include "video_core/pica_state.h"
 #include "video_core/primitive_assembly.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
 
 namespace Pica {
 
@@ -501,6 +502,7 @@ void Init() {
 
 void Shutdown() {
     Shader::ClearCache();
+    VertexLoader::ClearCache();
 }
 
 template <typename T>
@@ -5,14 +5,18 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <memory>
+#include <vector>
 
 #include "common/assert.h"
+#include "common/bit_set.h"
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 
 #include "core/memory.h"
@@ -23,7 +27,10 @@
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/rasterizer.h"
+#include "video_core/rasterizer_interpolation.h"
+#include "video_core/texture_cache.h"
 #include "video_core/utils.h"
+#include "video_core/video_core.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica {
@@ -294,17 +301,40 @@ static int SignedArea (const Math::Vec2<Fix12P4>& vtx1,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+static const InterpolateBlockFunc interpolate_block = GetInterpolateBlockFunc();
+
+/// Decoded textures of the enabled texture units, looked up before any triangles are drawn
+static std::array<std::shared_ptr<const TextureCache::CachedTexture>, 3> bound_textures;
+
+static void BindTextures() {
+    const auto textures = g_state.regs.GetTextures();
+    for (unsigned i = 0; i < 3; ++i) {
+        bound_textures[i] = textures[i].enabled
+                            ? TextureCache::GetTexture(textures[i].config, textures[i].format)
+                            : nullptr;
+    }
+}
+
+/// Triangle which passed culling, along with everything needed to draw any part of it
+struct Triangle {
+    TriangleInterpolants interpolants;
+
+    /// Bounding box in rasterizer coordinates, aligned to pixel boundaries
+    u16 min_x, min_y, max_x, max_y;
+};
+
 /**
- * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * Computes the bounding box, edge functions and interpolation inputs of a triangle.
+ * The "reversed" flag allows for implementing culling via recursion.
+ * @return false if the triangle has been culled
  */
-static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
-                                    const Shader::OutputVertex& v1,
-                                    const Shader::OutputVertex& v2,
-                                    bool reversed = false)
+static bool SetupTriangle(const Shader::OutputVertex& v0,
+                          const Shader::OutputVertex& v1,
+                          const Shader::OutputVertex& v2,
+                          Triangle& triangle,
+                          bool reversed = false)
 {
     const auto& regs = g_state.regs;
-    MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
     static auto FloatToFix = [](float24 flt) {
@@ -322,20 +352,17 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
 
     if (regs.cull_mode == Regs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
-        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
-        }
+        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
+            return SetupTriangle(v0, v2, v1, triangle, true);
     } else {
         if (!reversed && regs.cull_mode == Regs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
+            return SetupTriangle(v0, v2, v1, triangle, true);
         }
 
         // Cull away triangles which are wound clockwise.
         if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
-            return;
+            return false;
     }
 
     // TODO: Proper scissor rect test!
@@ -370,7 +397,68 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
     int bias1 = IsRightSideOrFlatBottomEdge(vtxpos[1].xy(), vtxpos[2].xy(), vtxpos[0].xy()) ? -1 : 0;
     int bias2 = IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
-    auto w_inverse = Math::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
+    // The barycentric coordinate of each vertex is the signed area spanned by the opposite edge
+    // and the pixel position, plus the filling rule bias
+    auto SetupEdge = [](EdgeFunction& edge, const Math::Vec2<Fix12P4>& vtx1,
+                        const Math::Vec2<Fix12P4>& vtx2, int bias) {
+        edge.origin_x = vtx1.x;
+        edge.origin_y = vtx1.y;
+        edge.delta_x = vtx2.x - vtx1.x;
+        edge.delta_y = vtx2.y - vtx1.y;
+        edge.bias = bias;
+    };
+
+    auto& interpolants = triangle.interpolants;
+    SetupEdge(interpolants.edges[0], vtxpos[1].xy(), vtxpos[2].xy(), bias0);
+    SetupEdge(interpolants.edges[1], vtxpos[2].xy(), vtxpos[0].xy(), bias1);
+    SetupEdge(interpolants.edges[2], vtxpos[0].xy(), vtxpos[1].xy(), bias2);
+
+    const Shader::OutputVertex* vertices[3] = { &v0, &v1, &v2 };
+    for (int i = 0; i < 3; ++i) {
+        const auto& vertex = *vertices[i];
+        auto& attributes = interpolants.attributes;
+
+        interpolants.w[i] = vertex.pos.w.ToFloat32();
+        interpolants.z[i] = vertex.screenpos[2].ToFloat32();
+        attributes[TriangleInterpolants::ColorR][i] = vertex.color.r().ToFloat32();
+        attributes[TriangleInterpolants::ColorG][i] = vertex.color.g().ToFloat32();
+        attributes[TriangleInterpolants::ColorB][i] = vertex.color.b().ToFloat32();
+        attributes[TriangleInterpolants::ColorA][i] = vertex.color.a().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord0U][i] = vertex.tc0.u().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord0V][i] = vertex.tc0.v().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord1U][i] = vertex.tc1.u().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord1V][i] = vertex.tc1.v().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord2U][i] = vertex.tc2.u().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord2V][i] = vertex.tc2.v().ToFloat32();
+        attributes[TriangleInterpolants::TexCoord0W][i] = vertex.tc0_w.ToFloat32();
+    }
+
+    interpolants.depth_scale = float24::FromRaw(regs.viewport_depth_range).ToFloat32();
+    interpolants.depth_offset = float24::FromRaw(regs.viewport_depth_near_plane).ToFloat32();
+    interpolants.w_buffering = regs.depthmap_enable == Pica::Regs::DepthBuffering::WBuffering;
+
+    triangle.min_x = min_x;
+    triangle.min_y = min_y;
+    triangle.max_x = max_x;
+    triangle.max_y = max_y;
+    return true;
+}
+
+/**
+ * Draws the pixels of a triangle which lie within the given rectangle, specified in rasterizer
+ * coordinates and aligned to pixel boundaries.
+ */
+static void DrawTriangle(const Triangle& triangle, unsigned rect_min_x, unsigned rect_min_y,
+                         unsigned rect_max_x, unsigned rect_max_y)
+{
+    const auto& regs = g_state.regs;
+
+    const u16 min_x = static_cast<u16>(std::max<unsigned>(triangle.min_x, rect_min_x));
+    const u16 min_y = static_cast<u16>(std::max<unsigned>(triangle.min_y, rect_min_y));
+    const u16 max_x = static_cast<u16>(std::min<unsigned>(triangle.max_x, rect_max_x));
+    const u16 max_y = static_cast<u16>(std::min<unsigned>(triangle.max_y, rect_max_y));
+    if (min_x >= max_x || min_y >= max_y)
+        return;
 
     auto textures = regs.GetTextures();
     auto tev_stages = regs.GetTevStages();
@@ -378,81 +466,52 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
     bool stencil_action_enable = g_state.regs.output_merger.stencil_test.enable && g_state.regs.framebuffer.depth_format == Regs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.output_merger.stencil_test;
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
-
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
-
-            auto baricentric_coordinates = Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                                                float24::FromFloat32(static_cast<float>(w1)),
-                                                float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse = float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w = (v0.screenpos[2].ToFloat32() * w0 +
-                                           v1.screenpos[2].ToFloat32() * w1 +
-                                           v2.screenpos[2].ToFloat32() * w2) / wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.viewport_depth_range).ToFloat32();
-            float depth_offset = float24::FromRaw(regs.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.depthmap_enable == Pica::Regs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
-            }
-
-            // Clamp the result
-            depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
+    // Pixels are processed in blocks of BLOCK_SIZE x BLOCK_SIZE. Coverage, depth and attributes
+    // of each block are computed up front, skipping blocks which lie entirely outside the triangle.
+    const unsigned width = (max_x - min_x) >> 4;
+    const unsigned height = (max_y - min_y) >> 4;
+    const unsigned num_blocks_x = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const unsigned num_blocks = num_blocks_x * ((height + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    BlockInterpolants interpolants;
+
+    for (unsigned block = 0; block < num_blocks; ++block) {
+        // Start at the center of the topleft pixel of the block
+        const unsigned block_column = (block % num_blocks_x) * BLOCK_SIZE;
+        const unsigned block_row = (block / num_blocks_x) * BLOCK_SIZE;
+        const int block_x = min_x + 8 + block_column * 16;
+        const int block_y = min_y + 8 + block_row * 16;
+        const unsigned block_width = std::min(width - block_column, BLOCK_SIZE);
+        const unsigned block_height = std::min(height - block_row, BLOCK_SIZE);
+
+        if (!BlockIntersectsTriangle(triangle.interpolants, block_x, block_y, block_width, block_height))
+            continue;
+
+        interpolate_block(triangle.interpolants, block_x, block_y, block_width, block_height, interpolants);
+
+        for (int index : BitSet64(interpolants.coverage)) {
+            const u16 x = static_cast<u16>(block_x + (index % BLOCK_SIZE) * 16);
+            const u16 y = static_cast<u16>(block_y + (index / BLOCK_SIZE) * 16);
+
+            auto GetInterpolatedAttribute = [&](TriangleInterpolants::Attribute attribute) {
+                return float24::FromFloat32(interpolants.attributes[attribute][index]);
             };
 
+            const float depth = interpolants.depth[index];
+
             Math::Vec4<u8> primary_color{
-                (u8)(GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() * 255)
+                (u8)(GetInterpolatedAttribute(TriangleInterpolants::ColorR).ToFloat32() * 255),
+                (u8)(GetInterpolatedAttribute(TriangleInterpolants::ColorG).ToFloat32() * 255),
+                (u8)(GetInterpolatedAttribute(TriangleInterpolants::ColorB).ToFloat32() * 255),
+                (u8)(GetInterpolatedAttribute(TriangleInterpolants::ColorA).ToFloat32() * 255)
             };
 
             Math::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+            uv[0].u() = GetInterpolatedAttribute(TriangleInterpolants::TexCoord0U);
+            uv[0].v() = GetInterpolatedAttribute(TriangleInterpolants::TexCoord0V);
+            uv[1].u() = GetInterpolatedAttribute(TriangleInterpolants::TexCoord1U);
+            uv[1].v() = GetInterpolatedAttribute(TriangleInterpolants::TexCoord1V);
+            uv[2].u() = GetInterpolatedAttribute(TriangleInterpolants::TexCoord2U);
+            uv[2].v() = GetInterpolatedAttribute(TriangleInterpolants::TexCoord2V);
 
             Math::Vec4<u8> texture_color[3]{};
             for (int i = 0; i < 3; ++i) {
@@ -472,7 +531,7 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
                     case Regs::TextureConfig::Texture2D:
                         break;
                     case Regs::TextureConfig::Projection2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                        auto tc0_w = GetInterpolatedAttribute(TriangleInterpolants::TexCoord0W);
                         u /= tc0_w;
                         v /= tc0_w;
                         break;
@@ -528,13 +587,11 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
                     s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
                     t = texture.config.height - 1 - GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-                    u8* texture_data = Memory::GetPhysicalPointer(texture.config.GetPhysicalAddress());
-                    auto info = DebugUtils::TextureInfo::FromPicaRegister(texture.config, texture.format);
-
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = DebugUtils::LookupTexture(texture_data, s, t, info);
+                    if (bound_textures[i])
+                        texture_color[i] = bound_textures[i]->GetTexel(s, t);
 #if PICA_DUMP_TEXTURES
-                    DebugUtils::DumpTexture(texture.config, texture_data);
+                    DebugUtils::DumpTexture(texture.config, Memory::GetPhysicalPointer(texture.config.GetPhysicalAddress()));
 #endif
                 }
             }
@@ -1204,10 +1261,96 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
     }
 }
 
+/// Size of the screen tiles triangles are binned into, in pixels
+static const unsigned TILE_SHIFT = 5;
+static const unsigned TILE_SIZE = 1 << TILE_SHIFT;
+/// Number of tiles per row and column needed to cover the whole rasterizer coordinate range
+static const unsigned NUM_TILES_PER_ROW = 0x10000 / (TILE_SIZE * 16);
+
+static bool binning_enabled = false;
+
+/// Triangles queued since the last flush, in submission order
+static std::vector<Triangle> binned_triangles;
+/// Indices into binned_triangles of the triangles touching each tile, in submission order
+static std::vector<std::vector<u32>> tile_bins;
+/// Tiles with a non-empty bin
+static std::vector<u32> active_tiles;
+
+static void BinTriangle(const Triangle& triangle) {
+    if (triangle.max_x <= triangle.min_x || triangle.max_y <= triangle.min_y)
+        return;
+
+    u32 index = static_cast<u32>(binned_triangles.size());
+    binned_triangles.push_back(triangle);
+
+    // Rasterizer coordinates have 4 fractional bits
+    const unsigned tile_shift = 4 + TILE_SHIFT;
+    for (unsigned tile_y = triangle.min_y >> tile_shift; tile_y <= (triangle.max_y - 1u) >> tile_shift; ++tile_y) {
+        for (unsigned tile_x = triangle.min_x >> tile_shift; tile_x <= (triangle.max_x - 1u) >> tile_shift; ++tile_x) {
+            u32 tile = tile_y * NUM_TILES_PER_ROW + tile_x;
+            if (tile_bins[tile].empty())
+                active_tiles.push_back(tile);
+            tile_bins[tile].push_back(index);
+        }
+    }
+}
+
 void ProcessTriangle(const Shader::OutputVertex& v0,
                      const Shader::OutputVertex& v1,
                      const Shader::OutputVertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+    Triangle triangle;
+
+    if (binning_enabled) {
+        if (SetupTriangle(v0, v1, v2, triangle))
+            BinTriangle(triangle);
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+    if (SetupTriangle(v0, v1, v2, triangle)) {
+        BindTextures();
+        DrawTriangle(triangle, 0, 0, 0x10000, 0x10000);
+    }
+}
+
+void SetTriangleBinning(bool enable) {
+    if (enable == binning_enabled)
+        return;
+
+    if (enable) {
+        tile_bins.resize(NUM_TILES_PER_ROW * NUM_TILES_PER_ROW);
+    } else {
+        FlushTriangles();
+        tile_bins.clear();
+        tile_bins.shrink_to_fit();
+    }
+    binning_enabled = enable;
+}
+
+void FlushTriangles() {
+    if (binned_triangles.empty())
+        return;
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+
+    // Textures are decoded upfront, since the worker threads only sample them
+    BindTextures();
+
+    // Every pixel belongs to exactly one tile, and each tile draws its triangles in submission
+    // order, so the result is the same as drawing the triangles one after another.
+    VideoCore::GetThreadPool().ParallelFor(active_tiles.size(), [](size_t i) {
+        u32 tile = active_tiles[i];
+        unsigned min_x = (tile % NUM_TILES_PER_ROW) * TILE_SIZE * 16;
+        unsigned min_y = (tile / NUM_TILES_PER_ROW) * TILE_SIZE * 16;
+
+        for (u32 index : tile_bins[tile])
+            DrawTriangle(binned_triangles[index], min_x, min_y, min_x + TILE_SIZE * 16, min_y + TILE_SIZE * 16);
+    });
+
+    for (u32 tile : active_tiles)
+        tile_bins[tile].clear();
+    active_tiles.clear();
+    binned_triangles.clear();
 }
 
 } // namespace Rasterizer
@@ -12,10 +12,23 @@ namespace Shader {
 
 namespace Rasterizer {
 
+/**
+ * Draws the given triangle. While triangle binning is enabled, the triangle is only set up and
+ * queued into the screen tiles it touches, and gets drawn by the next FlushTriangles().
+ */
 void ProcessTriangle(const Shader::OutputVertex& v0,
                      const Shader::OutputVertex& v1,
                      const Shader::OutputVertex& v2);
 
+/**
+ * Enables or disables triangle binning. Binned triangles are drawn tile by tile on a pool of
+ * worker threads. Any queued triangles are drawn when binning gets disabled.
+ */
+void SetTriangleBinning(bool enable);
+
+/// Draws all triangles queued since the last flush
+void FlushTriangles();
+
 } // namespace Rasterizer
 
 } // namespace Pica
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "common/common_types.h"
 
 #include "core/hw/gpu.h"
@@ -27,6 +29,9 @@ public:
                              const Pica::Shader::OutputVertex& v1,
                              const Pica::Shader::OutputVertex& v2) = 0;
 
+    /// Queues the given number of triangles, each formed by three consecutive vertices
+    virtual void AddTriangles(const Pica::Shader::OutputVertex* vertices, size_t num_triangles) = 0;
+
     /// Draw the current batch of triangles
     virtual void DrawTriangles() = 0;
 
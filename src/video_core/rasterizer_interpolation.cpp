@@ -0,0 +1,124 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "common/math_util.h"
+#include "common/vector_math.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+#include "video_core/pica_types.h"
+#include "video_core/rasterizer_interpolation.h"
+
+namespace Pica {
+
+namespace Rasterizer {
+
+void InterpolateBlock_Generic(const TriangleInterpolants& triangle, int x, int y,
+                              unsigned width, unsigned height, BlockInterpolants& out) {
+    auto ToFloat24Vec = [](const float (&values)[3]) {
+        return Math::MakeVec(float24::FromFloat32(values[0]),
+                             float24::FromFloat32(values[1]),
+                             float24::FromFloat32(values[2]));
+    };
+    const auto w_vec = ToFloat24Vec(triangle.w);
+
+    out.coverage = 0;
+
+    for (unsigned row = 0; row < height; ++row) {
+        for (unsigned column = 0; column < width; ++column) {
+            const int pixel_x = x + static_cast<int>(column) * 16;
+            const int pixel_y = y + static_cast<int>(row) * 16;
+
+            int w0 = triangle.edges[0].Evaluate(pixel_x, pixel_y);
+            int w1 = triangle.edges[1].Evaluate(pixel_x, pixel_y);
+            int w2 = triangle.edges[2].Evaluate(pixel_x, pixel_y);
+            int wsum = w0 + w1 + w2;
+
+            // If current pixel is not covered by the current primitive
+            if (w0 < 0 || w1 < 0 || w2 < 0)
+                continue;
+
+            const unsigned index = row * BLOCK_SIZE + column;
+            out.coverage |= u64(1) << index;
+
+            auto baricentric_coordinates = Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                                                float24::FromFloat32(static_cast<float>(w1)),
+                                                float24::FromFloat32(static_cast<float>(w2)));
+            float24 interpolated_w_inverse = float24::FromFloat32(1.0f) / Math::Dot(w_vec, baricentric_coordinates);
+
+            // interpolated_z = z / w
+            float interpolated_z_over_w = (triangle.z[0] * w0 +
+                                           triangle.z[1] * w1 +
+                                           triangle.z[2] * w2) / wsum;
+
+            // Not fully accurate. About 3 bits in precision are missing.
+            // Z-Buffer (z / w * scale + offset)
+            float depth = interpolated_z_over_w * triangle.depth_scale + triangle.depth_offset;
+
+            // Potentially switch to W-Buffer
+            if (triangle.w_buffering) {
+                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+                depth *= interpolated_w_inverse.ToFloat32() * wsum;
+            }
+
+            // Clamp the result
+            out.depth[index] = MathUtil::Clamp(depth, 0.0f, 1.0f);
+
+            // Perspective correct attribute interpolation:
+            // Attribute values cannot be calculated by simple linear interpolation since
+            // they are not linear in screen space. For example, when interpolating a
+            // texture coordinate across two vertices, something simple like
+            //     u = (u0*w0 + u1*w1)/(w0+w1)
+            // will not work. However, the attribute value divided by the
+            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+            // in screenspace. Hence, we can linearly interpolate these two independently and
+            // calculate the interpolated attribute by dividing the results.
+            // I.e.
+            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+            //     u = u_over_w / one_over_w
+            //
+            // The generalization to three vertices is straightforward in baricentric coordinates.
+            for (unsigned attribute = 0; attribute < TriangleInterpolants::NumAttributes; ++attribute) {
+                auto attr_over_w = ToFloat24Vec(triangle.attributes[attribute]);
+                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
+                out.attributes[attribute][index] = (interpolated_attr_over_w * interpolated_w_inverse).ToFloat32();
+            }
+        }
+    }
+}
+
+InterpolateBlockFunc GetInterpolateBlockFunc() {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2)
+        return InterpolateBlock_AVX2;
+    if (caps.sse2)
+        return InterpolateBlock_SSE2;
+#endif // ARCHITECTURE_x86_64
+    return InterpolateBlock_Generic;
+}
+
+bool BlockIntersectsTriangle(const TriangleInterpolants& triangle, int x, int y,
+                             unsigned width, unsigned height) {
+    const int last_x = x + static_cast<int>(width - 1) * 16;
+    const int last_y = y + static_cast<int>(height - 1) * 16;
+
+    // Edge functions are linear, so their maximum over the block is reached at one of its corners
+    for (const auto& edge : triangle.edges) {
+        if (edge.Evaluate(x, y) < 0 && edge.Evaluate(last_x, y) < 0 &&
+            edge.Evaluate(x, last_y) < 0 && edge.Evaluate(last_x, last_y) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace Rasterizer
+
+} // namespace Pica
@@ -0,0 +1,96 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+namespace Pica {
+
+namespace Rasterizer {
+
+/// The software rasterizer processes pixels in square blocks of this many pixels per side
+constexpr unsigned BLOCK_SIZE = 8;
+
+/// Edge function of one triangle edge, including the filling rule bias
+struct EdgeFunction {
+    int origin_x, origin_y; ///< First vertex of the edge, in 12.4 fixed point
+    int delta_x, delta_y;   ///< Second vertex minus first vertex
+    int bias;
+
+    /// Evaluates the edge function at the given position in 12.4 fixed point
+    int Evaluate(int x, int y) const {
+        return bias + (delta_x * (y - origin_y) - delta_y * (x - origin_x));
+    }
+};
+
+/// Per-triangle inputs of the block interpolation routines
+struct TriangleInterpolants {
+    enum Attribute {
+        ColorR, ColorG, ColorB, ColorA,
+        TexCoord0U, TexCoord0V,
+        TexCoord1U, TexCoord1V,
+        TexCoord2U, TexCoord2V,
+        TexCoord0W,
+
+        NumAttributes
+    };
+
+    /// Edge functions opposite to vertex 0, 1 and 2, giving the unnormalized barycentric coordinates
+    EdgeFunction edges[3];
+
+    float w[3]; ///< Clip space w of each vertex
+    float z[3]; ///< Screen space z of each vertex
+    float attributes[NumAttributes][3];
+
+    float depth_scale;
+    float depth_offset;
+    bool w_buffering;
+};
+
+/// Interpolated values of the pixels of one block, indexed by row * BLOCK_SIZE + column
+struct BlockInterpolants {
+    /// Bit (row * BLOCK_SIZE + column) is set for each pixel covered by the triangle. Values of
+    /// pixels which are not covered are undefined.
+    u64 coverage;
+
+    float depth[BLOCK_SIZE * BLOCK_SIZE];
+    float attributes[TriangleInterpolants::NumAttributes][BLOCK_SIZE * BLOCK_SIZE];
+};
+
+/**
+ * Computes coverage, clamped depth and perspective correct attributes of a block of pixels.
+ * All implementations produce bit-identical results to the float24 arithmetic of the scalar one.
+ * @param x X coordinate of the center of the top left pixel, in 12.4 fixed point
+ * @param y Y coordinate of the center of the top left pixel, in 12.4 fixed point
+ * @param width Number of pixel columns to process, at most BLOCK_SIZE
+ * @param height Number of pixel rows to process, at most BLOCK_SIZE
+ */
+using InterpolateBlockFunc = void (*)(const TriangleInterpolants& triangle, int x, int y,
+                                      unsigned width, unsigned height, BlockInterpolants& out);
+
+void InterpolateBlock_Generic(const TriangleInterpolants& triangle, int x, int y,
+                              unsigned width, unsigned height, BlockInterpolants& out);
+
+#ifdef ARCHITECTURE_x86_64
+void InterpolateBlock_SSE2(const TriangleInterpolants& triangle, int x, int y,
+                           unsigned width, unsigned height, BlockInterpolants& out);
+
+void InterpolateBlock_AVX2(const TriangleInterpolants& triangle, int x, int y,
+                           unsigned width, unsigned height, BlockInterpolants& out);
+#endif // ARCHITECTURE_x86_64
+
+/// Returns the fastest block interpolation routine supported by the host CPU
+InterpolateBlockFunc GetInterpolateBlockFunc();
+
+/**
+ * Returns false if no pixel of the given block can be covered by the triangle. Parameters are
+ * the same as for the block interpolation routines.
+ */
+bool BlockIntersectsTriangle(const TriangleInterpolants& triangle, int x, int y,
+                             unsigned width, unsigned height);
+
+} // namespace Rasterizer
+
+} // namespace Pica
@@ -0,0 +1,169 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <immintrin.h>
+
+#include "common/x64/target_attributes.h"
+
+#include "video_core/rasterizer_interpolation.h"
+
+namespace Pica {
+
+namespace Rasterizer {
+
+/// Multiplication following float24 semantics: zero times anything but NaN is +0, even for inf
+static inline __m128 Mul24(__m128 a, __m128 b) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 a_zero = _mm_and_ps(_mm_cmpeq_ps(a, zero), _mm_cmpord_ps(b, b));
+    const __m128 b_zero = _mm_and_ps(_mm_cmpeq_ps(b, zero), _mm_cmpord_ps(a, a));
+    return _mm_andnot_ps(_mm_or_ps(a_zero, b_zero), _mm_mul_ps(a, b));
+}
+
+/// Dot product of per-vertex values with the barycentric coordinates, in float24 semantics
+static inline __m128 Dot24(const float (&values)[3], __m128 b0, __m128 b1, __m128 b2) {
+    return _mm_add_ps(_mm_add_ps(Mul24(_mm_set1_ps(values[0]), b0),
+                                 Mul24(_mm_set1_ps(values[1]), b1)),
+                      Mul24(_mm_set1_ps(values[2]), b2));
+}
+
+void InterpolateBlock_SSE2(const TriangleInterpolants& triangle, int x, int y,
+                           unsigned width, unsigned height, BlockInterpolants& out) {
+    // Edge function offsets of the four pixels of a row chunk relative to the first one
+    auto LaneSteps = [](const EdgeFunction& edge) {
+        const int step = -edge.delta_y * 16;
+        return _mm_setr_epi32(0, step, step * 2, step * 3);
+    };
+    const __m128i lane_step0 = LaneSteps(triangle.edges[0]);
+    const __m128i lane_step1 = LaneSteps(triangle.edges[1]);
+    const __m128i lane_step2 = LaneSteps(triangle.edges[2]);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 depth_scale = _mm_set1_ps(triangle.depth_scale);
+    const __m128 depth_offset = _mm_set1_ps(triangle.depth_offset);
+
+    out.coverage = 0;
+
+    for (unsigned row = 0; row < height; ++row) {
+        const int pixel_y = y + static_cast<int>(row) * 16;
+
+        for (unsigned column = 0; column < width; column += 4) {
+            const int pixel_x = x + static_cast<int>(column) * 16;
+
+            const __m128i w0 = _mm_add_epi32(_mm_set1_epi32(triangle.edges[0].Evaluate(pixel_x, pixel_y)), lane_step0);
+            const __m128i w1 = _mm_add_epi32(_mm_set1_epi32(triangle.edges[1].Evaluate(pixel_x, pixel_y)), lane_step1);
+            const __m128i w2 = _mm_add_epi32(_mm_set1_epi32(triangle.edges[2].Evaluate(pixel_x, pixel_y)), lane_step2);
+
+            // A pixel is covered if none of its barycentric coordinates has the sign bit set
+            const unsigned outside = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_or_si128(w0, w1), w2)));
+            const unsigned valid_lanes = (1u << std::min(width - column, 4u)) - 1;
+            const unsigned covered = ~outside & valid_lanes;
+            if (covered == 0)
+                continue;
+
+            const unsigned index = row * BLOCK_SIZE + column;
+            out.coverage |= u64(covered) << index;
+
+            const __m128 b0 = _mm_cvtepi32_ps(w0);
+            const __m128 b1 = _mm_cvtepi32_ps(w1);
+            const __m128 b2 = _mm_cvtepi32_ps(w2);
+            const __m128 wsum = _mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(w0, w1), w2));
+
+            const __m128 w_inverse = _mm_div_ps(one, Dot24(triangle.w, b0, b1, b2));
+
+            const __m128 z_over_w = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.z[0]), b0),
+                                                                     _mm_mul_ps(_mm_set1_ps(triangle.z[1]), b1)),
+                                                          _mm_mul_ps(_mm_set1_ps(triangle.z[2]), b2)),
+                                               wsum);
+            __m128 depth = _mm_add_ps(_mm_mul_ps(z_over_w, depth_scale), depth_offset);
+            if (triangle.w_buffering)
+                depth = _mm_mul_ps(depth, _mm_mul_ps(w_inverse, wsum));
+
+            // Same operand order as MathUtil::Clamp, which maps NaN to the upper bound
+            _mm_storeu_ps(&out.depth[index], _mm_max_ps(_mm_min_ps(depth, one), zero));
+
+            for (unsigned attribute = 0; attribute < TriangleInterpolants::NumAttributes; ++attribute) {
+                const __m128 value = Mul24(Dot24(triangle.attributes[attribute], b0, b1, b2), w_inverse);
+                _mm_storeu_ps(&out.attributes[attribute][index], value);
+            }
+        }
+    }
+}
+
+TARGET_AVX2 static inline __m256 Mul24(__m256 a, __m256 b) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 a_zero = _mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_EQ_OQ), _mm256_cmp_ps(b, b, _CMP_ORD_Q));
+    const __m256 b_zero = _mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_EQ_OQ), _mm256_cmp_ps(a, a, _CMP_ORD_Q));
+    return _mm256_andnot_ps(_mm256_or_ps(a_zero, b_zero), _mm256_mul_ps(a, b));
+}
+
+TARGET_AVX2 static inline __m256 Dot24(const float (&values)[3], __m256 b0, __m256 b1, __m256 b2) {
+    return _mm256_add_ps(_mm256_add_ps(Mul24(_mm256_set1_ps(values[0]), b0),
+                                       Mul24(_mm256_set1_ps(values[1]), b1)),
+                         Mul24(_mm256_set1_ps(values[2]), b2));
+}
+
+TARGET_AVX2
+void InterpolateBlock_AVX2(const TriangleInterpolants& triangle, int x, int y,
+                           unsigned width, unsigned height, BlockInterpolants& out) {
+    static_assert(BLOCK_SIZE == 8, "The AVX2 routine processes one block row at a time");
+
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i lane_step0 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(-triangle.edges[0].delta_y * 16));
+    const __m256i lane_step1 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(-triangle.edges[1].delta_y * 16));
+    const __m256i lane_step2 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(-triangle.edges[2].delta_y * 16));
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 depth_scale = _mm256_set1_ps(triangle.depth_scale);
+    const __m256 depth_offset = _mm256_set1_ps(triangle.depth_offset);
+    const unsigned valid_lanes = (1u << width) - 1;
+
+    out.coverage = 0;
+
+    for (unsigned row = 0; row < height; ++row) {
+        const int pixel_y = y + static_cast<int>(row) * 16;
+
+        const __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(triangle.edges[0].Evaluate(x, pixel_y)), lane_step0);
+        const __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(triangle.edges[1].Evaluate(x, pixel_y)), lane_step1);
+        const __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(triangle.edges[2].Evaluate(x, pixel_y)), lane_step2);
+
+        // A pixel is covered if none of its barycentric coordinates has the sign bit set
+        const unsigned outside = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_or_si256(w0, w1), w2)));
+        const unsigned covered = ~outside & valid_lanes;
+        if (covered == 0)
+            continue;
+
+        const unsigned index = row * BLOCK_SIZE;
+        out.coverage |= u64(covered) << index;
+
+        const __m256 b0 = _mm256_cvtepi32_ps(w0);
+        const __m256 b1 = _mm256_cvtepi32_ps(w1);
+        const __m256 b2 = _mm256_cvtepi32_ps(w2);
+        const __m256 wsum = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_add_epi32(w0, w1), w2));
+
+        const __m256 w_inverse = _mm256_div_ps(one, Dot24(triangle.w, b0, b1, b2));
+
+        const __m256 z_over_w = _mm256_div_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.z[0]), b0),
+                                                                          _mm256_mul_ps(_mm256_set1_ps(triangle.z[1]), b1)),
+                                                            _mm256_mul_ps(_mm256_set1_ps(triangle.z[2]), b2)),
+                                              wsum);
+        __m256 depth = _mm256_add_ps(_mm256_mul_ps(z_over_w, depth_scale), depth_offset);
+        if (triangle.w_buffering)
+            depth = _mm256_mul_ps(depth, _mm256_mul_ps(w_inverse, wsum));
+
+        // Same operand order as MathUtil::Clamp, which maps NaN to the upper bound
+        _mm256_storeu_ps(&out.depth[index], _mm256_max_ps(_mm256_min_ps(depth, one), zero));
+
+        for (unsigned attribute = 0; attribute < TriangleInterpolants::NumAttributes; ++attribute) {
+            const __m256 value = Mul24(Dot24(triangle.attributes[attribute], b0, b1, b2), w_inverse);
+            _mm256_storeu_ps(&out.attributes[attribute][index], value);
+        }
+    }
+}
+
+} // namespace Rasterizer
+
+} // namespace Pica
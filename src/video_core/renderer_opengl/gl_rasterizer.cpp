@@ -16,6 +16,7 @@
 #include "common/vector_math.h"
 
 #include "core/hw/gpu.h"
+#include "core/memory.h"
 
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -163,6 +164,15 @@ void RasterizerOpenGL::AddTriangle(const Pica::Shader::OutputVertex& v0,
     vertex_batch.emplace_back(v2, AreQuaternionsOpposite(v0.quat, v2.quat));
 }
 
+void RasterizerOpenGL::AddTriangles(const Pica::Shader::OutputVertex* vertices, size_t num_triangles) {
+    vertex_batch.reserve(vertex_batch.size() + num_triangles * 3);
+    for (size_t i = 0; i < num_triangles; ++i, vertices += 3) {
+        vertex_batch.emplace_back(vertices[0], false);
+        vertex_batch.emplace_back(vertices[1], AreQuaternionsOpposite(vertices[0].quat, vertices[1].quat));
+        vertex_batch.emplace_back(vertices[2], AreQuaternionsOpposite(vertices[0].quat, vertices[2].quat));
+    }
+}
+
 void RasterizerOpenGL::DrawTriangles() {
     if (vertex_batch.empty())
         return;
@@ -251,10 +261,12 @@ void RasterizerOpenGL::DrawTriangles() {
     // TODO: Restrict invalidation area to the viewport
     if (color_surface != nullptr) {
         color_surface->dirty = true;
+        Memory::RasterizerMarkRegionDirty(color_surface->addr, color_surface->size);
         res_cache.FlushRegion(color_surface->addr, color_surface->size, color_surface, true);
     }
     if (depth_surface != nullptr) {
         depth_surface->dirty = true;
+        Memory::RasterizerMarkRegionDirty(depth_surface->addr, depth_surface->size);
         res_cache.FlushRegion(depth_surface->addr, depth_surface->size, depth_surface, true);
     }
 
@@ -720,6 +732,7 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
 
     u32 dst_size = dst_params.width * dst_params.height * CachedSurface::GetFormatBpp(dst_params.pixel_format) / 8;
     dst_surface->dirty = true;
+    Memory::RasterizerMarkRegionDirty(config.GetPhysicalOutputAddress(), dst_size);
     res_cache.FlushRegion(config.GetPhysicalOutputAddress(), dst_size, dst_surface, true);
     return true;
 }
@@ -868,6 +881,7 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
     cur_state.Apply();
 
     dst_surface->dirty = true;
+    Memory::RasterizerMarkRegionDirty(dst_surface->addr, dst_surface->size);
     res_cache.FlushRegion(dst_surface->addr, dst_surface->size, dst_surface, true);
     return true;
 }
@@ -232,6 +232,7 @@ public:
     void AddTriangle(const Pica::Shader::OutputVertex& v0,
                      const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
+    void AddTriangles(const Pica::Shader::OutputVertex* vertices, size_t num_triangles) override;
     void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override;
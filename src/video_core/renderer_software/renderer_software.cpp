@@ -0,0 +1,252 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include "common/color.h"
+#include "common/emu_window.h"
+#include "common/logging/log.h"
+#include "common/profiler_reporting.h"
+#include "common/synchronized_wrapper.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/recorder.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_software/renderer_software.h"
+#include "video_core/video_core.h"
+
+// Channel masks of XRGB8888 pixels, mirroring the color masks used by RendererOpenGL for stereo
+static const u32 MASK_LEFT = 0x00FF0000;  // Red
+static const u32 MASK_RIGHT = 0x0000FFFF; // Green and blue
+static const u32 MASK_ALL = MASK_LEFT | MASK_RIGHT;
+
+static u32 PackXRGB(u8 r, u8 g, u8 b) {
+    return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+/**
+ * Decodes a framebuffer into an image in display orientation. Framebuffer rows are the columns of
+ * the displayed image, from left to right, and each of them is displayed from bottom to top.
+ */
+template <const Math::Vec4<u8> (*decode)(const u8*)>
+static void DecodeRotated(const u8* data, u32 stride, u32 bytes_per_pixel, u32 fb_width,
+                          u32 fb_height, u32* pixels) {
+    const u32 image_width = fb_height;
+    for (u32 row = 0; row < fb_height; ++row) {
+        const u8* source = data + row * stride;
+        u32* dest = pixels + (fb_width - 1) * image_width + row;
+        for (u32 column = 0; column < fb_width; ++column) {
+            const Math::Vec4<u8> color = decode(source);
+            *dest = PackXRGB(color.r(), color.g(), color.b());
+            source += bytes_per_pixel;
+            dest -= image_width;
+        }
+    }
+}
+
+/// RendererSoftware constructor
+RendererSoftware::RendererSoftware() {}
+
+/// RendererSoftware destructor
+RendererSoftware::~RendererSoftware() {}
+
+/// Swap buffers (render frame)
+void RendererSoftware::SwapBuffers() {
+    for (int i : {0, 1, 2}) {
+        const auto& framebuffer = GPU::g_regs.framebuffer_config[i != 2 ? 0 : 1];
+
+        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
+        u32 color_fill_index =
+            (i != 2) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
+        LoadScreen(framebuffer, color_fill_index, screen_images[i], i == 1);
+    }
+
+    DrawScreens();
+
+    auto& profiler = Common::Profiling::GetProfilingManager();
+    profiler.FinishFrame();
+    {
+        auto aggregator = Common::Profiling::GetTimingResultsAggregator();
+        aggregator->AddFrame(profiler.GetPreviousFrameResults());
+    }
+
+    render_window->PollEvents();
+    render_window->PresentFrame(frame.data(), frame_width, frame_height);
+
+    profiler.BeginFrame();
+
+    RefreshRasterizerSetting();
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+/**
+ * Loads the framebuffer scanned out by an LCD, or its color fill if enabled, into a screen image.
+ */
+void RendererSoftware::LoadScreen(const GPU::Regs::FramebufferConfig& framebuffer,
+                                  u32 color_fill_index, ScreenImage& image, bool right) {
+    LCD::Regs::ColorFill color_fill = {0};
+    LCD::Read(color_fill.raw, HW::VADDR_LCD + 4 * color_fill_index);
+
+    if (color_fill.is_enabled) {
+        image.width = 1;
+        image.height = 1;
+        image.pixels.assign(1, PackXRGB(color_fill.color_r, color_fill.color_g, color_fill.color_b));
+        return;
+    }
+
+    PAddr framebuffer_addr = 0;
+    if (right) {
+        framebuffer_addr = framebuffer.active_fb == 0 ? (framebuffer.address_right1)
+                                                      : (framebuffer.address_right2);
+    }
+    if (framebuffer_addr == 0) {
+        framebuffer_addr =
+            framebuffer.active_fb == 0 ? (framebuffer.address_left1) : (framebuffer.address_left2);
+    }
+
+    LOG_TRACE(Render_Software, "0x%08x bytes from 0x%08x(%dx%d), fmt %x",
+              framebuffer.stride * framebuffer.height, framebuffer_addr, (int)framebuffer.width,
+              (int)framebuffer.height, (int)framebuffer.format);
+
+    const u32 fb_width = framebuffer.width;
+    const u32 fb_height = framebuffer.height;
+    image.width = fb_height;
+    image.height = fb_width;
+    image.pixels.assign(fb_width * fb_height, PackXRGB(0, 0, 0));
+
+    Memory::RasterizerFlushRegion(framebuffer_addr, framebuffer.stride * fb_height);
+
+    const u8* framebuffer_data = Memory::GetPhysicalPointer(framebuffer_addr);
+    if (framebuffer_data == nullptr) {
+        LOG_ERROR(Render_Software, "Framebuffer at invalid address 0x%08x", framebuffer_addr);
+        return;
+    }
+
+    const u32 bpp = GPU::Regs::BytesPerPixel(framebuffer.color_format);
+    const u32 stride = framebuffer.stride;
+    u32* pixels = image.pixels.data();
+
+    switch (framebuffer.color_format) {
+    case GPU::Regs::PixelFormat::RGBA8:
+        DecodeRotated<Color::DecodeRGBA8>(framebuffer_data, stride, bpp, fb_width, fb_height, pixels);
+        break;
+    case GPU::Regs::PixelFormat::RGB8:
+        DecodeRotated<Color::DecodeRGB8>(framebuffer_data, stride, bpp, fb_width, fb_height, pixels);
+        break;
+    case GPU::Regs::PixelFormat::RGB565:
+        DecodeRotated<Color::DecodeRGB565>(framebuffer_data, stride, bpp, fb_width, fb_height, pixels);
+        break;
+    case GPU::Regs::PixelFormat::RGB5A1:
+        DecodeRotated<Color::DecodeRGB5A1>(framebuffer_data, stride, bpp, fb_width, fb_height, pixels);
+        break;
+    case GPU::Regs::PixelFormat::RGBA4:
+        DecodeRotated<Color::DecodeRGBA4>(framebuffer_data, stride, bpp, fb_width, fb_height, pixels);
+        break;
+    default:
+        LOG_ERROR(Render_Software, "Unknown framebuffer format %x", static_cast<u32>(framebuffer.color_format.Value()));
+        break;
+    }
+}
+
+void RendererSoftware::DrawScreen(const ScreenImage& image,
+                                  const MathUtil::Rectangle<unsigned>& rect, u32 mask) {
+    const unsigned right = std::min(rect.right, frame_width);
+    const unsigned bottom = std::min(rect.bottom, frame_height);
+    if (image.pixels.empty() || rect.left >= right || rect.top >= bottom)
+        return;
+
+    const unsigned width = rect.GetWidth();
+    const unsigned height = rect.GetHeight();
+
+    // Source column of each destination column, shared by all rows
+    std::vector<u32> source_x(right - rect.left);
+    for (unsigned x = rect.left; x < right; ++x)
+        source_x[x - rect.left] = static_cast<u32>(u64(x - rect.left) * image.width / width);
+
+    for (unsigned y = rect.top; y < bottom; ++y) {
+        const u32* source =
+            image.pixels.data() + u64(y - rect.top) * image.height / height * image.width;
+        u32* dest = frame.data() + y * frame_width + rect.left;
+        for (u32 x : source_x) {
+            *dest = (*dest & ~mask) | (source[x] & mask);
+            ++dest;
+        }
+    }
+}
+
+/**
+ * Draws the emulated screens into the frame, following the window layout.
+ */
+void RendererSoftware::DrawScreens() {
+    const auto& layout = render_window->GetFramebufferLayout();
+
+    frame_width = layout.width;
+    frame_height = layout.height;
+    frame.assign(frame_width * frame_height,
+                 PackXRGB(static_cast<u8>(Settings::values.bg_red * 255),
+                          static_cast<u8>(Settings::values.bg_green * 255),
+                          static_cast<u8>(Settings::values.bg_blue * 255)));
+
+    const auto& top = layout.top_screen;
+    const auto& bottom = layout.bottom_screen;
+
+    switch (render_window->GetStereoscopicMode()) {
+    case EmuWindow::StereoscopicMode::LeftOnly:
+    case EmuWindow::StereoscopicMode::Anaglyph:
+        DrawScreen(screen_images[0], top, MASK_LEFT);
+        DrawScreen(screen_images[1], top, MASK_RIGHT);
+        DrawScreen(screen_images[2], bottom, MASK_ALL);
+        break;
+    case EmuWindow::StereoscopicMode::RightOnly:
+        DrawScreen(screen_images[1], top, MASK_LEFT);
+        DrawScreen(screen_images[0], top, MASK_RIGHT);
+        DrawScreen(screen_images[2], bottom, MASK_ALL);
+        break;
+    case EmuWindow::StereoscopicMode::SideBySide: {
+        // Each eye gets a copy of both screens, shrunk horizontally, as done by RendererOpenGL
+        const unsigned offset = frame_width / 3;
+        for (unsigned copy = 0; copy < 2; ++copy) {
+            const unsigned top_left = top.left * 2 / 3 + copy * offset;
+            const unsigned bottom_left = bottom.left * 2 / 3 + copy * offset;
+            const MathUtil::Rectangle<unsigned> top_rect(top_left, top.top,
+                                                         top_left + top.GetWidth() * 2 / 3, top.bottom);
+            const MathUtil::Rectangle<unsigned> bottom_rect(
+                bottom_left, bottom.top, bottom_left + bottom.GetWidth() * 2 / 3, bottom.bottom);
+            DrawScreen(screen_images[copy], top_rect, MASK_LEFT);
+            DrawScreen(screen_images[1 - copy], top_rect, MASK_RIGHT);
+            DrawScreen(screen_images[2], bottom_rect, MASK_ALL);
+        }
+        break;
+    }
+    }
+
+    m_current_frame++;
+}
+
+/**
+ * Set the emulator window to use for renderer
+ * @param window EmuWindow handle to emulator window to use for rendering
+ */
+void RendererSoftware::SetWindow(EmuWindow* window) {
+    render_window = window;
+}
+
+/// Initialize the renderer
+bool RendererSoftware::Init() {
+    LOG_INFO(Render_Software, "Presenting frames without a graphics context");
+
+    RefreshRasterizerSetting();
+
+    return true;
+}
+
+/// Shutdown the renderer
+void RendererSoftware::ShutDown() {}
@@ -0,0 +1,74 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/math_util.h"
+
+#include "core/hw/gpu.h"
+
+#include "video_core/renderer_base.h"
+
+class EmuWindow;
+
+/**
+ * Renderer which composes the LCD framebuffers into a CPU image and hands it to the window through
+ * EmuWindow::PresentFrame. It never touches a graphics context, so emulation can run on hosts
+ * without an OpenGL driver. The software rasterizer is always used.
+ */
+class RendererSoftware : public RendererBase {
+public:
+
+    RendererSoftware();
+    ~RendererSoftware() override;
+
+    /// Swap buffers (render frame)
+    void SwapBuffers() override;
+
+    /**
+     * Set the emulator window to use for renderer
+     * @param window EmuWindow handle to emulator window to use for rendering
+     */
+    void SetWindow(EmuWindow* window) override;
+
+    /// Initialize the renderer
+    bool Init() override;
+
+    /// Shutdown the renderer
+    void ShutDown() override;
+
+private:
+    /// Contents of one LCD, in display orientation (the LCDs rotate their framebuffers by 90 degrees)
+    struct ScreenImage {
+        u32 width = 0;
+        u32 height = 0;
+        std::vector<u32> pixels; ///< XRGB8888, rows from top to bottom
+    };
+
+    // Loads the framebuffer or the color fill scanned out by an LCD into the given image
+    void LoadScreen(const GPU::Regs::FramebufferConfig& framebuffer, u32 color_fill_index,
+                    ScreenImage& image, bool right);
+
+    void DrawScreens();
+
+    /**
+     * Scales a screen image to the given rectangle of the frame with nearest neighbour sampling
+     * @param mask Channels of the frame written by this image, used for stereoscopic output
+     */
+    void DrawScreen(const ScreenImage& image, const MathUtil::Rectangle<unsigned>& rect, u32 mask);
+
+    EmuWindow*  render_window;                    ///< Handle to render window
+
+    /// Images of the top-left, top-right and bottom screens respectively
+    std::array<ScreenImage, 3> screen_images;
+
+    /// Composed window-sized frame, in XRGB8888
+    std::vector<u32> frame;
+    unsigned frame_width = 0;
+    unsigned frame_height = 0;
+};
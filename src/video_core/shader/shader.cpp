@@ -2,18 +2,32 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cinttypes>
 #include <cmath>
 #include <cstring>
+#include <list>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <boost/range/algorithm/fill.hpp>
 
 #include "common/bit_field.h"
+#include "common/file_util.h"
 #include "common/hash.h"
+#include "common/linear_disk_cache.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/string_util.h"
+
+#include "core/loader/ncch.h"
+#include "core/settings.h"
 
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -21,6 +35,7 @@
 #include "video_core/shader/shader_interpreter.h"
 
 #ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_batch_x64.h"
 #include "video_core/shader/shader_jit_x64.h"
 #endif // ARCHITECTURE_x86_64
 
@@ -82,31 +97,193 @@ OutputVertex OutputRegisters::ToVertex(const Regs::ShaderConfig& config) {
     return ret;
 }
 
+static u64 ComputeProgramHash(const ShaderSetup& setup) {
+    return Common::ComputeHash64(&setup.program_code, sizeof(setup.program_code)) ^
+           Common::ComputeHash64(&setup.swizzle_data, sizeof(setup.swizzle_data));
+}
+
 #ifdef ARCHITECTURE_x86_64
-static std::unordered_map<u64, std::shared_ptr<JitShader>> shader_map;
+/**
+ * Maximum number of compiled shaders to keep around. Every JitShader reserves MAX_SHADER_SIZE
+ * bytes of code space, so the memory budget translates directly into a number of entries. Both
+ * the vertex and the geometry shader need to stay alive for the current draw.
+ */
+static size_t GetCacheCapacity() {
+    return std::max<size_t>(2,
+        static_cast<size_t>(Settings::values.shader_cache_size) * 1024 * 1024 / MAX_SHADER_SIZE);
+}
+
+/**
+ * Compiled shaders, evicting the least recently used one when exceeding the memory budget.
+ */
+class JitShaderCache {
+public:
+    std::shared_ptr<JitShader> Get(u64 key) {
+        auto iter = shader_map.find(key);
+        if (iter == shader_map.end())
+            return nullptr;
+
+        lru_list.splice(lru_list.begin(), lru_list, iter->second.lru_position);
+        return iter->second.shader;
+    }
+
+    void Insert(u64 key, std::shared_ptr<JitShader> shader) {
+        const size_t capacity = GetCacheCapacity();
+        while (shader_map.size() >= capacity) {
+            shader_map.erase(lru_list.back());
+            lru_list.pop_back();
+        }
+
+        lru_list.push_front(key);
+        shader_map[key] = { std::move(shader), lru_list.begin() };
+    }
+
+    void Clear() {
+        shader_map.clear();
+        lru_list.clear();
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<JitShader> shader;
+        std::list<u64>::iterator lru_position;
+    };
+
+    std::unordered_map<u64, Entry> shader_map;
+    std::list<u64> lru_list; ///< Most recently used key first
+};
+
+static JitShaderCache shader_cache;
+
+/// Value type of the disk cache: program_code followed by swizzle_data
+using DiskCacheProgram = std::array<u32, 2 * 1024>;
+
+/**
+ * Record of the shader programs seen by the current title, stored in the user's shader_cache
+ * directory. It's read when the first shader gets setup after boot, and all recorded programs are
+ * compiled upfront so that the JIT doesn't cause stutter whenever a game uses a shader for the
+ * first time.
+ */
+class ShaderDiskCache : public LinearDiskCacheReader<u64, u32> {
+public:
+    void Open() {
+        opened = true;
+
+        if (!Settings::values.use_shader_disk_cache || Loader::program_id == 0)
+            return;
+
+        const std::string dir = FileUtil::GetUserPath(D_SHADERCACHE_IDX);
+        if (!FileUtil::CreateFullPath(dir)) {
+            LOG_ERROR(HW_GPU, "Failed to create shader cache directory %s", dir.c_str());
+            return;
+        }
+
+        const std::string filename =
+            dir + Common::StringFromFormat("%016" PRIX64 ".pica", static_cast<u64>(Loader::program_id));
+        file.OpenAndRead(filename.c_str(), *this);
+        enabled = true;
+
+        LOG_INFO(HW_GPU, "Loaded %zu shader programs from %s", loaded_programs.size(), filename.c_str());
+    }
+
+    void Read(const u64& key, const u32* value, u32 value_size) override {
+        if (value_size != std::tuple_size<DiskCacheProgram>::value || !recorded_keys.insert(key).second)
+            return;
+
+        loaded_programs.emplace_back();
+        std::copy(value, value + value_size, loaded_programs.back().begin());
+    }
+
+    /// Returns the programs read from disk which haven't been taken yet
+    std::vector<DiskCacheProgram> TakeLoadedPrograms() {
+        return std::move(loaded_programs);
+    }
+
+    void Record(u64 key, const ShaderSetup& setup) {
+        if (!enabled || !recorded_keys.insert(key).second)
+            return;
+
+        DiskCacheProgram program;
+        auto it = std::copy(setup.program_code.begin(), setup.program_code.end(), program.begin());
+        std::copy(setup.swizzle_data.begin(), setup.swizzle_data.end(), it);
+        file.Append(key, program.data(), static_cast<u32>(program.size()));
+        file.Sync();
+    }
+
+    void Close() {
+        file.Close();
+        recorded_keys.clear();
+        loaded_programs.clear();
+        opened = false;
+        enabled = false;
+    }
+
+    bool IsOpen() const {
+        return opened;
+    }
+
+private:
+    LinearDiskCache<u64, u32> file;
+    std::unordered_set<u64> recorded_keys;
+    std::vector<DiskCacheProgram> loaded_programs;
+    bool opened = false;
+    bool enabled = false;
+};
+
+static ShaderDiskCache disk_cache;
+
+static void PrecompileDiskCache() {
+    std::vector<DiskCacheProgram> programs = disk_cache.TakeLoadedPrograms();
+    if (programs.empty())
+        return;
+
+    // Programs beyond the cache budget would only get evicted again, so skip the oldest ones
+    const size_t capacity = GetCacheCapacity();
+    const size_t first = programs.size() > capacity ? programs.size() - capacity : 0;
+
+    auto setup = std::make_unique<ShaderSetup>();
+    for (size_t i = first; i < programs.size(); ++i) {
+        auto it = programs[i].begin();
+        std::copy(it, it + setup->program_code.size(), setup->program_code.begin());
+        std::copy(it + setup->program_code.size(), programs[i].end(), setup->swizzle_data.begin());
+
+        auto shader = std::make_shared<JitShader>();
+        shader->Compile(*setup);
+        shader_cache.Insert(ComputeProgramHash(*setup), std::move(shader));
+    }
+
+    LOG_INFO(HW_GPU, "Precompiled %zu shader programs", programs.size() - first);
+}
 #endif // ARCHITECTURE_x86_64
 
 void ClearCache() {
 #ifdef ARCHITECTURE_x86_64
-    shader_map.clear();
+    shader_cache.Clear();
+    disk_cache.Close();
 #endif // ARCHITECTURE_x86_64
 }
 
 void ShaderSetup::Setup() {
 #ifdef ARCHITECTURE_x86_64
     if (VideoCore::g_shader_jit_enabled) {
-        u64 cache_key = (Common::ComputeHash64(&program_code, sizeof(program_code)) ^
-            Common::ComputeHash64(&swizzle_data, sizeof(swizzle_data)));
+        if (!disk_cache.IsOpen()) {
+            disk_cache.Open();
+            PrecompileDiskCache();
+        }
 
-        auto iter = shader_map.find(cache_key);
-        if (iter != shader_map.end()) {
-            jit_shader = iter->second;
-        } else {
-            auto shader = std::make_shared<JitShader>();
+        if (!program_hash_valid) {
+            program_hash = ComputeProgramHash(*this);
+            program_hash_valid = true;
+        }
+
+        auto shader = shader_cache.Get(program_hash);
+        if (!shader) {
+            shader = std::make_shared<JitShader>();
             shader->Compile(*this);
-            jit_shader = shader;
-            shader_map[cache_key] = std::move(shader);
+            shader_cache.Insert(program_hash, shader);
+            disk_cache.Record(program_hash, *this);
         }
+        jit_shader = shader;
     } else {
         jit_shader.reset();
     }
@@ -142,6 +319,108 @@ void ShaderSetup::Run(UnitState<false>& state, const InputVertex& input, int num
 
 }
 
+void ShaderSetup::RunBatch(UnitState<false>& state, BatchUnitState& batch_state, const InputVertex* inputs, unsigned count,
+                           int num_attributes, const Regs::ShaderConfig& config, OutputRegisters* outputs) {
+    ASSERT(count <= MAX_BATCH_SIZE);
+
+    const auto& attribute_register_map = config.input_register_map;
+
+    // Vertices left to be run on their own
+    unsigned scalar = (1u << count) - 1;
+
+#ifdef ARCHITECTURE_x86_64
+    // Compiled shaders are faster per vertex than interpreting the whole batch. Running them back to
+    // back still saves looking up the shader and profiling every vertex on its own.
+    if (auto shader = jit_shader.lock()) {
+        MICROPROFILE_SCOPE(GPU_Shader);
+
+        for (unsigned vertex = 0; vertex < count; ++vertex) {
+            for (int i = 0; i < num_attributes; ++i)
+                state.registers.input[attribute_register_map.GetRegisterForAttribute(i)] = inputs[vertex].attr[i];
+
+            state.conditional_code[0] = false;
+            state.conditional_code[1] = false;
+
+            shader->Run(*this, state, config.main_offset);
+            outputs[vertex] = state.output_registers;
+        }
+        return;
+    }
+
+    if (count > 1) {
+        MICROPROFILE_SCOPE(GPU_Shader);
+
+        static const BatchInterpreterFunc run_batch = GetBatchInterpreterFunc();
+
+        // Registers which are not written by the shader keep their values from the previous vertex
+        // on the shader unit. Start every vertex of the batch from the registers of the unit, and
+        // hand those of the last vertex back afterwards. Unlike when running the vertices one after
+        // another, a vertex reading a register before writing it hence sees the value from before
+        // the batch rather than the one left by the previous vertex of the batch.
+        for (unsigned reg = 0; reg < 16; ++reg) {
+            for (unsigned comp = 0; comp < 4; ++comp) {
+                std::fill_n(batch_state.registers.input[reg][comp], count,
+                            state.registers.input[reg][comp].ToFloat32());
+                std::fill_n(batch_state.registers.temporary[reg][comp], count,
+                            state.registers.temporary[reg][comp].ToFloat32());
+                std::fill_n(batch_state.registers.output[reg][comp], count,
+                            state.output_registers.value[reg][comp].ToFloat32());
+            }
+        }
+
+        for (unsigned vertex = 0; vertex < count; ++vertex) {
+            for (int i = 0; i < num_attributes; ++i) {
+                auto& reg = batch_state.registers.input[attribute_register_map.GetRegisterForAttribute(i)];
+                for (unsigned comp = 0; comp < 4; ++comp)
+                    reg[comp][vertex] = inputs[vertex].attr[i][comp].ToFloat32();
+            }
+
+            for (unsigned i = 0; i < 3; ++i)
+                batch_state.address_registers[i][vertex] = state.address_registers[i];
+        }
+
+        scalar = run_batch(*this, batch_state, count, config.main_offset);
+
+        int last_vertex = -1;
+        for (unsigned vertex = 0; vertex < count; ++vertex) {
+            if (scalar & (1 << vertex))
+                continue;
+
+            for (unsigned reg = 0; reg < 16; ++reg) {
+                for (unsigned comp = 0; comp < 4; ++comp) {
+                    outputs[vertex].value[reg][comp] =
+                        float24::FromFloat32(batch_state.registers.output[reg][comp][vertex]);
+                }
+            }
+            last_vertex = vertex;
+        }
+
+        if (last_vertex >= 0) {
+            for (unsigned reg = 0; reg < 16; ++reg) {
+                for (unsigned comp = 0; comp < 4; ++comp) {
+                    state.registers.input[reg][comp] =
+                        float24::FromFloat32(batch_state.registers.input[reg][comp][last_vertex]);
+                    state.registers.temporary[reg][comp] =
+                        float24::FromFloat32(batch_state.registers.temporary[reg][comp][last_vertex]);
+                }
+            }
+            state.output_registers = outputs[last_vertex];
+
+            for (unsigned i = 0; i < 3; ++i)
+                state.address_registers[i] = batch_state.address_registers[i][last_vertex];
+        }
+    }
+#endif // ARCHITECTURE_x86_64
+
+    for (unsigned vertex = 0; vertex < count; ++vertex) {
+        if ((scalar & (1 << vertex)) == 0)
+            continue;
+
+        Run(state, inputs[vertex], num_attributes, config);
+        outputs[vertex] = state.output_registers;
+    }
+}
+
 DebugData<true> ShaderSetup::ProduceDebugInfo(const InputVertex& input, int num_attributes, const Regs::ShaderConfig& config) {
     UnitState<true> state;
 
@@ -300,6 +579,7 @@ void WriteProgramCode(bool gs, u32 value) {
         LOG_ERROR(HW_GPU, "Invalid %s program offset %d", shader_type, (int)config.program.offset);
     } else {
         setup.program_code[config.program.offset] = value;
+        setup.MarkProgramDirty();
         config.program.offset++;
     }
 
@@ -328,6 +608,7 @@ void WriteSwizzlePatterns(bool gs, u32 value) {
         LOG_ERROR(HW_GPU, "Invalid %s swizzle pattern offset %d", shader_type, (int)config.swizzle_patterns.offset);
     } else {
         setup.swizzle_data[config.swizzle_patterns.offset] = value;
+        setup.MarkProgramDirty();
         config.swizzle_patterns.offset++;
     }
 
@@ -339,7 +620,6 @@ void WriteSwizzlePatterns(bool gs, u32 value) {
 
 template<bool Debug>
 void HandleEMIT(UnitState<Debug>& state) {
-    auto &config = g_state.regs.gs;
     auto &emit_params = state.emit_params;
     auto &emit_buffers = state.emit_buffers;
 
@@ -348,21 +628,38 @@ void HandleEMIT(UnitState<Debug>& state) {
     emit_buffers[emit_params.vertex_id] = state.output_registers;
 
     if (emit_params.primitive_emit) {
-        ASSERT_MSG(state.emit_triangle_callback, "EMIT invoked but no handler set!");
-        OutputVertex v0 = emit_buffers[0].ToVertex(config);
-        OutputVertex v1 = emit_buffers[1].ToVertex(config);
-        OutputVertex v2 = emit_buffers[2].ToVertex(config);
-        if (emit_params.winding) {
-            state.emit_triangle_callback(v2, v1, v0);
-        } else {
-            state.emit_triangle_callback(v0, v1, v2);
-        }
+        if (state.num_emitted_vertices + 3 > MAX_EMITTED_VERTICES)
+            FlushEmittedTriangles(state);
+
+        OutputRegisters* triangle = &state.emitted_vertices[state.num_emitted_vertices];
+        triangle[0] = emit_buffers[emit_params.winding ? 2 : 0];
+        triangle[1] = emit_buffers[1];
+        triangle[2] = emit_buffers[emit_params.winding ? 0 : 2];
+        state.num_emitted_vertices += 3;
     }
 }
 
+template<bool Debug>
+void FlushEmittedTriangles(UnitState<Debug>& state) {
+    if (state.num_emitted_vertices == 0)
+        return;
+
+    ASSERT_MSG(state.emit_triangles_callback, "EMIT invoked but no handler set!");
+
+    auto &config = g_state.regs.gs;
+    std::array<OutputVertex, MAX_EMITTED_VERTICES> vertices;
+    for (unsigned i = 0; i < state.num_emitted_vertices; ++i)
+        vertices[i] = state.emitted_vertices[i].ToVertex(config);
+
+    state.emit_triangles_callback(vertices.data(), state.num_emitted_vertices / 3);
+    state.num_emitted_vertices = 0;
+}
+
 // Explicit instantiation
 template void HandleEMIT(UnitState<false>& state);
 template void HandleEMIT(UnitState<true>& state);
+template void FlushEmittedTriangles(UnitState<false>& state);
+template void FlushEmittedTriangles(UnitState<true>& state);
 
 } // namespace Shader
 
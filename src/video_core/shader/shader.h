@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -99,6 +100,9 @@ struct OutputRegisters {
 };
 static_assert(std::is_pod<OutputRegisters>::value, "Structure is not POD");
 
+/// Number of vertices of geometry shader triangles buffered before they are passed on (32 triangles)
+constexpr unsigned MAX_EMITTED_VERTICES = 32 * 3;
+
 // Helper structure used to keep track of data useful for inspection of shader emulation
 template<bool full_debugging>
 struct DebugData;
@@ -295,7 +299,12 @@ struct UnitState {
         BitField<24, 2, u32> vertex_id;
     } emit_params;
 
-    PrimitiveAssembler<OutputVertex>::TriangleHandler emit_triangle_callback;
+    // Vertices of the triangles emitted since the last flush, three per triangle in drawing order
+    OutputRegisters emitted_vertices[MAX_EMITTED_VERTICES];
+    u32 num_emitted_vertices = 0;
+
+    /// Receives the buffered triangles when they are flushed
+    std::function<void(const OutputVertex* vertices, size_t num_triangles)> emit_triangles_callback;
 
     OutputRegisters output_registers;
 
@@ -338,6 +347,37 @@ struct UnitState {
     static size_t EmitParamsOffset() {
         return offsetof(UnitState, emit_params.raw);
     }
+
+    static size_t EmitBuffersOffset() {
+        return offsetof(UnitState, emit_buffers);
+    }
+
+    static size_t EmittedVerticesOffset() {
+        return offsetof(UnitState, emitted_vertices);
+    }
+
+    static size_t NumEmittedVerticesOffset() {
+        return offsetof(UnitState, num_emitted_vertices);
+    }
+};
+
+/// Maximum number of vertices shaded together by ShaderSetup::RunBatch
+constexpr unsigned MAX_BATCH_SIZE = 8;
+
+/**
+ * Shader unit state for shading a batch of vertices at once. Registers are stored per component,
+ * with the values of all vertices of the batch next to each other, so that a single SIMD operation
+ * processes the same register component of several vertices.
+ */
+struct BatchUnitState {
+    struct Registers {
+        alignas(32) float input[16][4][MAX_BATCH_SIZE];
+        alignas(32) float temporary[16][4][MAX_BATCH_SIZE];
+        alignas(32) float output[16][4][MAX_BATCH_SIZE];
+    } registers;
+
+    // Two address registers and one loop counter for each vertex
+    s32 address_registers[3][MAX_BATCH_SIZE];
 };
 
 /// Clears the shader cache
@@ -377,10 +417,22 @@ struct ShaderSetup {
     std::array<u32, 1024> program_code;
     std::array<u32, 1024> swizzle_data;
 
+    /// Hash of program_code and swizzle_data, only valid while program_hash_valid is set
+    u64 program_hash;
+    bool program_hash_valid = false;
+
 #ifdef ARCHITECTURE_x86_64
     std::weak_ptr<const JitShader> jit_shader;
 #endif
 
+    /**
+     * Needs to be called after modifying program_code or swizzle_data, so that the next call to
+     * Setup picks up the new program.
+     */
+    void MarkProgramDirty() {
+        program_hash_valid = false;
+    }
+
     /**
      * Performs any shader setup that only needs to happen once per shader (as opposed to once per
      * vertex, which would happen within the `Run` function).
@@ -396,6 +448,20 @@ struct ShaderSetup {
      */
     void Run(UnitState<false>& state, const InputVertex& input, int num_attributes, const Regs::ShaderConfig& config);
 
+    /**
+     * Runs the currently setup shader on a batch of vertices
+     * @param state Shader unit state, which the vertices of the batch start out from and which holds
+     *              the registers of the last vertex shaded afterwards
+     * @param batch_state Scratch state holding the registers of all vertices of the batch
+     * @param inputs Input vertices into the shader
+     * @param count Number of vertices in the batch, at most MAX_BATCH_SIZE
+     * @param num_attributes The number of vertex shader attributes
+     * @param config Configuration object for the shader pipeline
+     * @param outputs Receives the output registers of each vertex of the batch
+     */
+    void RunBatch(UnitState<false>& state, BatchUnitState& batch_state, const InputVertex* inputs, unsigned count,
+                  int num_attributes, const Regs::ShaderConfig& config, OutputRegisters* outputs);
+
     /**
      * Produce debug information based on the given shader and input vertex
      * @param input Input vertex into the shader
@@ -422,6 +488,10 @@ void WriteSwizzlePatterns(bool gs, u32 value);
 template<bool Debug>
 void HandleEMIT(UnitState<Debug>& state);
 
+/// Passes the triangles buffered by EMIT on to the emit_triangles_callback of the shader unit
+template<bool Debug>
+void FlushEmittedTriangles(UnitState<Debug>& state);
+
 } // namespace Shader
 
 } // namespace Pica
@@ -0,0 +1,744 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+#include <boost/container/static_vector.hpp>
+
+#include <nihstro/shader_bytecode.h>
+
+#include "common/assert.h"
+#include "common/bit_set.h"
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/target_attributes.h"
+
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_batch_x64.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+// The interpreter below is a template over the SIMD operations, which is force-inlined into one
+// entry point per instruction set. Only the AVX2 operations and entry point are compiled for AVX2,
+// so the AVX2 operations are passed around in AVX2 code only, whatever GCC warns about their ABI.
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace Pica {
+
+namespace Shader {
+
+static_assert(MAX_BATCH_SIZE == 8, "The batch interpreters process batches of up to eight vertices");
+
+/// SIMD operations processing four vertices
+struct SSE2Ops {
+    using Float = __m128;
+    static constexpr unsigned width = 4;
+
+    static Float Load(const float* src) { return _mm_loadu_ps(src); }
+    static void Store(float* dest, Float value) { _mm_storeu_ps(dest, value); }
+    static Float Set1(float value) { return _mm_set1_ps(value); }
+    static Float Zero() { return _mm_setzero_ps(); }
+
+    static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+    static Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+    static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+
+    static Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+    static Float AndNot(Float a, Float b) { return _mm_andnot_ps(a, b); }
+    static Float Or(Float a, Float b) { return _mm_or_ps(a, b); }
+    static Float Xor(Float a, Float b) { return _mm_xor_ps(a, b); }
+
+    static Float CmpEq(Float a, Float b) { return _mm_cmpeq_ps(a, b); }
+    static Float CmpNeq(Float a, Float b) { return _mm_cmpneq_ps(a, b); }
+    static Float CmpLt(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+    static Float CmpLe(Float a, Float b) { return _mm_cmple_ps(a, b); }
+    static Float CmpGt(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+    static Float CmpGe(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+    static Float CmpOrd(Float a, Float b) { return _mm_cmpord_ps(a, b); }
+
+    static unsigned MoveMask(Float mask) { return _mm_movemask_ps(mask); }
+
+    /// Expands a bit mask of vertices to a lane mask
+    static Float LaneMask(unsigned vertices) {
+        const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+        const __m128i bits = _mm_and_si128(_mm_set1_epi32(vertices), lane_bits);
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(bits, lane_bits));
+    }
+};
+
+/// SIMD operations processing eight vertices
+struct AVX2Ops {
+    using Float = __m256;
+    static constexpr unsigned width = 8;
+
+    TARGET_AVX2 static Float Load(const float* src) { return _mm256_loadu_ps(src); }
+    TARGET_AVX2 static void Store(float* dest, Float value) { _mm256_storeu_ps(dest, value); }
+    TARGET_AVX2 static Float Set1(float value) { return _mm256_set1_ps(value); }
+    TARGET_AVX2 static Float Zero() { return _mm256_setzero_ps(); }
+
+    TARGET_AVX2 static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    TARGET_AVX2 static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    TARGET_AVX2 static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+    TARGET_AVX2 static Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+    TARGET_AVX2 static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    TARGET_AVX2 static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+
+    TARGET_AVX2 static Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+    TARGET_AVX2 static Float AndNot(Float a, Float b) { return _mm256_andnot_ps(a, b); }
+    TARGET_AVX2 static Float Or(Float a, Float b) { return _mm256_or_ps(a, b); }
+    TARGET_AVX2 static Float Xor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+
+    TARGET_AVX2 static Float CmpEq(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    TARGET_AVX2 static Float CmpNeq(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    TARGET_AVX2 static Float CmpLt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    TARGET_AVX2 static Float CmpLe(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    TARGET_AVX2 static Float CmpGt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    TARGET_AVX2 static Float CmpGe(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    TARGET_AVX2 static Float CmpOrd(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_ORD_Q); }
+
+    TARGET_AVX2 static unsigned MoveMask(Float mask) { return _mm256_movemask_ps(mask); }
+
+    /// Expands a bit mask of vertices to a lane mask
+    TARGET_AVX2 static Float LaneMask(unsigned vertices) {
+        const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i bits = _mm256_and_si256(_mm256_set1_epi32(vertices), lane_bits);
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, lane_bits));
+    }
+};
+
+/// Multiplication following float24 semantics: zero times anything but NaN is +0, even for inf
+template <typename Ops>
+static FORCE_INLINE typename Ops::Float Mul24(typename Ops::Float a, typename Ops::Float b) {
+    const auto zero = Ops::Zero();
+    const auto a_zero = Ops::And(Ops::CmpEq(a, zero), Ops::CmpOrd(b, b));
+    const auto b_zero = Ops::And(Ops::CmpEq(b, zero), Ops::CmpOrd(a, a));
+    return Ops::AndNot(Ops::Or(a_zero, b_zero), Ops::Mul(a, b));
+}
+
+/// Applies a scalar function to each lane of the given value
+template <typename Ops, typename Function>
+static FORCE_INLINE typename Ops::Float PerLane(typename Ops::Float value, Function function) {
+    alignas(32) float lanes[Ops::width];
+    Ops::Store(lanes, value);
+    for (float& lane : lanes)
+        lane = function(lane);
+    return Ops::Load(lanes);
+}
+
+/// Value of one component of a source register for a single vertex of the batch
+static float LookupComponent(const ShaderSetup& setup, const BatchUnitState& state,
+                             const SourceRegister& source_reg, int component, unsigned vertex) {
+    switch (source_reg.GetRegisterType()) {
+    case RegisterType::Input:
+        return state.registers.input[source_reg.GetIndex()][component][vertex];
+
+    case RegisterType::Temporary:
+        return state.registers.temporary[source_reg.GetIndex()][component][vertex];
+
+    case RegisterType::FloatUniform:
+        return setup.uniforms.f[source_reg.GetIndex()][component].ToFloat32();
+
+    default:
+        return 0.0f;
+    }
+}
+
+/**
+ * Loads a swizzled and optionally negated source register for the vertices of the batch
+ * @param address_register Index of the address register to offset the source register by, or 0
+ */
+template <typename Ops>
+static FORCE_INLINE void LoadSource(const ShaderSetup& setup, const BatchUnitState& state,
+                                    unsigned first_vertex, unsigned active,
+                                    SourceRegister source_reg, unsigned address_register,
+                                    const int (&selectors)[4], bool negate,
+                                    typename Ops::Float (&out)[4]) {
+    // Relative addressing usually uses the same offset for all vertices, e.g. when indexing by
+    // the loop counter, in which case all vertices read the same register
+    bool uniform_offset = true;
+    int offset = 0;
+    if (address_register != 0) {
+        const s32* offsets = &state.address_registers[address_register - 1][first_vertex];
+        offset = offsets[Common::LeastSignificantSetBit(static_cast<u32>(active))];
+        for (unsigned vertex = 0; vertex < Ops::width; ++vertex) {
+            if ((active & (1 << vertex)) && offsets[vertex] != offset)
+                uniform_offset = false;
+        }
+    }
+
+    if (uniform_offset) {
+        const SourceRegister reg = source_reg + offset;
+        for (int i = 0; i < 4; ++i) {
+            switch (reg.GetRegisterType()) {
+            case RegisterType::Input:
+                out[i] = Ops::Load(&state.registers.input[reg.GetIndex()][selectors[i]][first_vertex]);
+                break;
+
+            case RegisterType::Temporary:
+                out[i] = Ops::Load(&state.registers.temporary[reg.GetIndex()][selectors[i]][first_vertex]);
+                break;
+
+            case RegisterType::FloatUniform:
+                out[i] = Ops::Set1(setup.uniforms.f[reg.GetIndex()][selectors[i]].ToFloat32());
+                break;
+
+            default:
+                out[i] = Ops::Zero();
+                break;
+            }
+        }
+    } else {
+        const s32* offsets = &state.address_registers[address_register - 1][first_vertex];
+        for (int i = 0; i < 4; ++i) {
+            alignas(32) float lanes[Ops::width];
+            for (unsigned vertex = 0; vertex < Ops::width; ++vertex) {
+                lanes[vertex] = LookupComponent(setup, state, source_reg + offsets[vertex],
+                                                selectors[i], first_vertex + vertex);
+            }
+            out[i] = Ops::Load(lanes);
+        }
+    }
+
+    if (negate) {
+        const auto sign = Ops::Set1(-0.0f);
+        for (auto& component : out)
+            component = Ops::Xor(component, sign);
+    }
+}
+
+/// Writes the enabled components of the destination register for the active vertices
+template <typename Ops, typename DestRegisterType>
+static FORCE_INLINE void StoreDest(BatchUnitState& state, unsigned first_vertex, unsigned active,
+                                   const DestRegisterType& dest_reg, const SwizzlePattern& swizzle,
+                                   const typename Ops::Float (&value)[4]) {
+    float (*dest)[MAX_BATCH_SIZE] =
+        (dest_reg < 0x10) ? state.registers.output[dest_reg.GetIndex()]
+                          : (dest_reg < 0x20) ? state.registers.temporary[dest_reg.GetIndex()]
+                                              : nullptr;
+    if (dest == nullptr)
+        return;
+
+    const bool all_active = (active == (1u << Ops::width) - 1);
+    const auto mask = Ops::LaneMask(active);
+    for (int i = 0; i < 4; ++i) {
+        if (!swizzle.DestComponentEnabled(i))
+            continue;
+
+        float* component = &dest[i][first_vertex];
+        if (all_active) {
+            Ops::Store(component, value[i]);
+        } else {
+            Ops::Store(component, Ops::Or(Ops::And(mask, value[i]),
+                                          Ops::AndNot(mask, Ops::Load(component))));
+        }
+    }
+}
+
+struct BatchCallStackElement {
+    u32 final_address;      // Address upon which we jump to return_address
+    u32 return_address;     // Where to jump when leaving scope
+    u8 repeat_counter;      // How often to repeat until this call stack element is removed
+    u8 loop_increment;      // Which value to add to the loop counter after an iteration
+    u32 loop_address;       // The address where we'll return to after each loop iteration
+    unsigned return_mask;   // Vertices to continue with when leaving scope
+    unsigned else_mask;     // Vertices taking the else branch of a divergent IFC
+    u32 else_final_address; // Address upon which the else branch is left
+};
+
+/**
+ * Runs the shader program for up to Ops::width vertices of the batch, starting at first_vertex.
+ * Instructions are executed for all active vertices at once. Conditional calls and branches
+ * taken by only some of the vertices narrow the active mask until they return, and the two
+ * branches of a divergent IFC are executed one after another.
+ * @param vertices Mask of the vertices to process, relative to first_vertex
+ * @return Mask of the vertices which need to be processed on their own
+ */
+template <typename Ops>
+static FORCE_INLINE unsigned RunBatch(const ShaderSetup& setup, BatchUnitState& state,
+                                      unsigned first_vertex, unsigned vertices, unsigned offset) {
+    using Float = typename Ops::Float;
+
+    // TODO: Is there a maximal size for this?
+    boost::container::static_vector<BatchCallStackElement, 16> call_stack;
+
+    u32 program_counter = offset;
+
+    unsigned alive = vertices;  // Vertices which did not reach END yet
+    unsigned active = vertices; // Vertices executing the current instruction
+    unsigned conditional_code[2] = { 0, 0 };
+
+    const auto& uniforms = setup.uniforms;
+    const auto& swizzle_data = setup.swizzle_data;
+    const auto& program_code = setup.program_code;
+
+    auto call = [&](u32 offset, u32 num_instructions, u32 return_offset,
+                    u8 repeat_count, u8 loop_increment, unsigned mask) {
+        // -1 to make sure when incrementing the PC we end up at the correct offset
+        program_counter = offset - 1;
+        ASSERT(call_stack.size() < call_stack.capacity());
+        call_stack.push_back({ offset + num_instructions, return_offset, repeat_count,
+                               loop_increment, offset, active, 0, 0 });
+        active = mask;
+    };
+
+    auto evaluate_condition = [&](Instruction::FlowControlType flow_control) -> unsigned {
+        const unsigned x = flow_control.refx ? conditional_code[0] : ~conditional_code[0];
+        const unsigned y = flow_control.refy ? conditional_code[1] : ~conditional_code[1];
+
+        switch (flow_control.op) {
+        case Instruction::FlowControlType::Or:
+            return (x | y) & active;
+
+        case Instruction::FlowControlType::And:
+            return (x & y) & active;
+
+        case Instruction::FlowControlType::JustX:
+            return x & active;
+
+        case Instruction::FlowControlType::JustY:
+            return y & active;
+        }
+        return 0;
+    };
+
+    // Jumps are only followed by all remaining vertices together, since vertices waiting for the
+    // current scope to be left might otherwise never resume
+    auto jump = [&](u32 dest_offset) {
+        if (active != alive)
+            return false;
+        program_counter = dest_offset - 1;
+        return true;
+    };
+
+    while (alive != 0) {
+        if (!call_stack.empty()) {
+            auto& top = call_stack.back();
+
+            // Scopes are also left once all of their vertices reached END
+            if (program_counter == top.final_address || active == 0) {
+                if ((top.else_mask & alive) != 0) {
+                    // The else branch of a divergent IFC starts where the if branch ends
+                    program_counter = top.final_address;
+                    top.final_address = top.else_final_address;
+                    active = top.else_mask & alive;
+                    top.else_mask = 0;
+                    continue;
+                }
+
+                if (active != 0) {
+                    for (unsigned vertex = 0; vertex < Ops::width; ++vertex) {
+                        if (active & (1 << vertex))
+                            state.address_registers[2][first_vertex + vertex] += top.loop_increment;
+                    }
+
+                    if (top.repeat_counter-- != 0) {
+                        program_counter = top.loop_address;
+                        continue;
+                    }
+                }
+
+                program_counter = top.return_address;
+                active = top.return_mask & alive;
+                call_stack.pop_back();
+                continue;
+            }
+        }
+
+        const Instruction instr = { program_code[program_counter] };
+        const SwizzlePattern swizzle = { swizzle_data[instr.common.operand_desc_id] };
+
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic: {
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+            const unsigned address_register = instr.common.address_register_index;
+
+            const int selectors1[4] = {
+                (int)swizzle.src1_selector_0.Value(), (int)swizzle.src1_selector_1.Value(),
+                (int)swizzle.src1_selector_2.Value(), (int)swizzle.src1_selector_3.Value(),
+            };
+            const int selectors2[4] = {
+                (int)swizzle.src2_selector_0.Value(), (int)swizzle.src2_selector_1.Value(),
+                (int)swizzle.src2_selector_2.Value(), (int)swizzle.src2_selector_3.Value(),
+            };
+
+            Float src1[4], src2[4], dest[4];
+            LoadSource<Ops>(setup, state, first_vertex, active, instr.common.GetSrc1(is_inverted),
+                            is_inverted ? 0 : address_register, selectors1, swizzle.negate_src1, src1);
+            LoadSource<Ops>(setup, state, first_vertex, active, instr.common.GetSrc2(is_inverted),
+                            is_inverted ? address_register : 0, selectors2, swizzle.negate_src2, src2);
+
+            switch (instr.opcode.Value().EffectiveOpCode()) {
+            case OpCode::Id::ADD:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Ops::Add(src1[i], src2[i]);
+                break;
+
+            case OpCode::Id::MUL:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Mul24<Ops>(src1[i], src2[i]);
+                break;
+
+            case OpCode::Id::FLR:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = PerLane<Ops>(src1[i], [](float value) { return std::floor(value); });
+                break;
+
+            case OpCode::Id::MAX:
+                // Same operand order as the interpreter, which matches the NaN semantics of the
+                // hardware: max(0, NaN) -> NaN, max(NaN, 0) -> 0
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Ops::Max(src1[i], src2[i]);
+                break;
+
+            case OpCode::Id::MIN:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Ops::Min(src1[i], src2[i]);
+                break;
+
+            case OpCode::Id::DP3:
+            case OpCode::Id::DP4:
+            case OpCode::Id::DPH:
+            case OpCode::Id::DPHI: {
+                OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+                if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
+                    src1[3] = Ops::Set1(1.0f);
+
+                int num_components = (opcode == OpCode::Id::DP3) ? 3 : 4;
+                Float dot = Ops::Zero();
+                for (int i = 0; i < num_components; ++i)
+                    dot = Ops::Add(dot, Mul24<Ops>(src1[i], src2[i]));
+
+                for (auto& component : dest)
+                    component = dot;
+                break;
+            }
+
+            case OpCode::Id::RCP: {
+                const Float rcp_res = Ops::Div(Ops::Set1(1.0f), src1[0]);
+                for (auto& component : dest)
+                    component = rcp_res;
+                break;
+            }
+
+            case OpCode::Id::RSQ: {
+                const Float rsq_res = Ops::Div(Ops::Set1(1.0f), Ops::Sqrt(src1[0]));
+                for (auto& component : dest)
+                    component = rsq_res;
+                break;
+            }
+
+            case OpCode::Id::MOVA: {
+                for (int i = 0; i < 2; ++i) {
+                    if (!swizzle.DestComponentEnabled(i))
+                        continue;
+
+                    alignas(32) float lanes[Ops::width];
+                    Ops::Store(lanes, src1[i]);
+                    for (unsigned vertex = 0; vertex < Ops::width; ++vertex) {
+                        // TODO: Figure out how the rounding is done on hardware
+                        if (active & (1 << vertex))
+                            state.address_registers[i][first_vertex + vertex] = static_cast<s32>(lanes[vertex]);
+                    }
+                }
+                break;
+            }
+
+            case OpCode::Id::MOV:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = src1[i];
+                break;
+
+            case OpCode::Id::SGE:
+            case OpCode::Id::SGEI:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Ops::And(Ops::CmpGe(src1[i], src2[i]), Ops::Set1(1.0f));
+                break;
+
+            case OpCode::Id::SLT:
+            case OpCode::Id::SLTI:
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Ops::And(Ops::CmpLt(src1[i], src2[i]), Ops::Set1(1.0f));
+                break;
+
+            case OpCode::Id::CMP:
+                for (int i = 0; i < 2; ++i) {
+                    auto compare_op = instr.common.compare_op;
+                    auto op = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
+
+                    Float result;
+                    switch (op) {
+                    case Instruction::Common::CompareOpType::Equal:
+                        result = Ops::CmpEq(src1[i], src2[i]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::NotEqual:
+                        result = Ops::CmpNeq(src1[i], src2[i]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::LessThan:
+                        result = Ops::CmpLt(src1[i], src2[i]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::LessEqual:
+                        result = Ops::CmpLe(src1[i], src2[i]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterThan:
+                        result = Ops::CmpGt(src1[i], src2[i]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterEqual:
+                        result = Ops::CmpGe(src1[i], src2[i]);
+                        break;
+
+                    default:
+                        LOG_ERROR(HW_GPU, "Unknown compare mode %x", static_cast<int>(op));
+                        continue;
+                    }
+
+                    conditional_code[i] = (conditional_code[i] & ~active) |
+                                          (Ops::MoveMask(result) & active);
+                }
+                break;
+
+            case OpCode::Id::EX2: {
+                // EX2 only takes first component exp2 and writes it to all dest components
+                const Float ex2_res = PerLane<Ops>(src1[0], [](float value) { return std::exp2(value); });
+                for (auto& component : dest)
+                    component = ex2_res;
+                break;
+            }
+
+            case OpCode::Id::LG2: {
+                // LG2 only takes the first component log2 and writes it to all dest components
+                const Float lg2_res = PerLane<Ops>(src1[0], [](float value) { return std::log2(value); });
+                for (auto& component : dest)
+                    component = lg2_res;
+                break;
+            }
+
+            default:
+                LOG_ERROR(HW_GPU, "Unhandled arithmetic instruction: 0x%02x (%s): 0x%08x",
+                          (int)instr.opcode.Value().EffectiveOpCode(),
+                          instr.opcode.Value().GetInfo().name, instr.hex);
+                break;
+            }
+
+            switch (instr.opcode.Value().EffectiveOpCode()) {
+            case OpCode::Id::ADD: case OpCode::Id::MUL: case OpCode::Id::FLR:
+            case OpCode::Id::MAX: case OpCode::Id::MIN:
+            case OpCode::Id::DP3: case OpCode::Id::DP4: case OpCode::Id::DPH: case OpCode::Id::DPHI:
+            case OpCode::Id::RCP: case OpCode::Id::RSQ: case OpCode::Id::MOV:
+            case OpCode::Id::SGE: case OpCode::Id::SGEI: case OpCode::Id::SLT: case OpCode::Id::SLTI:
+            case OpCode::Id::EX2: case OpCode::Id::LG2:
+                StoreDest<Ops>(state, first_vertex, active, instr.common.dest.Value(), swizzle, dest);
+                break;
+
+            default:
+                break;
+            }
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            if ((instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD) ||
+                (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
+                const SwizzlePattern& swizzle = *reinterpret_cast<const SwizzlePattern*>(
+                    &swizzle_data[instr.mad.operand_desc_id]);
+
+                bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+                const unsigned address_register = instr.mad.address_register_index;
+
+                const int selectors1[4] = {
+                    (int)swizzle.src1_selector_0.Value(), (int)swizzle.src1_selector_1.Value(),
+                    (int)swizzle.src1_selector_2.Value(), (int)swizzle.src1_selector_3.Value(),
+                };
+                const int selectors2[4] = {
+                    (int)swizzle.src2_selector_0.Value(), (int)swizzle.src2_selector_1.Value(),
+                    (int)swizzle.src2_selector_2.Value(), (int)swizzle.src2_selector_3.Value(),
+                };
+                const int selectors3[4] = {
+                    (int)swizzle.src3_selector_0.Value(), (int)swizzle.src3_selector_1.Value(),
+                    (int)swizzle.src3_selector_2.Value(), (int)swizzle.src3_selector_3.Value(),
+                };
+
+                Float src1[4], src2[4], src3[4], dest[4];
+                LoadSource<Ops>(setup, state, first_vertex, active, instr.mad.GetSrc1(is_inverted),
+                                0, selectors1, swizzle.negate_src1, src1);
+                LoadSource<Ops>(setup, state, first_vertex, active, instr.mad.GetSrc2(is_inverted),
+                                is_inverted ? 0 : address_register, selectors2, swizzle.negate_src2, src2);
+                LoadSource<Ops>(setup, state, first_vertex, active, instr.mad.GetSrc3(is_inverted),
+                                is_inverted ? address_register : 0, selectors3, swizzle.negate_src3, src3);
+
+                for (int i = 0; i < 4; ++i)
+                    dest[i] = Ops::Add(Mul24<Ops>(src1[i], src2[i]), src3[i]);
+
+                StoreDest<Ops>(state, first_vertex, active, instr.mad.dest.Value(), swizzle, dest);
+            } else {
+                LOG_ERROR(HW_GPU, "Unhandled multiply-add instruction: 0x%02x (%s): 0x%08x",
+                          (int)instr.opcode.Value().EffectiveOpCode(),
+                          instr.opcode.Value().GetInfo().name, instr.hex);
+            }
+            break;
+        }
+
+        default: {
+            // Handle each instruction on its own
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                alive &= ~active;
+                active = 0;
+                break;
+
+            case OpCode::Id::JMPC: {
+                const unsigned taken = evaluate_condition(instr.flow_control);
+                if (taken == active) {
+                    if (taken != 0 && !jump(instr.flow_control.dest_offset))
+                        return vertices;
+                } else if (taken != 0) {
+                    return vertices;
+                }
+                break;
+            }
+
+            case OpCode::Id::JMPU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id] ==
+                    !(instr.flow_control.num_instructions & 1)) {
+                    if (!jump(instr.flow_control.dest_offset))
+                        return vertices;
+                }
+                break;
+
+            case OpCode::Id::CALL:
+                call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                     program_counter + 1, 0, 0, active);
+                break;
+
+            case OpCode::Id::CALLU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0, active);
+                }
+                break;
+
+            case OpCode::Id::CALLC: {
+                const unsigned taken = evaluate_condition(instr.flow_control);
+                if (taken != 0) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0, taken);
+                }
+                break;
+            }
+
+            case OpCode::Id::NOP:
+                break;
+
+            case OpCode::Id::IFU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(program_counter + 1,
+                         instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0,
+                         active);
+                } else {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0,
+                         active);
+                }
+                break;
+
+            case OpCode::Id::IFC: {
+                const unsigned taken = evaluate_condition(instr.flow_control);
+                const unsigned not_taken = active & ~taken;
+                if (not_taken == 0) {
+                    call(program_counter + 1,
+                         instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0,
+                         active);
+                } else if (taken == 0) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0,
+                         active);
+                } else {
+                    // Run the if branch for the vertices taking it first, then the else branch
+                    call(program_counter + 1,
+                         instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0,
+                         taken);
+                    call_stack.back().else_mask = not_taken;
+                    call_stack.back().else_final_address =
+                        instr.flow_control.dest_offset + instr.flow_control.num_instructions;
+                }
+                break;
+            }
+
+            case OpCode::Id::LOOP: {
+                const auto& loop_param = uniforms.i[instr.flow_control.int_uniform_id];
+                for (unsigned vertex = 0; vertex < Ops::width; ++vertex) {
+                    if (active & (1 << vertex))
+                        state.address_registers[2][first_vertex + vertex] = loop_param.y;
+                }
+
+                call(program_counter + 1,
+                     instr.flow_control.dest_offset - program_counter + 1,
+                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z, active);
+                break;
+            }
+
+            default:
+                LOG_ERROR(HW_GPU, "Unhandled instruction: 0x%02x (%s): 0x%08x",
+                          (int)instr.opcode.Value().EffectiveOpCode(),
+                          instr.opcode.Value().GetInfo().name, instr.hex);
+                break;
+            }
+
+            break;
+        }
+        }
+
+        ++program_counter;
+    }
+
+    return 0;
+}
+
+unsigned RunBatchInterpreter_SSE2(const ShaderSetup& setup, BatchUnitState& state,
+                                  unsigned count, unsigned offset) {
+    unsigned fallback = 0;
+    for (unsigned first_vertex = 0; first_vertex < count; first_vertex += SSE2Ops::width) {
+        const unsigned vertices = (1u << std::min(count - first_vertex, 4u)) - 1;
+        fallback |= RunBatch<SSE2Ops>(setup, state, first_vertex, vertices, offset) << first_vertex;
+    }
+    return fallback;
+}
+
+TARGET_AVX2
+unsigned RunBatchInterpreter_AVX2(const ShaderSetup& setup, BatchUnitState& state,
+                                  unsigned count, unsigned offset) {
+    return RunBatch<AVX2Ops>(setup, state, 0, (1u << count) - 1, offset);
+}
+
+BatchInterpreterFunc GetBatchInterpreterFunc() {
+    if (Common::GetCPUCaps().avx2)
+        return RunBatchInterpreter_AVX2;
+    return RunBatchInterpreter_SSE2;
+}
+
+} // namespace Shader
+
+} // namespace Pica
@@ -0,0 +1,39 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+namespace Pica {
+
+namespace Shader {
+
+struct BatchUnitState;
+struct ShaderSetup;
+
+/**
+ * Interprets the shader program for all vertices of a batch at once, keeping divergent control
+ * flow apart with per-vertex execution masks. The input registers of the batch state need to be
+ * setup, and the output registers hold the results afterwards.
+ * @param count Number of vertices in the batch, at most MAX_BATCH_SIZE
+ * @param offset Entry point of the shader program
+ * @return Mask of vertices which could not be processed in the batch, e.g. because of a jump
+ *         taken by only some of the vertices. These need to be run on their own.
+ */
+using BatchInterpreterFunc = unsigned (*)(const ShaderSetup& setup, BatchUnitState& state,
+                                          unsigned count, unsigned offset);
+
+/// Processes the batch four vertices at a time
+unsigned RunBatchInterpreter_SSE2(const ShaderSetup& setup, BatchUnitState& state,
+                                  unsigned count, unsigned offset);
+
+/// Processes the batch eight vertices at a time
+unsigned RunBatchInterpreter_AVX2(const ShaderSetup& setup, BatchUnitState& state,
+                                  unsigned count, unsigned offset);
+
+/// Returns the widest batch interpreter supported by the host CPU
+BatchInterpreterFunc GetBatchInterpreterFunc();
+
+} // namespace Shader
+
+} // namespace Pica
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <xmmintrin.h>
 
@@ -733,10 +734,83 @@ static void Handle_EMIT(void* param1) {
 };
 
 void JitShader::Compile_EMIT(Instruction instr) {
+    // The emit routine returns zero in EAX if it buffered the vertex, otherwise the vertex is
+    // handled by HandleEMIT
+    emit_calls.push_back(CALL());
+    TEST(32, R(EAX), R(EAX));
+    FixupBranch done = J_CC(CC_Z);
+
     ABI_PushRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
     MOV(PTRBITS, R(ABI_PARAM1), R(STATE));
     ABI_CallFunctionR(reinterpret_cast<const void*>(Handle_EMIT), ABI_PARAM1);
     ABI_PopRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+
+    SetJumpTarget(done);
+}
+
+void JitShader::Compile_EmitRoutine() {
+    static_assert(sizeof(OutputRegisters) == 256, "OutputRegisters are indexed by shifting");
+
+    // Only the first 7 output registers are used by OutputRegisters::ToVertex
+    const int num_registers = 7;
+
+    const int output_registers = static_cast<int>(offsetof(UnitState<false>, output_registers));
+    const int emit_buffers = static_cast<int>(UnitState<false>::EmitBuffersOffset());
+    const int emitted_vertices = static_cast<int>(UnitState<false>::EmittedVerticesOffset());
+    const int num_emitted_vertices = static_cast<int>(UnitState<false>::NumEmittedVerticesOffset());
+
+    MOV(32, R(EAX), MDisp(STATE, UnitState<false>::EmitParamsOffset()));
+
+    // ECX = offset of emit_buffers[vertex_id]
+    MOV(32, R(ECX), R(EAX));
+    SHR(32, R(ECX), Imm8(24));
+    AND(32, R(ECX), Imm32(3));
+    CMP(32, R(ECX), Imm32(3));
+    FixupBranch invalid_vertex = J_CC(CC_E, true);
+    SHL(32, R(ECX), Imm8(8));
+
+    for (int i = 0; i < num_registers; ++i) {
+        MOVAPS(SCRATCH, MDisp(STATE, output_registers + i * 16));
+        MOVAPS(MComplex(STATE, RCX, SCALE_1, emit_buffers + i * 16), SCRATCH);
+    }
+
+    // Test emit_params.primitive_emit
+    TEST(32, R(EAX), Imm32(1 << 23));
+    FixupBranch no_primitive = J_CC(CC_Z, true);
+
+    // EDX = offset of the next triangle in emitted_vertices, if there is space for it
+    MOV(32, R(EDX), MDisp(STATE, num_emitted_vertices));
+    CMP(32, R(EDX), Imm32(MAX_EMITTED_VERTICES - 3));
+    FixupBranch buffer_full = J_CC(CC_A, true);
+    ADD(32, MDisp(STATE, num_emitted_vertices), Imm8(3));
+    SHL(32, R(EDX), Imm8(8));
+
+    // ECX and EBX = offsets of the first and last vertex, which emit_params.winding swaps
+    MOV(32, R(ECX), Imm32(0));
+    MOV(32, R(EBX), Imm32(2 * 256));
+    TEST(32, R(EAX), Imm32(1 << 22));
+    FixupBranch keep_winding = J_CC(CC_Z);
+    MOV(32, R(ECX), Imm32(2 * 256));
+    MOV(32, R(EBX), Imm32(0));
+    SetJumpTarget(keep_winding);
+
+    for (int i = 0; i < num_registers; ++i) {
+        MOVAPS(SCRATCH, MComplex(STATE, RCX, SCALE_1, emit_buffers + i * 16));
+        MOVAPS(MComplex(STATE, RDX, SCALE_1, emitted_vertices + i * 16), SCRATCH);
+        MOVAPS(SCRATCH, MDisp(STATE, emit_buffers + 256 + i * 16));
+        MOVAPS(MComplex(STATE, RDX, SCALE_1, emitted_vertices + 256 + i * 16), SCRATCH);
+        MOVAPS(SCRATCH, MComplex(STATE, RBX, SCALE_1, emit_buffers + i * 16));
+        MOVAPS(MComplex(STATE, RDX, SCALE_1, emitted_vertices + 512 + i * 16), SCRATCH);
+    }
+
+    SetJumpTarget(no_primitive);
+    XOR(32, R(EAX), R(EAX));
+    RET();
+
+    SetJumpTarget(invalid_vertex);
+    SetJumpTarget(buffer_full);
+    MOV(32, R(EAX), Imm32(1));
+    RET();
 }
 
 void JitShader::Compile_SETEMIT(Instruction instr) {
@@ -830,6 +904,7 @@ void JitShader::Compile(const ShaderSetup& setup) {
     looping = false;
     code_ptr.fill(nullptr);
     fixup_branches.clear();
+    emit_calls.clear();
 
     // Find all `CALL` instructions and identify return locations
     FindReturnOffsets();
@@ -866,11 +941,22 @@ void JitShader::Compile(const ShaderSetup& setup) {
         SetJumpTarget(branch.first, code_ptr[branch.second]);
     }
 
+    // Geometry shaders share a single routine for buffering emitted vertices
+    if (!emit_calls.empty()) {
+        const u8* emit_routine = GetCodePtr();
+        Compile_EmitRoutine();
+        for (const auto& call : emit_calls) {
+            SetJumpTarget(call, emit_routine);
+        }
+    }
+
     // Free memory that's no longer needed
     return_offsets.clear();
     return_offsets.shrink_to_fit();
     fixup_branches.clear();
     fixup_branches.shrink_to_fit();
+    emit_calls.clear();
+    emit_calls.shrink_to_fit();
 
     uintptr_t size = reinterpret_cast<uintptr_t>(GetCodePtr()) - reinterpret_cast<uintptr_t>(program);
     ASSERT_MSG(size <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
@@ -93,6 +93,13 @@ private:
      */
     void Compile_Return();
 
+    /**
+     * Emits the routine called by each `EMIT` instruction. It copies the output registers into the
+     * emit buffer selected by `SETEMIT`, and appends completed triangles to the emitted vertices
+     * of the shader unit. Returns a non-zero value if HandleEMIT has to be called instead.
+     */
+    void Compile_EmitRoutine();
+
     BitSet32 PersistentCallerSavedRegs();
 
     /**
@@ -130,6 +137,9 @@ private:
     /// Branches that need to be fixed up once the entire shader program is compiled
     std::vector<std::pair<Gen::FixupBranch, unsigned>> fixup_branches;
 
+    /// Calls to the emit routine, which is compiled after the shader program
+    std::vector<Gen::FixupBranch> emit_calls;
+
     using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
     CompiledShader* program = nullptr;
 
@@ -3,14 +3,76 @@
 // Refer to the license.txt file included.
 
 #include "video_core/clipper.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer.h"
+#include "video_core/shader/shader.h"
 #include "video_core/swrasterizer.h"
+#include "video_core/texture_cache.h"
 
 namespace VideoCore {
 
+/// Draws the queued triangles, which write straight to the framebuffer in emulated memory
+static void FlushTriangles() {
+    Pica::Rasterizer::FlushTriangles();
+
+    // Cached textures which are also used as render targets need to be decoded again
+    const auto& framebuffer = Pica::g_state.regs.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    Pica::TextureCache::InvalidateRegion(framebuffer.GetColorBufferPhysicalAddress(),
+        num_pixels * Pica::Regs::BytesPerColorPixel(framebuffer.color_format));
+    Pica::TextureCache::InvalidateRegion(framebuffer.GetDepthBufferPhysicalAddress(),
+        num_pixels * Pica::Regs::BytesPerDepthPixel(framebuffer.depth_format));
+}
+
+/**
+ * Number of live software rasterizers. A new rasterizer is created before the one it replaces is
+ * destroyed, so binning and the texture cache are only torn down along with the last one.
+ */
+static int num_instances = 0;
+
+SWRasterizer::SWRasterizer() {
+    if (num_instances++ == 0)
+        Pica::Rasterizer::SetTriangleBinning(true);
+}
+
+SWRasterizer::~SWRasterizer() {
+    if (--num_instances == 0) {
+        Pica::Rasterizer::SetTriangleBinning(false);
+        Pica::TextureCache::Clear();
+    } else {
+        // Triangles queued through this instance must still reach the framebuffer
+        FlushTriangles();
+    }
+}
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
         const Pica::Shader::OutputVertex& v1,
         const Pica::Shader::OutputVertex& v2) {
     Pica::Clipper::ProcessTriangle(v0, v1, v2);
 }
 
+void SWRasterizer::AddTriangles(const Pica::Shader::OutputVertex* vertices, size_t num_triangles) {
+    for (size_t i = 0; i < num_triangles; ++i, vertices += 3)
+        Pica::Clipper::ProcessTriangle(vertices[0], vertices[1], vertices[2]);
+}
+
+void SWRasterizer::DrawTriangles() {
+    // Like the hardware rasterizer, queued triangles are drawn using the state at this point
+    FlushTriangles();
+}
+
+void SWRasterizer::FlushAll() {
+    FlushTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+    Pica::TextureCache::InvalidateRegion(addr, size);
+}
+
 }
@@ -0,0 +1,134 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+
+#include "common/hash.h"
+#include "common/microprofile.h"
+
+#include "core/memory.h"
+
+#include "video_core/morton.h"
+#include "video_core/texture_cache.h"
+
+namespace Pica {
+
+namespace TextureCache {
+
+/// Once the decoded textures exceed this size, all textures not in use are dropped
+static const size_t MAX_CACHE_SIZE = 128 * 1024 * 1024;
+
+struct TextureKey {
+    PAddr address;
+    u32 width;
+    u32 height;
+    Regs::TextureFormat format;
+
+    bool operator==(const TextureKey& other) const {
+        return std::tie(address, width, height, format) ==
+               std::tie(other.address, other.width, other.height, other.format);
+    }
+};
+
+struct TextureKeyHash {
+    size_t operator()(const TextureKey& key) const {
+        return Common::ComputeHash64(&key, sizeof(key));
+    }
+};
+
+struct CacheEntry {
+    std::shared_ptr<CachedTexture> texture;
+    u32 size; ///< Size of the source data in bytes
+    u64 hash; ///< Hash of the source data the texture was decoded from
+    u32 verified_generation;
+};
+
+static std::unordered_map<TextureKey, CacheEntry, TextureKeyHash> cache;
+static size_t cache_size = 0;
+static u32 generation = 1;
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decoding", MP_RGB(100, 100, 255));
+
+static u32 GetTextureSize(unsigned width, unsigned height, Regs::TextureFormat format) {
+    switch (format) {
+    case Regs::TextureFormat::ETC1:
+        return width * height / 2;
+    case Regs::TextureFormat::ETC1A4:
+        return width * height;
+    default:
+        return width * height * Regs::NibblesPerPixel(format) / 2;
+    }
+}
+
+std::shared_ptr<const CachedTexture> GetTexture(const Regs::TextureConfig& config, Regs::TextureFormat format) {
+    const TextureKey key = { config.GetPhysicalAddress(), config.width, config.height, format };
+    const u8* source = Memory::GetPhysicalPointer(key.address);
+    if (source == nullptr || key.width == 0 || key.height == 0)
+        return nullptr;
+
+    auto iter = cache.find(key);
+    if (iter != cache.end()) {
+        CacheEntry& entry = iter->second;
+        if (entry.verified_generation == generation)
+            return entry.texture;
+
+        if (Common::ComputeHash64(source, entry.size) == entry.hash) {
+            entry.verified_generation = generation;
+            return entry.texture;
+        }
+
+        cache_size -= entry.texture->texels.size() * sizeof(Math::Vec4<u8>);
+        cache.erase(iter);
+    }
+
+    MICROPROFILE_SCOPE(GPU_TextureDecode);
+
+    if (cache_size > MAX_CACHE_SIZE) {
+        // Textures still bound by the rasterizer are kept alive by their references
+        cache.clear();
+        cache_size = 0;
+    }
+
+    auto texture = std::make_shared<CachedTexture>();
+    texture->width = key.width;
+    texture->height = key.height;
+    texture->texels.resize(key.width * key.height);
+    VideoCore::DecodeTexture(source, key.width, key.height, format, texture->texels.data(), key.width);
+
+    const u32 size = GetTextureSize(key.width, key.height, format);
+    cache_size += texture->texels.size() * sizeof(Math::Vec4<u8>);
+    cache[key] = { texture, size, Common::ComputeHash64(source, size), generation };
+    return texture;
+}
+
+void InvalidateRegion(PAddr addr, u32 size) {
+    for (auto iter = cache.begin(); iter != cache.end();) {
+        const PAddr start = iter->first.address;
+        if (start < addr + size && addr < start + iter->second.size) {
+            cache_size -= iter->second.texture->texels.size() * sizeof(Math::Vec4<u8>);
+            iter = cache.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void MarkAllUnverified() {
+    if (++generation == 0) {
+        for (auto& entry : cache)
+            entry.second.verified_generation = 0;
+        generation = 1;
+    }
+}
+
+void Clear() {
+    cache.clear();
+    cache_size = 0;
+}
+
+} // namespace TextureCache
+
+} // namespace Pica
@@ -0,0 +1,61 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#include "video_core/pica.h"
+
+namespace Pica {
+
+/**
+ * Cache of textures decoded to linear RGBA8, used by the software rasterizer so that texels don't
+ * need to be decoded from their tiled (and possibly ETC compressed) representation on every
+ * sample.
+ *
+ * Cached textures are dropped when their memory region gets flushed and invalidated. Since the CPU
+ * may also write to textures directly, each cached texture is rechecked against a hash of its
+ * source data the first time it's used by a new command list.
+ */
+namespace TextureCache {
+
+struct CachedTexture {
+    unsigned width;
+    unsigned height;
+
+    /// Texels from bottom to top, addressed like DebugUtils::LookupTexture
+    std::vector<Math::Vec4<u8>> texels;
+
+    const Math::Vec4<u8>& GetTexel(unsigned s, unsigned t) const {
+        return texels[t * width + s];
+    }
+};
+
+/**
+ * Returns the given texture decoded to RGBA8, decoding it if it isn't cached yet. The returned
+ * texture stays valid while it's referenced, even if the cache drops it.
+ * @return The decoded texture, or nullptr if the texture address is invalid
+ */
+std::shared_ptr<const CachedTexture> GetTexture(const Regs::TextureConfig& config, Regs::TextureFormat format);
+
+/// Drops all cached textures overlapping the given region
+void InvalidateRegion(PAddr addr, u32 size);
+
+/**
+ * Makes the next use of each cached texture compare its source data against the contents it was
+ * decoded from. Needs to be called whenever the CPU may have written to texture memory.
+ */
+void MarkAllUnverified();
+
+/// Drops all cached textures
+void Clear();
+
+} // namespace TextureCache
+
+} // namespace Pica
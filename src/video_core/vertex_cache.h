@@ -0,0 +1,65 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+
+#include "common/common_types.h"
+
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+/**
+ * Post-transform vertex cache, holding the vertex shader output of recently shaded vertices keyed
+ * by their vertex index. The cache is direct-mapped, so lookups and insertions are O(1).
+ *
+ * Entries stay valid across draws until Invalidate is called, which needs to happen whenever the
+ * vertex shader, its inputs or the vertex data may have changed. Invalidating the cache only bumps
+ * a generation counter and doesn't touch the entries.
+ */
+class VertexCache {
+public:
+    static constexpr size_t SIZE = 256;
+
+    /// Returns the cached output of the given vertex, or nullptr if it isn't cached
+    Shader::OutputRegisters* Lookup(u32 vertex) {
+        Entry& entry = entries[vertex % SIZE];
+        if (entry.vertex != vertex || entry.generation != generation)
+            return nullptr;
+
+        return &entry.output;
+    }
+
+    /// Stores the output of the given vertex, replacing whatever vertex used the same slot
+    void Insert(u32 vertex, const Shader::OutputRegisters& output) {
+        Entry& entry = entries[vertex % SIZE];
+        entry.vertex = vertex;
+        entry.generation = generation;
+        entry.output = output;
+    }
+
+    /// Discards all entries
+    void Invalidate() {
+        if (++generation == 0) {
+            // Make sure entries from before the wrap-around can't be mistaken for current ones
+            for (Entry& entry : entries)
+                entry.generation = 0;
+            generation = 1;
+        }
+    }
+
+private:
+    struct Entry {
+        u32 vertex = 0;
+        u32 generation = 0;
+        Shader::OutputRegisters output;
+    };
+
+    std::array<Entry, SIZE> entries;
+    u32 generation = 1; ///< Entries from any other generation are stale
+};
+
+} // namespace Pica
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <list>
 #include <memory>
+#include <unordered_map>
 
 #include <boost/range/algorithm/fill.hpp>
 
@@ -6,7 +9,9 @@
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/vector_math.h"
 
 #include "core/memory.h"
@@ -18,8 +23,88 @@
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/vertex_loader_jit_x64.h"
+#endif // ARCHITECTURE_x86_64
+
+#include "video_core/video_core.h"
+
 namespace Pica {
 
+#ifdef ARCHITECTURE_x86_64
+/**
+ * Maximum number of compiled vertex loaders to keep around, each taking MAX_VERTEX_LOADER_SIZE
+ * bytes of code space. Games only use a handful of layouts, so this is rarely reached.
+ */
+static const size_t MAX_CACHED_VERTEX_LOADERS = 256;
+
+/**
+ * Compiled vertex loaders, evicting the least recently used one when full. Only the loader of the
+ * draw being set up is in use at any time, so evicting the others is safe.
+ */
+class VertexLoaderJitCache {
+public:
+    const VertexLoaderJit* Get(u64 key) {
+        auto iter = loader_map.find(key);
+        if (iter == loader_map.end())
+            return nullptr;
+
+        lru_list.splice(lru_list.begin(), lru_list, iter->second.lru_position);
+        return iter->second.loader.get();
+    }
+
+    const VertexLoaderJit* Insert(u64 key, std::unique_ptr<VertexLoaderJit> loader) {
+        while (loader_map.size() >= MAX_CACHED_VERTEX_LOADERS) {
+            loader_map.erase(lru_list.back());
+            lru_list.pop_back();
+        }
+
+        lru_list.push_front(key);
+        const VertexLoaderJit* result = loader.get();
+        loader_map[key] = { std::move(loader), lru_list.begin() };
+        return result;
+    }
+
+    void Clear() {
+        loader_map.clear();
+        lru_list.clear();
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<VertexLoaderJit> loader;
+        std::list<u64>::iterator lru_position;
+    };
+
+    std::unordered_map<u64, Entry> loader_map;
+    std::list<u64> lru_list; ///< Most recently used key first
+};
+
+static VertexLoaderJitCache loader_cache;
+#endif // ARCHITECTURE_x86_64
+
+void VertexLoader::ClearCache() {
+#ifdef ARCHITECTURE_x86_64
+    loader_cache.Clear();
+#endif // ARCHITECTURE_x86_64
+}
+
+u64 VertexLoader::ComputeLayoutHash() const {
+    // Only the layout within the vertex records is hashed. Where the records are is passed to the
+    // compiled loader at run time, so that buffers at different offsets share the same loader.
+    std::array<u32, 16 * 6 + 1> layout;
+    auto it = layout.begin();
+    it = std::copy(vertex_attribute_loaders.begin(), vertex_attribute_loaders.end(), it);
+    it = std::copy(vertex_attribute_offsets.begin(), vertex_attribute_offsets.end(), it);
+    it = std::copy(vertex_attribute_strides.begin(), vertex_attribute_strides.end(), it);
+    it = std::transform(vertex_attribute_formats.begin(), vertex_attribute_formats.end(), it,
+                        [](Regs::VertexAttributeFormat format) { return static_cast<u32>(format); });
+    it = std::copy(vertex_attribute_elements.begin(), vertex_attribute_elements.end(), it);
+    it = std::copy(vertex_attribute_is_default.begin(), vertex_attribute_is_default.end(), it);
+    *it = static_cast<u32>(num_total_attributes);
+    return Common::ComputeHash64(layout.data(), sizeof(layout));
+}
+
 void VertexLoader::Setup(const Pica::Regs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -35,6 +120,7 @@ void VertexLoader::Setup(const Pica::Regs& regs) {
     // Setup attribute data from loaders
     for (int loader = 0; loader < 12; ++loader) {
         const auto& loader_config = attribute_config.attribute_loaders[loader];
+        loader_data_offsets[loader] = loader_config.data_offset;
 
         u32 offset = 0;
 
@@ -49,6 +135,8 @@ void VertexLoader::Setup(const Pica::Regs& regs) {
             if (attribute_index < 12) {
                 offset = Common::AlignUp(offset, attribute_config.GetElementSizeInBytes(attribute_index));
                 vertex_attribute_sources[attribute_index] = loader_config.data_offset + offset;
+                vertex_attribute_loaders[attribute_index] = loader;
+                vertex_attribute_offsets[attribute_index] = offset;
                 vertex_attribute_strides[attribute_index] = static_cast<u32>(loader_config.byte_count);
                 vertex_attribute_formats[attribute_index] = attribute_config.GetFormat(attribute_index);
                 vertex_attribute_elements[attribute_index] = attribute_config.GetNumElements(attribute_index);
@@ -64,11 +152,36 @@ void VertexLoader::Setup(const Pica::Regs& regs) {
     }
 
     is_setup = true;
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled) {
+        u64 cache_key = ComputeLayoutHash();
+
+        jit = loader_cache.Get(cache_key);
+        if (!jit) {
+            auto loader = std::make_unique<VertexLoaderJit>();
+            loader->Compile(*this);
+            jit = loader_cache.Insert(cache_key, std::move(loader));
+        }
+    }
+#endif // ARCHITECTURE_x86_64
 }
 
+MICROPROFILE_DEFINE(GPU_VertexLoad, "GPU", "Vertex Load", MP_RGB(255, 128, 0));
+
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses) {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+    MICROPROFILE_SCOPE(GPU_VertexLoad);
+
+#ifdef ARCHITECTURE_x86_64
+    // The compiled loader does not report memory accesses, so it is bypassed while recording
+    if (jit && !(g_debug_context && g_debug_context->recorder)) {
+        jit->Run(base_address, vertex, input, loader_data_offsets.data());
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
@@ -15,6 +15,10 @@ namespace Shader {
 struct InputVertex;
 }
 
+#ifdef ARCHITECTURE_x86_64
+class VertexLoaderJit;
+#endif // ARCHITECTURE_x86_64
+
 class VertexLoader {
 public:
     VertexLoader() = default;
@@ -27,14 +31,32 @@ public:
 
     int GetNumTotalAttributes() const { return num_total_attributes; }
 
+    /// Releases all vertex loaders compiled for previously seen attribute layouts
+    static void ClearCache();
+
 private:
+#ifdef ARCHITECTURE_x86_64
+    friend class VertexLoaderJit;
+#endif // ARCHITECTURE_x86_64
+
+    /// Computes a hash over the attribute layout, used to look up compiled vertex loaders
+    u64 ComputeLayoutHash() const;
+
     std::array<u32, 16> vertex_attribute_sources;
+    std::array<u32, 16> vertex_attribute_loaders{}; ///< Index of the loader each array attribute is read from
+    std::array<u32, 16> vertex_attribute_offsets{}; ///< Offset of each attribute within the vertex record of its loader
     std::array<u32, 16> vertex_attribute_strides{};
-    std::array<Regs::VertexAttributeFormat, 16> vertex_attribute_formats;
+    std::array<Regs::VertexAttributeFormat, 16> vertex_attribute_formats{};
     std::array<u32, 16> vertex_attribute_elements{};
     std::array<bool, 16> vertex_attribute_is_default;
+    std::array<u32, 12> loader_data_offsets{}; ///< Offset of the vertex records of each loader from the base address
     int num_total_attributes = 0;
     bool is_setup = false;
+
+#ifdef ARCHITECTURE_x86_64
+    /// Compiled loader for this attribute layout, owned by the cache
+    const VertexLoaderJit* jit = nullptr;
+#endif // ARCHITECTURE_x86_64
 };
 
 }  // namespace Pica
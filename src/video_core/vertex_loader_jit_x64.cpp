@@ -0,0 +1,225 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/x64/abi.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/emitter.h"
+
+#include "core/memory.h"
+
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+namespace Pica {
+
+using namespace Gen;
+
+/// Physical base address of the vertex arrays
+static const X64Reg BASE_ADDRESS = R12;
+/// Index of the vertex being loaded
+static const X64Reg VERTEX = R13;
+/// Pointer to the InputVertex being written
+static const X64Reg INPUT = R14;
+/// Pointer to the data offsets of the loaders
+static const X64Reg DATA_OFFSETS = R15;
+/// Host pointer to the vertex record currently being read
+static const X64Reg RECORD = RBX;
+/// Loaded with the attribute being converted
+static const X64Reg VALUE = XMM0;
+/// SIMD scratch register
+static const X64Reg SCRATCH = XMM1;
+
+/// Vertex records of one attribute loader, shared by all attributes loaded from it
+struct RecordGroup {
+    u32 loader;
+    u32 stride;
+    std::vector<int> attributes;
+};
+
+void VertexLoaderJit::Compile_LoadAttribute(const VertexLoader& loader, int attribute, u32 offset) {
+    const u32 elements = loader.vertex_attribute_elements[attribute];
+    const bool sse4_1 = Common::GetCPUCaps().sse4_1;
+
+    // Only the given number of elements is read, so that loading the last vertex of an array never
+    // touches memory past its end. All other lanes of VALUE are zeroed by the loads.
+    auto Source = [offset](u32 byte) { return MDisp(RECORD, static_cast<int>(offset + byte)); };
+
+    switch (loader.vertex_attribute_formats[attribute]) {
+    case Regs::VertexAttributeFormat::BYTE:
+    case Regs::VertexAttributeFormat::UBYTE:
+        switch (elements) {
+        case 1:
+            MOVZX(32, 8, EAX, Source(0));
+            break;
+        case 2:
+            MOVZX(32, 16, EAX, Source(0));
+            break;
+        case 3:
+            MOVZX(32, 16, EAX, Source(0));
+            MOVZX(32, 8, ECX, Source(2));
+            SHL(32, R(ECX), Imm8(16));
+            OR(32, R(EAX), R(ECX));
+            break;
+        default:
+            MOV(32, R(EAX), Source(0));
+            break;
+        }
+        MOVD_xmm(VALUE, R(EAX));
+
+        if (loader.vertex_attribute_formats[attribute] == Regs::VertexAttributeFormat::BYTE) {
+            if (sse4_1) {
+                PMOVSXBD(VALUE, R(VALUE));
+            } else {
+                // Replicate each byte into all bytes of its lane, then shift the copies back out
+                PUNPCKLBW(VALUE, R(VALUE));
+                PUNPCKLWD(VALUE, R(VALUE));
+                PSRAD(VALUE, 24);
+            }
+        } else {
+            if (sse4_1) {
+                PMOVZXBD(VALUE, R(VALUE));
+            } else {
+                PXOR(SCRATCH, R(SCRATCH));
+                PUNPCKLBW(VALUE, R(SCRATCH));
+                PUNPCKLWD(VALUE, R(SCRATCH));
+            }
+        }
+        CVTDQ2PS(VALUE, R(VALUE));
+        break;
+
+    case Regs::VertexAttributeFormat::SHORT:
+        switch (elements) {
+        case 1:
+            MOVZX(32, 16, EAX, Source(0));
+            MOVD_xmm(VALUE, R(EAX));
+            break;
+        case 2:
+            MOVD_xmm(VALUE, Source(0));
+            break;
+        case 3:
+            MOVD_xmm(VALUE, Source(0));
+            PINSRW(VALUE, Source(4), 2);
+            break;
+        default:
+            MOVQ_xmm(VALUE, Source(0));
+            break;
+        }
+
+        if (sse4_1) {
+            PMOVSXWD(VALUE, R(VALUE));
+        } else {
+            PUNPCKLWD(VALUE, R(VALUE));
+            PSRAD(VALUE, 16);
+        }
+        CVTDQ2PS(VALUE, R(VALUE));
+        break;
+
+    case Regs::VertexAttributeFormat::FLOAT:
+        switch (elements) {
+        case 1:
+            MOVSS(VALUE, Source(0));
+            break;
+        case 2:
+            MOVQ_xmm(VALUE, Source(0));
+            break;
+        case 3:
+            MOVQ_xmm(VALUE, Source(0));
+            MOVSS(SCRATCH, Source(8));
+            MOVLHPS(VALUE, SCRATCH);
+            break;
+        default:
+            MOVUPS(VALUE, Source(0));
+            break;
+        }
+        break;
+    }
+
+    // Components missing from the array default to (0, 0, 0, 1). The missing lanes hold +0.0 at
+    // this point, so setting w only needs to OR in the bits of 1.0.
+    if (elements < 4) {
+        static const __m128 w_one = { 0.f, 0.f, 0.f, 1.f };
+        MOV(PTRBITS, R(RAX), ImmPtr(&w_one));
+        ORPS(VALUE, MatR(RAX));
+    }
+
+    MOVAPS(MDisp(INPUT, attribute * sizeof(Math::Vec4<float24>)), VALUE);
+}
+
+void VertexLoaderJit::Compile_LoadDefaultAttribute(int attribute) {
+    // Read at run time, the default attributes may change between draws using the same layout
+    MOV(PTRBITS, R(RAX), ImmPtr(&g_state.vs_default_attributes[attribute]));
+    MOVUPS(VALUE, MatR(RAX));
+    MOVAPS(MDisp(INPUT, attribute * sizeof(Math::Vec4<float24>)), VALUE);
+}
+
+void VertexLoaderJit::Compile(const VertexLoader& loader) {
+    program = (CompiledLoader*)GetCodePtr();
+
+    // Attributes coming from the same loader are read through a single pointer lookup per vertex
+    std::vector<RecordGroup> groups;
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        if (loader.vertex_attribute_elements[i] == 0)
+            continue;
+
+        const u32 attribute_loader = loader.vertex_attribute_loaders[i];
+        const u32 stride = loader.vertex_attribute_strides[i];
+
+        auto group = std::find_if(groups.begin(), groups.end(), [&](const RecordGroup& group) {
+            return group.loader == attribute_loader;
+        });
+        if (group == groups.end())
+            group = groups.insert(groups.end(), { attribute_loader, stride, {} });
+        group->attributes.push_back(i);
+    }
+
+    // The stack pointer is 8 modulo 16 at the entry of a procedure
+    ABI_PushRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+
+    MOV(32, R(BASE_ADDRESS), R(ABI_PARAM1));
+    MOV(32, R(VERTEX), R(ABI_PARAM2));
+    MOV(PTRBITS, R(INPUT), R(ABI_PARAM3));
+    MOV(PTRBITS, R(DATA_OFFSETS), R(ABI_PARAM4));
+
+    for (const auto& group : groups) {
+        // RECORD = Memory::GetPhysicalPointer(base_address + data_offsets[loader] + stride * vertex)
+        IMUL(32, ABI_PARAM1, R(VERTEX), Imm32(group.stride));
+        ADD(32, R(ABI_PARAM1), R(BASE_ADDRESS));
+        ADD(32, R(ABI_PARAM1), MDisp(DATA_OFFSETS, static_cast<int>(group.loader * sizeof(u32))));
+        ABI_CallFunction(reinterpret_cast<const void*>(Memory::GetPhysicalPointer));
+        MOV(PTRBITS, R(RECORD), R(ABI_RETURN));
+
+        for (int attribute : group.attributes) {
+            Compile_LoadAttribute(loader, attribute, loader.vertex_attribute_offsets[attribute]);
+        }
+    }
+
+    for (int i = 0; i < loader.num_total_attributes; ++i) {
+        if (loader.vertex_attribute_elements[i] == 0 && loader.vertex_attribute_is_default[i])
+            Compile_LoadDefaultAttribute(i);
+    }
+
+    ABI_PopRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+    RET();
+
+    uintptr_t size = reinterpret_cast<uintptr_t>(GetCodePtr()) - reinterpret_cast<uintptr_t>(program);
+    ASSERT_MSG(size <= MAX_VERTEX_LOADER_SIZE, "Compiled a vertex loader that exceeds the allocated size!");
+
+    LOG_DEBUG(HW_GPU, "Compiled vertex loader size=%lu", size);
+}
+
+VertexLoaderJit::VertexLoaderJit() {
+    AllocCodeSpace(MAX_VERTEX_LOADER_SIZE);
+}
+
+} // namespace Pica
@@ -0,0 +1,56 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/common_types.h"
+#include "common/x64/emitter.h"
+
+namespace Pica {
+
+namespace Shader {
+struct InputVertex;
+}
+
+class VertexLoader;
+
+/// Memory allocated for each compiled vertex loader (4Kb)
+constexpr size_t MAX_VERTEX_LOADER_SIZE = 1024 * 4;
+
+/**
+ * This class compiles the attribute layout of a VertexLoader into x86_64 code, which fetches and
+ * converts all attributes of a vertex in one straight-line sequence without any per-attribute
+ * branching.
+ */
+class VertexLoaderJit : public Gen::XCodeBlock {
+public:
+    VertexLoaderJit();
+
+    /**
+     * Loads the attributes of a vertex.
+     * @param data_offsets Offset of the vertex records of each of the 12 loaders from base_address
+     */
+    void Run(u32 base_address, int vertex, Shader::InputVertex& input, const u32* data_offsets) const {
+        program(base_address, vertex, &input, data_offsets);
+    }
+
+    void Compile(const VertexLoader& loader);
+
+private:
+    /**
+     * Emits the code to load the given array attribute from the vertex record pointed to by the
+     * record pointer register and to store it to the input vertex.
+     * @param offset Offset of the attribute within the vertex record
+     */
+    void Compile_LoadAttribute(const VertexLoader& loader, int attribute, u32 offset);
+
+    void Compile_LoadDefaultAttribute(int attribute);
+
+    using CompiledLoader = void(u32 base_address, int vertex, void* input, const u32* data_offsets);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
@@ -5,11 +5,16 @@
 #include <memory>
 
 #include "common/logging/log.h"
+#include "common/thread_pool.h"
 
+#include "core/settings.h"
+
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/renderer_software/renderer_software.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Video Core namespace
@@ -24,13 +29,20 @@ std::atomic<bool> g_shader_jit_enabled;
 std::atomic<bool> g_scaled_resolution_enabled;
 std::atomic<bool> g_vsync_enabled;
 std::atomic<bool> g_is_rasterizer_dirty;
+std::atomic<bool> g_gpu_thread_enabled;
+
+static std::unique_ptr<Common::ThreadPool> thread_pool;
 
 /// Initialize the video core
 bool Init(EmuWindow* emu_window) {
     Pica::Init();
 
     g_emu_window = emu_window;
-    g_renderer = std::make_unique<RendererOpenGL>();
+    if (Settings::values.use_software_renderer) {
+        g_renderer = std::make_unique<RendererSoftware>();
+    } else {
+        g_renderer = std::make_unique<RendererOpenGL>();
+    }
     g_renderer->SetWindow(g_emu_window);
     if (g_renderer->Init()) {
         LOG_DEBUG(Render, "initialized OK");
@@ -38,16 +50,27 @@ bool Init(EmuWindow* emu_window) {
         LOG_ERROR(Render, "initialization failed !");
         return false;
     }
+    GPUThread::Init();
     return true;
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    GPUThread::Shutdown();
     Pica::Shutdown();
 
     g_renderer.reset();
 
+    // The renderer may still flush binned triangles on the pool while being destroyed
+    thread_pool.reset();
+
     LOG_DEBUG(Render, "shutdown OK");
 }
 
+Common::ThreadPool& GetThreadPool() {
+    if (!thread_pool)
+        thread_pool = std::make_unique<Common::ThreadPool>(Common::ThreadPool::DefaultNumWorkers(), "VideoCore");
+    return *thread_pool;
+}
+
 } // namespace
@@ -10,6 +10,10 @@
 class EmuWindow;
 class RendererBase;
 
+namespace Common {
+class ThreadPool;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Video Core namespace
 
@@ -38,6 +42,7 @@ extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
 extern std::atomic<bool> g_scaled_resolution_enabled;
 extern std::atomic<bool> g_is_rasterizer_dirty;
+extern std::atomic<bool> g_gpu_thread_enabled;
 
 /// Start the video core
 void Start();
@@ -48,4 +53,10 @@ bool Init(EmuWindow* emu_window);
 /// Shutdown the video core
 void Shutdown();
 
+/**
+ * Returns the worker threads shared by the software rasterizer and texture filtering, creating
+ * them on first use. Sharing them keeps the two from oversubscribing the host.
+ */
+Common::ThreadPool& GetThreadPool();
+
 } // namespace